@@ -1,2 +1,9 @@
 findphp:
 	@echo $(PHP_EXECUTABLE)
+
+# Run the benchmark suite against the extension just built, e.g. make bench BENCH_ARGS="--output=before.jsonl"
+bench: all
+	@$(PHP_EXECUTABLE) -d extension=$(phplibdir)/jsonpath.so -d jsonpath.cache_size=0 \
+		$(srcdir)/benchmarks/run.php $(BENCH_ARGS)
+
+.PHONY: bench
@@ -0,0 +1,63 @@
+<?php
+
+/*
+ * Compares two result files written by benchmarks/run.php, printing the ratio of every timing and memory column
+ * of the cases they have in common. Ratios above 1 are slower (or larger) in the second file:
+ *
+ *   php benchmarks/compare.php before.jsonl after.jsonl [--threshold=1.10]
+ *
+ * Exits with status 1 if any ratio is above the threshold, so it can gate a CI job.
+ */
+
+$args = array_values(array_filter(array_slice($argv, 1), fn($arg) => strpos($arg, '--') !== 0));
+$options = getopt('', ['threshold:']);
+$threshold = (float)($options['threshold'] ?? 1.10);
+
+if (count($args) !== 2) {
+    fwrite(STDERR, "Usage: php compare.php BEFORE AFTER [--threshold=1.10]\n");
+    exit(2);
+}
+
+function load(string $file): array
+{
+    $rows = [];
+    foreach (file($file, FILE_IGNORE_NEW_LINES | FILE_SKIP_EMPTY_LINES) as $line) {
+        $row = json_decode($line, true, 512, JSON_THROW_ON_ERROR);
+        $rows[$row["case"]] = $row;
+    }
+
+    return $rows;
+}
+
+$before = load($args[0]);
+$after = load($args[1]);
+$columns = ["compile_ns", "lex_ns", "parse_ns", "eval_ns", "eval_peak_bytes"];
+$regressions = 0;
+
+printf("%-64s" . str_repeat(" %15s", count($columns)) . "\n", "case", ...$columns);
+
+foreach ($before as $case => $old) {
+    if (!isset($after[$case])) {
+        continue;
+    }
+
+    $ratios = [];
+    foreach ($columns as $column) {
+        $a = $old[$column] ?? 0;
+        $b = $after[$case][$column] ?? -1;
+
+        if ($a <= 0 || $b < 0) {
+            $ratios[] = "-";
+            continue;
+        }
+
+        $ratio = $b / $a;
+        $flag = $ratio > $threshold ? "!" : " ";
+        $regressions += $ratio > $threshold ? 1 : 0;
+        $ratios[] = sprintf("%.2f%s", $ratio, $flag);
+    }
+
+    printf("%-64s" . str_repeat(" %15s", count($columns)) . "\n", substr($case, 0, 64), ...$ratios);
+}
+
+exit($regressions > 0 ? 1 : 0);
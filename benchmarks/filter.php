@@ -0,0 +1,72 @@
+<?php
+
+/*
+ * Measures filter expressions evaluated against every element of a large array.
+ *
+ * Filters are compiled once per query into register code whose constants are prebuilt, so
+ * evaluating a filter against an element doesn't allocate and the memory column only reflects
+ * the result array:
+ *
+ *   php -d extension=modules/jsonpath.so benchmarks/filter.php
+ */
+
+if (!extension_loaded('jsonpath')) {
+    fwrite(STDERR, "The jsonpath extension is not loaded\n");
+    exit(1);
+}
+
+const ITERATIONS = 5;
+
+function items(int $n): array
+{
+    $statuses = ["active", "inactive", "pending", "archived"];
+    $items = [];
+    for ($i = 0; $i < $n; $i++) {
+        $items[] = [
+            "id" => $i,
+            "status" => $statuses[$i % 4],
+            "price" => ($i % 1000) / 10,
+            "name" => "item $i",
+            "stock" => ["count" => $i % 50],
+        ];
+    }
+
+    return ["items" => $items, "limits" => ["max" => 50]];
+}
+
+function measure(string $label, array $data, string $expression): void
+{
+    $jsonPath = new JsonPath();
+
+    if (function_exists('memory_reset_peak_usage')) {
+        memory_reset_peak_usage();
+    }
+    $baseline = memory_get_peak_usage();
+
+    $start = hrtime(true);
+    for ($i = 0; $i < ITERATIONS; $i++) {
+        $result = $jsonPath->find($data, $expression);
+    }
+    $elapsed = (hrtime(true) - $start) / ITERATIONS;
+
+    $peak = memory_get_peak_usage() - $baseline;
+
+    printf("%-24s %12.1f ms/op %12.1f KiB peak\n", $label, $elapsed / 1e6, $peak / 1024);
+
+    unset($result);
+}
+
+$data = items(500000);
+
+printf("%-24s %18s %17s\n", "filter (500000 items)", "latency", "memory");
+
+measure("string equality", $data, '$.items[?(@.status == "active")]');
+measure("numeric range", $data, '$.items[?(@.price >= 10 && @.price < 20)]');
+measure("nested path", $data, '$.items[?(@.stock.count == 0)]');
+measure("negation", $data, '$.items[?(!(@.status == "active") && @.id < 1000)]');
+measure("root operand", $data, '$.items[?(@.price < $.limits.max)]');
+measure("regex", $data, '$.items[?(@.name =~ "/9$/")]');
+measure("regex, literal only", $data, '$.items[?(@.name =~ "/m 99/")]');
+measure("regex, caseless", $data, '$.items[?(@.name =~ "/ITEM 9+$/i")]');
+measure("regex, cheap conjunct", $data, '$.items[?(@.name =~ "/9$/" && @.stock.count == 0)]');
+measure("regex, cheap disjunct", $data, '$.items[?(@.name =~ "/9$/" || @.id >= 0)]');
@@ -0,0 +1,58 @@
+<?php
+
+/*
+ * Measures id lookups against one large catalog, scanned by a filter and answered by a JsonPathIndex.
+ *
+ * Building the index costs about one scan, after which each lookup is a hash lookup whatever the size
+ * of the catalog:
+ *
+ *   php -d extension=modules/jsonpath.so benchmarks/index.php
+ */
+
+if (!extension_loaded('jsonpath')) {
+    fwrite(STDERR, "The jsonpath extension is not loaded\n");
+    exit(1);
+}
+
+const LOOKUPS = 100;
+
+$n = 200000;
+$items = [];
+for ($i = 0; $i < $n; $i++) {
+    $items[] = ["id" => $i, "sku" => "SKU-$i", "price" => $i % 1000];
+}
+$catalog = ["items" => $items];
+
+$ids = [];
+for ($i = 0; $i < LOOKUPS; $i++) {
+    $ids[] = ($i * 7919) % $n;
+}
+
+function report(string $label, float $elapsed, int $lookups): void
+{
+    printf("%-24s %12.1f ms total %10.2f us/lookup\n", $label, $elapsed / 1e6, $elapsed / 1e3 / max($lookups, 1));
+}
+
+$jsonPath = new JsonPath();
+
+$start = hrtime(true);
+foreach ($ids as $id) {
+    $jsonPath->find($catalog, '$.items[?(@.id == ' . $id . ')]');
+}
+report("filter scan", hrtime(true) - $start, LOOKUPS);
+
+$start = hrtime(true);
+$index = new JsonPathIndex($catalog, '$.items[*]', '@.id');
+report("index build", hrtime(true) - $start, 0);
+
+$start = hrtime(true);
+foreach ($ids as $id) {
+    $index->find('$.items[?(@.id == ' . $id . ')]');
+}
+report("index find()", hrtime(true) - $start, LOOKUPS);
+
+$start = hrtime(true);
+foreach ($ids as $id) {
+    $index->get($id);
+}
+report("index get()", hrtime(true) - $start, LOOKUPS);
@@ -0,0 +1,148 @@
+<?php
+
+/*
+ * Measures JsonPath::set(), update() and delete() against the userland pattern they replace: find the normalized
+ * paths of the matches, then reassign each of them through a chain of references from the root.
+ *
+ * Both start from a copy of a shared document, so both pay for separating the arrays on the way to the matches:
+ *
+ *   php -d extension=modules/jsonpath.so benchmarks/mutate.php
+ */
+
+if (!extension_loaded('jsonpath')) {
+    fwrite(STDERR, "The jsonpath extension is not loaded\n");
+    exit(1);
+}
+
+const ITERATIONS = 20;
+
+function records(int $n): array
+{
+    $items = [];
+    for ($i = 0; $i < $n; $i++) {
+        $items[] = ["id" => $i, "price" => $i % 1000, "tags" => ["a", "b"], "meta" => ["seen" => false]];
+    }
+
+    return ["store" => ["items" => $items]];
+}
+
+function deep(int $n): array
+{
+    $node = ["leaf" => 0];
+    for ($i = 0; $i < $n; $i++) {
+        $node = ["level" => $i, "child" => $node, "leaf" => $i];
+    }
+
+    return ["root" => $node];
+}
+
+/* The keys of a normalized path, e.g. $['store']['items'][3] */
+function path_keys(string $path): array
+{
+    preg_match_all("/\\[(?:(\\d+)|'((?:[^'\\\\]|\\\\.)*)')\\]/", $path, $matches, PREG_SET_ORDER);
+
+    $keys = [];
+    foreach ($matches as $match) {
+        $keys[] = isset($match[2]) ? stripcslashes($match[2]) : (int)$match[1];
+    }
+
+    return $keys;
+}
+
+function userland(JsonPath $jsonPath, array &$data, string $expression, callable $write): int
+{
+    $paths = $jsonPath->findPaths($data, $expression) ?: [];
+
+    /* descendants first, so deleting an ancestor doesn't lose them */
+    foreach (array_reverse($paths) as $path) {
+        $keys = path_keys($path);
+        $last = array_pop($keys);
+        $parent = &$data;
+        foreach ($keys as $key) {
+            $parent = &$parent[$key];
+        }
+        $write($parent, $last);
+        unset($parent);
+    }
+
+    return count($paths);
+}
+
+function measure(string $label, array $document, callable $native, callable $userland): void
+{
+    $count = 0;
+
+    $start = hrtime(true);
+    for ($i = 0; $i < ITERATIONS; $i++) {
+        $data = $document;
+        $count = $native($data);
+    }
+    $nativeElapsed = (hrtime(true) - $start) / ITERATIONS;
+
+    $start = hrtime(true);
+    for ($i = 0; $i < ITERATIONS; $i++) {
+        $data = $document;
+        $userland($data);
+    }
+    $userlandElapsed = (hrtime(true) - $start) / ITERATIONS;
+
+    printf(
+        "%-32s %8d %12.1f us/op %12.1f us/op %8.1fx\n",
+        $label,
+        $count,
+        $nativeElapsed / 1000,
+        $userlandElapsed / 1000,
+        $userlandElapsed / max($nativeElapsed, 1)
+    );
+}
+
+$jsonPath = new JsonPath();
+$records = records(20000);
+$deep = deep(200);
+
+$set = function (array &$parent, $key) {
+    $parent[$key] = 0;
+};
+$update = function (array &$parent, $key) {
+    $parent[$key] = $parent[$key] * 2;
+};
+$delete = function (array &$parent, $key) {
+    unset($parent[$key]);
+};
+$double = function ($price) {
+    return $price * 2;
+};
+
+printf("%-32s %8s %18s %18s %9s\n", "case", "matches", "extension", "userland", "speedup");
+
+$expression = '$.store.items[*].price';
+measure(
+    "set $expression",
+    $records,
+    fn(array &$data) => $jsonPath->set($data, $expression, 0),
+    fn(array &$data) => userland($jsonPath, $data, $expression, $set)
+);
+
+$expression = '$.store.items[?(@.price > 500)].price';
+measure(
+    "update $expression",
+    $records,
+    fn(array &$data) => $jsonPath->update($data, $expression, $double),
+    fn(array &$data) => userland($jsonPath, $data, $expression, $update)
+);
+
+$expression = '$.store.items[*].tags';
+measure(
+    "delete $expression",
+    $records,
+    fn(array &$data) => $jsonPath->delete($data, $expression),
+    fn(array &$data) => userland($jsonPath, $data, $expression, $delete)
+);
+
+$expression = '$..leaf';
+measure(
+    "set $expression (200 levels)",
+    $deep,
+    fn(array &$data) => $jsonPath->set($data, $expression, 0),
+    fn(array &$data) => userland($jsonPath, $data, $expression, $set)
+);
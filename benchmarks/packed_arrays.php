@@ -0,0 +1,44 @@
+<?php
+
+/*
+ * Measures slices, index unions and wildcards over large lists.
+ *
+ * The elements of packed arrays are read directly from their storage, so these should cost
+ * about the same per element as a foreach over the list, and hash arrays show the difference:
+ *
+ *   php -d extension=modules/jsonpath.so benchmarks/packed_arrays.php
+ */
+
+if (!extension_loaded('jsonpath')) {
+    fwrite(STDERR, "The jsonpath extension is not loaded\n");
+    exit(1);
+}
+
+const ITERATIONS = 20;
+
+function measure(string $label, array $data, string $expression): void
+{
+    $jsonPath = new JsonPath();
+
+    $start = hrtime(true);
+    for ($i = 0; $i < ITERATIONS; $i++) {
+        $result = $jsonPath->find($data, $expression);
+    }
+    $elapsed = (hrtime(true) - $start) / ITERATIONS;
+
+    printf("%-32s %12.1f us/op %10d matches\n", $label, $elapsed / 1000, is_array($result) ? count($result) : 0);
+}
+
+$n = 1000000;
+$packed = ["list" => range(0, $n - 1)];
+$hash = ["list" => array_combine(range($n - 1, 0, -1), range($n - 1, 0, -1))];
+$indexes = implode(",", range(0, $n - 1, 1000));
+
+printf("%-32s %18s %18s\n", "$n elements", "latency", "");
+
+foreach (["packed" => $packed, "hash" => $hash] as $kind => $data) {
+    measure("$kind [*]", $data, '$.list[*]');
+    measure("$kind [::3]", $data, '$.list[::3]');
+    measure("$kind [1000:-1000]", $data, '$.list[1000:-1000]');
+    measure("$kind [i,j,k] (1000 indexes)", $data, '$.list[' . $indexes . ']');
+}
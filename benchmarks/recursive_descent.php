@@ -0,0 +1,67 @@
+<?php
+
+/*
+ * Measures recursive descent (..) over deep and wide documents.
+ *
+ * ..key is a hash lookup per visited container and scalars are skipped without a call, so the
+ * cost should grow with the number of containers rather than the number of values. The descent
+ * runs on an explicit stack, so the deepest documents don't depend on the size of the C stack:
+ *
+ *   php -d extension=modules/jsonpath.so benchmarks/recursive_descent.php
+ */
+
+if (!extension_loaded('jsonpath')) {
+    fwrite(STDERR, "The jsonpath extension is not loaded\n");
+    exit(1);
+}
+
+const ITERATIONS = 20;
+
+function wide(int $n): array
+{
+    $items = [];
+    for ($i = 0; $i < $n; $i++) {
+        $items[] = ["id" => $i, "name" => "item $i", "tags" => ["a", "b", "c"], "size" => ["w" => 1, "h" => 2]];
+    }
+
+    return ["payload" => $items];
+}
+
+function deep(int $n): array
+{
+    $node = ["name" => "leaf"];
+    for ($i = 0; $i < $n; $i++) {
+        $node = ["name" => "level $i", "child" => $node, "siblings" => range(0, 7)];
+    }
+
+    return ["payload" => $node];
+}
+
+function measure(string $label, array $data, string $expression): void
+{
+    $jsonPath = new JsonPath();
+
+    $start = hrtime(true);
+    for ($i = 0; $i < ITERATIONS; $i++) {
+        $result = $jsonPath->find($data, $expression);
+    }
+    $elapsed = (hrtime(true) - $start) / ITERATIONS;
+
+    printf("%-24s %-18s %12.1f us/op %10d matches\n", $label, $expression, $elapsed / 1000, $result ? count($result) : 0);
+}
+
+printf("%-24s %-18s %18s %18s\n", "document", "expression", "latency", "matches");
+
+foreach ([1000, 10000, 100000] as $n) {
+    $data = wide($n);
+    foreach (['$..name', '$..size.w', '$..*', '$..tags[0]'] as $expression) {
+        measure("wide ($n items)", $data, $expression);
+    }
+}
+
+foreach ([100, 1000, 10000] as $n) {
+    $data = deep($n);
+    foreach (['$..name', '$..child.name', '$..siblings[-1]'] as $expression) {
+        measure("deep ($n levels)", $data, $expression);
+    }
+}
@@ -0,0 +1,70 @@
+<?php
+
+/*
+ * Measures the cost of returning a large matched subtree from JsonPath::find().
+ *
+ * Results share the matched values by refcount, so time and peak memory should stay
+ * flat as the matched subtree grows. Run it against an older build to compare with
+ * the deep-copying implementation:
+ *
+ *   php -d extension=modules/jsonpath.so benchmarks/result_copy.php
+ */
+
+if (!extension_loaded('jsonpath')) {
+    fwrite(STDERR, "The jsonpath extension is not loaded\n");
+    exit(1);
+}
+
+const ITERATIONS = 50;
+
+function wide(int $n): array
+{
+    $items = [];
+    for ($i = 0; $i < $n; $i++) {
+        $items[] = ["id" => $i, "name" => "item $i", "tags" => ["a", "b", "c"]];
+    }
+
+    return ["payload" => $items];
+}
+
+function deep(int $n): array
+{
+    $node = ["leaf" => str_repeat("x", 32)];
+    for ($i = 0; $i < $n; $i++) {
+        $node = ["level" => $i, "child" => $node, "siblings" => range(0, 7)];
+    }
+
+    return ["payload" => $node];
+}
+
+function measure(string $label, array $data, string $expression): void
+{
+    $jsonPath = new JsonPath();
+
+    if (function_exists('memory_reset_peak_usage')) {
+        memory_reset_peak_usage();
+    }
+    $baseline = memory_get_peak_usage();
+
+    $start = hrtime(true);
+    for ($i = 0; $i < ITERATIONS; $i++) {
+        $result = $jsonPath->find($data, $expression);
+    }
+    $elapsed = (hrtime(true) - $start) / ITERATIONS;
+
+    $peak = memory_get_peak_usage() - $baseline;
+
+    printf("%-24s %12.1f us/op %12.1f KiB peak\n", $label, $elapsed / 1000, $peak / 1024);
+
+    unset($result);
+}
+
+printf("%-24s %18s %17s\n", "document", "latency", "memory");
+
+foreach ([1000, 10000, 100000] as $n) {
+    measure("wide ($n items)", wide($n), '$.payload');
+}
+
+foreach ([100, 1000, 5000] as $n) {
+    measure("deep ($n levels)", deep($n), '$.payload');
+}
@@ -0,0 +1,251 @@
+<?php
+
+/*
+ * Runs a fixed corpus of queries against generated documents of several shapes: deep, wide, a large packed list
+ * and records with many keys. Every case reports the time to compile its query, split into lexing and parsing by
+ * the engine's own timers (JsonPath::stats()), the time to evaluate it and the peak memory of one evaluation.
+ * Queries with an equivalent hand-written PHP traversal report its time too.
+ *
+ * Results are printed as one JSON object per line, with a fixed set of keys in a fixed order, so runs can be
+ * compared with benchmarks/compare.php:
+ *
+ *   make bench BENCH_ARGS="--output=before.jsonl"
+ *   make bench BENCH_ARGS="--output=after.jsonl"
+ *   php benchmarks/compare.php before.jsonl after.jsonl
+ *
+ * Options:
+ *   --output=FILE   write the results to FILE instead of stdout
+ *   --filter=TEXT   only run the cases whose name contains TEXT
+ *   --rounds=N      timed rounds per measurement, the median is reported (default 7)
+ *
+ * The query cache must be disabled (make bench runs with jsonpath.cache_size=0), otherwise compiling a query
+ * would only measure a cache lookup.
+ */
+
+if (!extension_loaded('jsonpath')) {
+    fwrite(STDERR, "The jsonpath extension is not loaded\n");
+    exit(1);
+}
+
+if ((int)ini_get('jsonpath.cache_size') !== 0) {
+    fwrite(STDERR, "Run with -d jsonpath.cache_size=0, compile times would only measure cache lookups\n");
+    exit(1);
+}
+
+$options = getopt('', ['output:', 'filter:', 'rounds:']);
+$output = isset($options['output']) ? fopen($options['output'], 'w') : STDOUT;
+$filter = $options['filter'] ?? '';
+$rounds = max(1, (int)($options['rounds'] ?? 7));
+
+/* Each round of a measurement runs for about this long, so fast operations are timed in batches */
+const ROUND_NS = 20000000;
+
+/* Documents, generated without randomness so every run sees the same data */
+
+function deep_document(int $depth): array
+{
+    $node = ["value" => $depth, "tags" => ["leaf"]];
+    for ($i = $depth - 1; $i >= 0; $i--) {
+        $node = ["value" => $i, "tags" => ["t$i", "u$i"], "child" => $node];
+    }
+
+    return $node;
+}
+
+function wide_document(int $width): array
+{
+    $map = [];
+    for ($i = 0; $i < $width; $i++) {
+        $map[sprintf("k%05d", $i)] = ["id" => $i, "v" => $i % 97];
+    }
+
+    return ["map" => $map];
+}
+
+function packed_document(int $length): array
+{
+    $items = [];
+    for ($i = 0; $i < $length; $i++) {
+        $items[] = ["id" => $i, "price" => ($i % 1000) / 10, "name" => "item $i"];
+    }
+
+    return ["items" => $items];
+}
+
+function records_document(int $count, int $keys): array
+{
+    $records = [];
+    for ($i = 0; $i < $count; $i++) {
+        $record = [];
+        for ($k = 0; $k < $keys; $k++) {
+            $record["f$k"] = ($i * 31 + $k) % 100;
+        }
+        $records[] = $record;
+    }
+
+    return ["records" => $records];
+}
+
+/* Hand-written PHP equivalents of some of the queries */
+
+function php_descend(array $node, string $key, array &$result): void
+{
+    foreach ($node as $k => $child) {
+        if ($k === $key) {
+            $result[] = $child;
+        }
+        if (is_array($child)) {
+            php_descend($child, $key, $result);
+        }
+    }
+}
+
+$documents = [
+    "deep" => fn() => deep_document(256),
+    "wide" => fn() => wide_document(20000),
+    "packed" => fn() => packed_document(200000),
+    "records" => fn() => records_document(5000, 100),
+];
+
+/* [document, category, query, PHP equivalent or null] */
+$corpus = [
+    ["deep", "selector", '$.child.child.child.child.child.child.child.child.value', null],
+    ["deep", "descent", '$..value', function ($d) {
+        $r = [];
+        php_descend($d, "value", $r);
+        return $r;
+    }],
+    ["deep", "descent", '$..tags[0]', null],
+    ["deep", "filter", '$..[?(@.value > 250)].value', null],
+
+    ["wide", "selector", '$.map.k10000.id', null],
+    ["wide", "wildcard", '$.map.*.v', fn($d) => array_values(array_column($d["map"], "v"))],
+    ["wide", "filter", '$.map[?(@.v == 3)].id', function ($d) {
+        $r = [];
+        foreach ($d["map"] as $item) {
+            if ($item["v"] === 3) {
+                $r[] = $item["id"];
+            }
+        }
+        return $r;
+    }],
+    ["wide", "descent", '$..id', null],
+
+    ["packed", "index", '$.items[150000].price', fn($d) => [$d["items"][150000]["price"]]],
+    ["packed", "slice", '$.items[1000:2000].id', fn($d) => array_column(array_slice($d["items"], 1000, 1000), "id")],
+    ["packed", "slice", '$.items[::100].id', null],
+    ["packed", "slice", '$.items[-10:].id', null],
+    ["packed", "union", '$.items[0,10,100,1000,10000,100000].id', null],
+    ["packed", "filter", '$.items[?(@.price < 1)].id', function ($d) {
+        $r = [];
+        foreach ($d["items"] as $item) {
+            if ($item["price"] < 1) {
+                $r[] = $item["id"];
+            }
+        }
+        return $r;
+    }],
+    ["packed", "filter", '$.items[?(@.price >= 10 && @.price < 11 || @.id == 7)].id', null],
+    ["packed", "regex", '$.items[?(@.name =~ "/^item 9+$/")].id', null],
+    ["packed", "descent", '$..price', function ($d) {
+        $r = [];
+        php_descend($d, "price", $r);
+        return $r;
+    }],
+
+    ["records", "wildcard", '$.records[*].f50', fn($d) => array_column($d["records"], "f50")],
+    ["records", "filter", '$.records[?(@.f10 == 5 && @.f90 > 50)].f0', null],
+    ["records", "descent", '$..f99', null],
+];
+
+/* Median time in nanoseconds of one call of $fn */
+function measure(callable $fn, int $rounds): float
+{
+    $start = hrtime(true);
+    $fn();
+    $once = max(hrtime(true) - $start, 1);
+    $batch = max(1, intdiv(ROUND_NS, $once));
+
+    $times = [];
+    for ($r = 0; $r < $rounds; $r++) {
+        $start = hrtime(true);
+        for ($i = 0; $i < $batch; $i++) {
+            $fn();
+        }
+        $times[] = (hrtime(true) - $start) / $batch;
+    }
+
+    sort($times);
+
+    return $times[intdiv(count($times), 2)];
+}
+
+/* Mean lexing and parsing times in nanoseconds of one compilation of $expression, as timed by the engine */
+function phase_times(JsonPath $jsonPath, string $expression, int $n): array
+{
+    $before = JsonPath::stats()["request"];
+    for ($i = 0; $i < $n; $i++) {
+        $jsonPath->compile($expression);
+    }
+    $after = JsonPath::stats()["request"];
+
+    return [intdiv($after["lex_ns"] - $before["lex_ns"], $n), intdiv($after["parse_ns"] - $before["parse_ns"], $n)];
+}
+
+/* Peak memory in bytes allocated by one call of $fn, on top of what was allocated before */
+function peak_memory(callable $fn): int
+{
+    if (!function_exists('memory_reset_peak_usage')) {
+        return -1;
+    }
+
+    memory_reset_peak_usage();
+    $baseline = memory_get_usage();
+    $result = $fn();
+    $peak = memory_get_peak_usage() - $baseline;
+    unset($result);
+
+    return $peak;
+}
+
+$jsonPath = new JsonPath();
+$loaded = [];
+
+foreach ($corpus as [$document, $category, $expression, $php]) {
+    $name = "$document/$category/$expression";
+
+    if ($filter !== '' && strpos($name, $filter) === false) {
+        continue;
+    }
+
+    if (!isset($loaded[$document])) {
+        /* only one document is held at a time */
+        $loaded = [$document => $documents[$document]()];
+    }
+
+    $data = $loaded[$document];
+    $query = $jsonPath->compile($expression);
+    $result = $query->find($data);
+
+    if ($php !== null && $php($data) !== $result) {
+        fwrite(STDERR, "$name: the PHP equivalent doesn't return the same result, it isn't timed\n");
+        $php = null;
+    }
+
+    [$lex, $parse] = phase_times($jsonPath, $expression, 1000);
+
+    $row = [
+        "case" => $name,
+        "matches" => is_array($result) ? count($result) : 0,
+        "compile_ns" => (int)measure(fn() => $jsonPath->compile($expression), $rounds),
+        "lex_ns" => $lex,
+        "parse_ns" => $parse,
+        "eval_ns" => (int)measure(fn() => $query->find($data), $rounds),
+        "eval_peak_bytes" => peak_memory(fn() => $query->find($data)),
+        "php_ns" => $php === null ? null : (int)measure(fn() => $php($data), $rounds),
+    ];
+
+    fwrite($output, json_encode($row, JSON_UNESCAPED_SLASHES) . "\n");
+
+    unset($data, $query, $result);
+}
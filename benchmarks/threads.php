@@ -0,0 +1,177 @@
+<?php
+
+/*
+ * Runs the same query workload on 1, 2, 4, ... threads at once with ext/parallel, checking that every thread gets
+ * the results a single thread gets and reporting how the throughput grows with the number of threads. The query
+ * cache and the counters of the current request are module globals, one copy per thread, so threads evaluating
+ * queries never wait on each other.
+ *
+ * Besides the results, it checks the state each thread keeps to itself: every round also evaluates one of more
+ * expressions than jsonpath.cache_size holds, so the cache of each thread keeps evicting plans, and =~ filters pin
+ * the compiled patterns of the thread's request. Once every thread has ended its request, the process counters
+ * must have grown by the evaluations the threads counted.
+ *
+ * Requires a ZTS build of PHP with ext/parallel, both extensions loaded from the command line or php.ini so every
+ * thread has them:
+ *
+ *   php -d extension=parallel -d extension=modules/jsonpath.so benchmarks/threads.php
+ *
+ * Options:
+ *   --threads=N     largest number of threads to run, defaults to the number of CPUs
+ *   --seconds=S     time each thread runs the workload for (default 2)
+ */
+
+if (!extension_loaded('jsonpath')) {
+    fwrite(STDERR, "The jsonpath extension is not loaded\n");
+    exit(1);
+}
+
+if (!PHP_ZTS || !extension_loaded('parallel')) {
+    fwrite(STDERR, "A ZTS build of PHP with ext/parallel is required\n");
+    exit(1);
+}
+
+function cpu_count(): int
+{
+    if (($count = getenv('NUMBER_OF_PROCESSORS')) !== false) {
+        return (int)$count;
+    }
+
+    $count = (int)@shell_exec('nproc 2>/dev/null || sysctl -n hw.ncpu 2>/dev/null');
+
+    return $count > 0 ? $count : 4;
+}
+
+$options = getopt('', ['threads:', 'seconds:']);
+$maxThreads = max(1, (int)($options['threads'] ?? cpu_count()));
+$seconds = max(0.1, (float)($options['seconds'] ?? 2));
+
+/*
+ * Runs every query of the workload until $seconds have passed, comparing the number of matches with $expected.
+ * Called with no expectations, it runs the workload once and returns the number of matches of each query.
+ * Threads only share code with the main thread, so the document is built by each of them.
+ */
+$workload = function (float $seconds, ?array $expected, int $evicted): array {
+    $items = [];
+    for ($i = 0; $i < 2000; $i++) {
+        $items[] = [
+            "id" => $i,
+            "price" => ($i % 100) / 10,
+            "name" => "item $i",
+            "tags" => ["t" . ($i % 7), "u" . ($i % 11)],
+            "stock" => ["count" => $i % 50],
+        ];
+    }
+    $data = ["items" => $items, "limits" => ["max" => 5]];
+
+    $expressions = [
+        '$.items[1500].name',
+        '$.items[*].id',
+        '$.items[100:200].price',
+        '$.items[?(@.price < $.limits.max)].id',
+        '$.items[?(@.stock.count == 0 && @.price > 2)].name',
+        '$.items[?(@.name =~ "/^item 1+$/")].id',
+        '$.items[?(@.name =~ "/em 4é?2/u")].id',
+        '$..count',
+        '$.items[*].tags[0]',
+    ];
+
+    $jsonPath = new JsonPath();
+    $counts = [];
+    $queries = 0;
+    $round = 0;
+    $executed = JsonPath::stats()["request"]["queries_executed"];
+    $start = hrtime(true);
+    $deadline = $start + (int)($seconds * 1e9);
+
+    do {
+        foreach ($expressions as $expression) {
+            /* compiled queries are taken from, and added to, the cache of this thread */
+            $result = $jsonPath->compile($expression)->find($data);
+            $count = $result === false ? 0 : count($result);
+
+            if ($expected !== null && $count !== $expected[$expression]) {
+                return ["error" => "$expression: $count matches instead of {$expected[$expression]}"];
+            }
+
+            $counts[$expression] = $count;
+            $queries++;
+        }
+
+        /* one expression per round that the cache has usually evicted since it last ran */
+        $id = $round++ % $evicted;
+        $expression = '$.items[' . $id . '].id';
+        $result = $jsonPath->find($data, $expression);
+
+        if ($result !== [$id]) {
+            return ["error" => "$expression: " . json_encode($result) . " instead of [$id]"];
+        }
+
+        $queries++;
+    } while ($expected !== null && hrtime(true) < $deadline);
+
+    return [
+        "counts" => $counts,
+        "queries" => $queries,
+        "executed" => JsonPath::stats()["request"]["queries_executed"] - $executed,
+        "elapsed_ns" => hrtime(true) - $start,
+    ];
+};
+
+/* the items rotated through, more expressions than the cache holds */
+$evicted = min(2000, max(1, (int)ini_get('jsonpath.cache_size') + 1));
+$expected = $workload(0, null, $evicted)["counts"];
+$executedBefore = JsonPath::stats()["process"]["queries_executed"];
+$executedByThreads = 0;
+
+$steps = [];
+for ($threads = 1; $threads < $maxThreads; $threads *= 2) {
+    $steps[] = $threads;
+}
+$steps[] = $maxThreads;
+
+$runtimes = [];
+$baseline = null;
+
+printf("%-8s %14s %14s %9s\n", "threads", "queries/s", "per thread", "scaling");
+
+foreach ($steps as $threads) {
+    while (count($runtimes) < $threads) {
+        $runtimes[] = new parallel\Runtime();
+    }
+
+    $futures = [];
+    for ($t = 0; $t < $threads; $t++) {
+        $futures[] = $runtimes[$t]->run($workload, [$seconds, $expected, $evicted]);
+    }
+
+    /* every thread runs for about the same time, so their rates add up */
+    $rate = 0;
+    foreach ($futures as $future) {
+        $result = $future->value();
+
+        if (isset($result["error"])) {
+            fwrite(STDERR, "$threads threads: {$result["error"]}\n");
+            exit(1);
+        }
+
+        $rate += $result["queries"] / ($result["elapsed_ns"] / 1e9);
+        $executedByThreads += $result["executed"];
+    }
+
+    $baseline ??= $rate;
+
+    printf("%-8d %14.0f %14.0f %8.2fx\n", $threads, $rate, $rate / $threads, $rate / $baseline);
+}
+
+/* a thread adds its request counters to the process counters when the request ends, i.e. when it's closed */
+foreach ($runtimes as $runtime) {
+    $runtime->close();
+}
+
+$executed = JsonPath::stats()["process"]["queries_executed"] - $executedBefore;
+
+if ($executed !== $executedByThreads) {
+    fwrite(STDERR, "The process counted $executed evaluations, the threads $executedByThreads\n");
+    exit(1);
+}
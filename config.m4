@@ -14,15 +14,25 @@ PHP_ARG_ENABLE([code-coverage],
   [no])
 
 JSONPATH_SOURCES="\
-    src/jsonpath/safe_string.c \
+    src/jsonpath/cache.c \
+    src/jsonpath/explain.c \
+    src/jsonpath/filter.c \
+    src/jsonpath/index.c \
+    src/jsonpath/regex.c \
     src/jsonpath/lexer.c \
     src/jsonpath/parser.c \
     src/jsonpath/interpreter.c \
+    src/jsonpath/mutate.c \
+    src/jsonpath/stats.c \
+    src/jsonpath/stream.c \
+    src/jsonpath/trie.c \
   ";
 
 if test "$PHP_JSONPATH" != "no"; then
   AC_DEFINE(HAVE_JSONPATH, 1, [JSONPath support enabled])
-  PHP_NEW_EXTENSION(jsonpath, jsonpath.c $JSONPATH_SOURCES, $ext_shared)
+  PHP_NEW_EXTENSION(jsonpath, jsonpath.c $JSONPATH_SOURCES, $ext_shared, , -DZEND_ENABLE_STATIC_TSRMLS_CACHE=1)
+  PHP_ADD_EXTENSION_DEP(jsonpath, json)
+  PHP_ADD_EXTENSION_DEP(jsonpath, pcre)
   PHP_ADD_BUILD_DIR($ext_builddir/src/jsonpath)
   PHP_ADD_MAKEFILE_FRAGMENT
 fi
@@ -9,151 +9,1421 @@
 #include "php.h"
 #include "php_ini.h"
 #include "php_jsonpath.h"
+#include "src/jsonpath/explain.h"
+#include "src/jsonpath/filter.h"
+#include "src/jsonpath/index.h"
 #include "src/jsonpath/interpreter.h"
 #include "src/jsonpath/lexer.h"
+#include "src/jsonpath/mutate.h"
 #include "src/jsonpath/parser.h"
+#include "src/jsonpath/regex.h"
+#include "src/jsonpath/stream.h"
+#include "src/jsonpath/trie.h"
 #include "zend_exceptions.h"
+#include "zend_interfaces.h"
 
-/* True global resources - no need for thread safety here */
-static int le_jsonpath;
-bool scanTokens(char* json_path, lex_token tok[], char tok_literals[][PARSE_BUF_LEN], int* tok_count);
+ZEND_DECLARE_MODULE_GLOBALS(jsonpath)
+
+bool scanTokens(char* json_path, struct lex_tokens* tokens);
+static struct query_plan* compile_query(char* j_path, size_t j_path_len);
+static struct query_plan* fetch_query(char* j_path, size_t j_path_len, bool* is_cached);
+static zend_string* compile_error_message(void);
+static void find_all(zval* search_target, struct query_plan* plan, zend_long limit, bool paths, zval* return_value);
+static bool check_limit(zend_long limit, uint32_t arg_num);
+static void count_execution(zend_ulong start);
+static void find_in_json(char* json, size_t json_len, struct query_plan* plan, zval* return_value);
+static zval* find_first(zval* search_target, struct query_plan* plan);
+static void find_many(zval* search_target, HashTable* expressions, struct query_plan** plans, zval* return_value);
+static void iterate(zval* search_target, struct query_plan* plan, zval* return_value);
+static void profile(zval* search_target, struct query_plan* plan, zval* return_value);
+static void find_indexed(zval* search_target, struct path_index* index, struct ast_node* filter, zval* value,
+                         zend_long limit, zval* return_value);
+static void write_matches(zval* search_target, struct query_plan* plan, enum mutate_op op, zval* value,
+                          zend_fcall_info* fci, zend_fcall_info_cache* fcc, zval* return_value);
 #ifdef JSONPATH_DEBUG
-void print_lex_tokens(lex_token lex_tok[PARSE_BUF_LEN], char lex_tok_literals[][PARSE_BUF_LEN], int lex_tok_count,
-                      const char* m);
+void print_lex_tokens(struct lex_tokens* tokens, const char* m);
+#endif
+
+zend_class_entry* jsonpath_ce;
+zend_class_entry* jsonpath_query_ce;
+zend_class_entry* jsonpath_iterator_ce;
+zend_class_entry* jsonpath_index_ce;
+
+static zend_object_handlers jsonpath_query_object_handlers;
+static zend_object_handlers jsonpath_iterator_object_handlers;
+static zend_object_handlers jsonpath_index_object_handlers;
+
+/* A compiled JSON-path expression that can be evaluated against any number of search targets */
+struct jsonpath_query {
+  struct query_plan* plan;
+  zend_object std;
+};
+
+static inline struct jsonpath_query* jsonpath_query_from_obj(zend_object* obj) {
+  return (struct jsonpath_query*)((char*)(obj)-XtOffsetOf(struct jsonpath_query, std));
+}
+
+#define Z_JSONPATH_QUERY_P(zv) jsonpath_query_from_obj(Z_OBJ_P(zv))
+
+/* A suspended evaluation producing one match at a time */
+struct jsonpath_iterator {
+  struct query_plan* plan; /* a reference, the iterator may outlive the cache entry or query object it came from */
+  struct eval_iter iter;
+  zval current;
+  zend_long key;
+  bool started;
+#if PHP_VERSION_ID < 80000
+  zend_get_gc_buffer gc;
+#endif
+  zend_object std;
+};
+
+static inline struct jsonpath_iterator* jsonpath_iterator_from_obj(zend_object* obj) {
+  return (struct jsonpath_iterator*)((char*)(obj)-XtOffsetOf(struct jsonpath_iterator, std));
+}
+
+#define Z_JSONPATH_ITERATOR_P(zv) jsonpath_iterator_from_obj(Z_OBJ_P(zv))
+
+/* A document whose collection members are grouped by the value of a key, for equality filters on the key */
+struct jsonpath_index {
+  zval data; /* the document, objects in it are shared with the caller */
+  struct query_plan* collection;
+  struct query_plan* key; /* the key path, rooted at the member instead of @ */
+  struct path_index index;
+#if PHP_VERSION_ID < 80000
+  zend_get_gc_buffer gc;
+#endif
+  zend_object std;
+};
+
+static inline struct jsonpath_index* jsonpath_index_from_obj(zend_object* obj) {
+  return (struct jsonpath_index*)((char*)(obj)-XtOffsetOf(struct jsonpath_index, std));
+}
+
+#define Z_JSONPATH_INDEX_P(zv) jsonpath_index_from_obj(Z_OBJ_P(zv))
+
+#if PHP_VERSION_ID < 80000
+#include "jsonpath_legacy_arginfo.h"
+#else
+#include "jsonpath_arginfo.h"
+#endif
+
+PHP_METHOD(JsonPath, find) {
+  /* parse php method parameters */
+
+  char* j_path;
+  size_t j_path_len;
+  zval* search_target;
+  zend_long limit = 0;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "As|l", &search_target, &j_path, &j_path_len, &limit) == FAILURE) {
+    return;
+  }
+
+  if (!check_limit(limit, 3)) {
+    return;
+  }
+
+  /* fetch the query execution instructions from the cache, or compile them */
+
+  struct query_plan* plan = fetch_query(j_path, j_path_len, NULL);
+
+  if (plan == NULL) {
+    return;
+  }
+
+  /* execute the JSON-path query instructions against the search target (PHP object/array) */
+
+  find_all(search_target, plan, limit, false, return_value);
+
+  plan_release(plan);
+}
+
+PHP_METHOD(JsonPath, findPaths) {
+  char* j_path;
+  size_t j_path_len;
+  zval* search_target;
+  zend_long limit = 0;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "As|l", &search_target, &j_path, &j_path_len, &limit) == FAILURE) {
+    return;
+  }
+
+  if (!check_limit(limit, 3)) {
+    return;
+  }
+
+  struct query_plan* plan = fetch_query(j_path, j_path_len, NULL);
+
+  if (plan == NULL) {
+    return;
+  }
+
+  find_all(search_target, plan, limit, true, return_value);
+
+  plan_release(plan);
+}
+
+PHP_METHOD(JsonPath, findMany) {
+  zval* search_target;
+  HashTable* expressions;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "Ah", &search_target, &expressions) == FAILURE) {
+    return;
+  }
+
+  uint32_t count = zend_hash_num_elements(expressions);
+  struct query_plan** plans = safe_emalloc(count, sizeof(struct query_plan*), 0);
+  uint32_t fetched = 0;
+  zval* expression;
+
+  ZEND_HASH_FOREACH_VAL(expressions, expression) {
+    ZVAL_DEREF(expression);
+
+    if (Z_TYPE_P(expression) != IS_STRING) {
+#if PHP_VERSION_ID >= 80000
+      zend_argument_type_error(2, "must contain only strings, %s given", zend_zval_type_name(expression));
+#else
+      zend_type_error("Argument 2 ($expressions) must contain only strings, %s given",
+                      zend_zval_type_name(expression));
+#endif
+      break;
+    }
+
+    /* every plan is held until the end, fetching the next ones may evict it from the cache */
+    struct query_plan* plan = fetch_query(Z_STRVAL_P(expression), Z_STRLEN_P(expression), NULL);
+
+    if (plan == NULL) {
+      break;
+    }
+
+    plans[fetched++] = plan;
+  }
+  ZEND_HASH_FOREACH_END();
+
+  if (fetched == count) {
+    find_many(search_target, expressions, plans, return_value);
+  }
+
+  for (uint32_t i = 0; i < fetched; i++) {
+    plan_release(plans[i]);
+  }
+
+  efree(plans);
+}
+
+PHP_METHOD(JsonPath, findInJson) {
+  char* json;
+  size_t json_len;
+  char* j_path;
+  size_t j_path_len;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "ss", &json, &json_len, &j_path, &j_path_len) == FAILURE) {
+    return;
+  }
+
+  struct query_plan* plan = fetch_query(j_path, j_path_len, NULL);
+
+  if (plan == NULL) {
+    return;
+  }
+
+  /* evaluate the query while scanning the JSON text, decoding only what it needs */
+
+  find_in_json(json, json_len, plan, return_value);
+
+  plan_release(plan);
+}
+
+PHP_METHOD(JsonPath, exists) {
+  char* j_path;
+  size_t j_path_len;
+  zval* search_target;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "As", &search_target, &j_path, &j_path_len) == FAILURE) {
+    return;
+  }
+
+  struct query_plan* plan = fetch_query(j_path, j_path_len, NULL);
+
+  if (plan == NULL) {
+    return;
+  }
+
+  /* stop at the first match, nothing is copied */
+
+  RETVAL_BOOL(find_first(search_target, plan) != NULL);
+
+  plan_release(plan);
+}
+
+PHP_METHOD(JsonPath, iterate) {
+  char* j_path;
+  size_t j_path_len;
+  zval* search_target;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "As", &search_target, &j_path, &j_path_len) == FAILURE) {
+    return;
+  }
+
+  struct query_plan* plan = fetch_query(j_path, j_path_len, NULL);
+
+  if (plan == NULL) {
+    return;
+  }
+
+  iterate(search_target, plan, return_value);
+}
+
+PHP_METHOD(JsonPath, set) {
+  zval* search_target;
+  char* j_path;
+  size_t j_path_len;
+  zval* value;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "asz", &search_target, &j_path, &j_path_len, &value) == FAILURE) {
+    return;
+  }
+
+  struct query_plan* plan = fetch_query(j_path, j_path_len, NULL);
+
+  if (plan == NULL) {
+    return;
+  }
+
+  write_matches(search_target, plan, MUTATE_SET, value, NULL, NULL, return_value);
+
+  plan_release(plan);
+}
+
+PHP_METHOD(JsonPath, update) {
+  zval* search_target;
+  char* j_path;
+  size_t j_path_len;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fcc;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "asf", &search_target, &j_path, &j_path_len, &fci, &fcc) == FAILURE) {
+    return;
+  }
+
+  struct query_plan* plan = fetch_query(j_path, j_path_len, NULL);
+
+  if (plan == NULL) {
+    return;
+  }
+
+  write_matches(search_target, plan, MUTATE_UPDATE, NULL, &fci, &fcc, return_value);
+
+  plan_release(plan);
+}
+
+PHP_METHOD(JsonPath, delete) {
+  zval* search_target;
+  char* j_path;
+  size_t j_path_len;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "as", &search_target, &j_path, &j_path_len) == FAILURE) {
+    return;
+  }
+
+  struct query_plan* plan = fetch_query(j_path, j_path_len, NULL);
+
+  if (plan == NULL) {
+    return;
+  }
+
+  write_matches(search_target, plan, MUTATE_DELETE, NULL, NULL, NULL, return_value);
+
+  plan_release(plan);
+}
+
+PHP_METHOD(JsonPath, compile) {
+  char* j_path;
+  size_t j_path_len;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &j_path, &j_path_len) == FAILURE) {
+    return;
+  }
+
+  struct query_plan* plan = fetch_query(j_path, j_path_len, NULL);
+
+  if (plan == NULL) {
+    return;
+  }
+
+  /* the query object keeps the reference, the plan outlives its cache entry if it's evicted */
+
+  object_init_ex(return_value, jsonpath_query_ce);
+  Z_JSONPATH_QUERY_P(return_value)->plan = plan;
+}
+
+PHP_METHOD(JsonPath, explain) {
+  char* j_path;
+  size_t j_path_len;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &j_path, &j_path_len) == FAILURE) {
+    return;
+  }
+
+  bool is_cached = false;
+  struct query_plan* plan = fetch_query(j_path, j_path_len, &is_cached);
+
+  if (plan == NULL) {
+    return;
+  }
+
+  array_init(return_value);
+  add_assoc_stringl(return_value, "expression", j_path, j_path_len);
+  add_assoc_bool(return_value, "cached", is_cached);
+  explain_plan(plan, NULL, return_value);
+
+  plan_release(plan);
+}
+
+PHP_METHOD(JsonPath, profile) {
+  char* j_path;
+  size_t j_path_len;
+  zval* search_target;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "As", &search_target, &j_path, &j_path_len) == FAILURE) {
+    return;
+  }
+
+  struct query_plan* plan = fetch_query(j_path, j_path_len, NULL);
+
+  if (plan == NULL) {
+    return;
+  }
+
+  array_init(return_value);
+  add_assoc_stringl(return_value, "expression", j_path, j_path_len);
+  profile(search_target, plan, return_value);
+
+  plan_release(plan);
+}
+
+PHP_METHOD(JsonPath, stats) {
+  struct jsonpath_stats process = JSONPATH_G(stats);
+  zval request, total;
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  /* the process counters include the current request */
+  stats_add_process(&process);
+
+  stats_to_array(&JSONPATH_G(stats), &request);
+  stats_to_array(&process, &total);
+
+  array_init_size(return_value, 2);
+  add_assoc_zval(return_value, "request", &request);
+  add_assoc_zval(return_value, "process", &total);
+}
+
+PHP_METHOD(JsonPathQuery, __construct) {}
+
+/* Fetch the plan of the query object, throwing if the object was not created by JsonPath::compile() */
+static struct query_plan* query_plan(zval* object) {
+  struct jsonpath_query* query = Z_JSONPATH_QUERY_P(object);
+
+  if (query->plan == NULL) {
+    zend_throw_error(NULL, "JsonPathQuery must be created with JsonPath::compile()");
+    return NULL;
+  }
+
+  return query->plan;
+}
+
+PHP_METHOD(JsonPathQuery, find) {
+  zval* search_target;
+  zend_long limit = 0;
+  struct query_plan* plan;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "A|l", &search_target, &limit) == FAILURE) {
+    return;
+  }
+
+  if (!check_limit(limit, 2) || (plan = query_plan(ZEND_THIS)) == NULL) {
+    return;
+  }
+
+  find_all(search_target, plan, limit, false, return_value);
+}
+
+PHP_METHOD(JsonPathQuery, findPaths) {
+  zval* search_target;
+  zend_long limit = 0;
+  struct query_plan* plan;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "A|l", &search_target, &limit) == FAILURE) {
+    return;
+  }
+
+  if (!check_limit(limit, 2) || (plan = query_plan(ZEND_THIS)) == NULL) {
+    return;
+  }
+
+  find_all(search_target, plan, limit, true, return_value);
+}
+
+PHP_METHOD(JsonPathQuery, findInJson) {
+  char* json;
+  size_t json_len;
+  struct query_plan* plan;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &json, &json_len) == FAILURE) {
+    return;
+  }
+
+  if ((plan = query_plan(ZEND_THIS)) == NULL) {
+    return;
+  }
+
+  find_in_json(json, json_len, plan, return_value);
+}
+
+PHP_METHOD(JsonPathQuery, first) {
+  zval* search_target;
+  struct query_plan* plan;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "A", &search_target) == FAILURE) {
+    return;
+  }
+
+  if ((plan = query_plan(ZEND_THIS)) == NULL) {
+    return;
+  }
+
+  zval* result = find_first(search_target, plan);
+
+  if (result == NULL) {
+    RETURN_NULL();
+  }
+
+  ZVAL_COPY_DEREF(return_value, result);
+}
+
+PHP_METHOD(JsonPathQuery, exists) {
+  zval* search_target;
+  struct query_plan* plan;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "A", &search_target) == FAILURE) {
+    return;
+  }
+
+  if ((plan = query_plan(ZEND_THIS)) == NULL) {
+    return;
+  }
+
+  RETURN_BOOL(find_first(search_target, plan) != NULL);
+}
+
+PHP_METHOD(JsonPathQuery, iterate) {
+  zval* search_target;
+  struct query_plan* plan;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "A", &search_target) == FAILURE) {
+    return;
+  }
+
+  if ((plan = query_plan(ZEND_THIS)) == NULL) {
+    return;
+  }
+
+  iterate(search_target, plan_retain(plan), return_value);
+}
+
+PHP_METHOD(JsonPathQuery, set) {
+  zval* search_target;
+  zval* value;
+  struct query_plan* plan;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "az", &search_target, &value) == FAILURE) {
+    return;
+  }
+
+  if ((plan = query_plan(ZEND_THIS)) == NULL) {
+    return;
+  }
+
+  write_matches(search_target, plan, MUTATE_SET, value, NULL, NULL, return_value);
+}
+
+PHP_METHOD(JsonPathQuery, update) {
+  zval* search_target;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fcc;
+  struct query_plan* plan;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "af", &search_target, &fci, &fcc) == FAILURE) {
+    return;
+  }
+
+  if ((plan = query_plan(ZEND_THIS)) == NULL) {
+    return;
+  }
+
+  write_matches(search_target, plan, MUTATE_UPDATE, NULL, &fci, &fcc, return_value);
+}
+
+PHP_METHOD(JsonPathQuery, delete) {
+  zval* search_target;
+  struct query_plan* plan;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "a", &search_target) == FAILURE) {
+    return;
+  }
+
+  if ((plan = query_plan(ZEND_THIS)) == NULL) {
+    return;
+  }
+
+  write_matches(search_target, plan, MUTATE_DELETE, NULL, NULL, NULL, return_value);
+}
+
+PHP_METHOD(JsonPathIterator, __construct) {}
+
+/* Fetch the state of the iterator object, throwing if the object was not created by an iterate() method */
+static struct jsonpath_iterator* iterator_state(zval* object) {
+  struct jsonpath_iterator* iterator = Z_JSONPATH_ITERATOR_P(object);
+
+  if (iterator->plan == NULL) {
+    zend_throw_error(NULL, "JsonPathIterator must be created with JsonPath::iterate()");
+    return NULL;
+  }
+
+  return iterator;
+}
+
+/* Resume the evaluation and hold on to the next match, current is UNDEF once there are no more */
+static void iterator_fetch(struct jsonpath_iterator* iterator) {
+  zend_ulong start = stats_now();
+  zval* data;
+
+  zval_ptr_dtor(&iterator->current);
+  ZVAL_UNDEF(&iterator->current);
+
+  if ((data = eval_iter_next(&iterator->iter)) != NULL) {
+    ZVAL_COPY_DEREF(&iterator->current, data);
+    JSONPATH_COUNT(results_copied, 1);
+    JSONPATH_COUNT(bytes_copied, sizeof(zval));
+  }
+
+  JSONPATH_COUNT(eval_ns, stats_now() - start);
+}
+
+/* The first match is only looked for when the iterator is first used */
+static struct jsonpath_iterator* iterator_started(zval* object) {
+  struct jsonpath_iterator* iterator = iterator_state(object);
+
+  if (iterator != NULL && !iterator->started) {
+    iterator->started = true;
+    iterator_fetch(iterator);
+  }
+
+  return iterator;
+}
+
+PHP_METHOD(JsonPathIterator, current) {
+  struct jsonpath_iterator* iterator;
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  if ((iterator = iterator_started(ZEND_THIS)) == NULL || Z_ISUNDEF(iterator->current)) {
+    return;
+  }
+
+  ZVAL_COPY(return_value, &iterator->current);
+}
+
+PHP_METHOD(JsonPathIterator, key) {
+  struct jsonpath_iterator* iterator;
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  if ((iterator = iterator_started(ZEND_THIS)) == NULL || Z_ISUNDEF(iterator->current)) {
+    return;
+  }
+
+  RETURN_LONG(iterator->key);
+}
+
+PHP_METHOD(JsonPathIterator, next) {
+  struct jsonpath_iterator* iterator;
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  if ((iterator = iterator_started(ZEND_THIS)) == NULL || Z_ISUNDEF(iterator->current)) {
+    return;
+  }
+
+  iterator_fetch(iterator);
+  iterator->key++;
+}
+
+PHP_METHOD(JsonPathIterator, rewind) {
+  struct jsonpath_iterator* iterator;
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  if ((iterator = iterator_state(ZEND_THIS)) == NULL) {
+    return;
+  }
+
+  if (iterator->started) {
+    eval_iter_rewind(&iterator->iter);
+  }
+
+  iterator->started = true;
+  iterator->key = 0;
+  iterator_fetch(iterator);
+}
+
+PHP_METHOD(JsonPathIterator, valid) {
+  struct jsonpath_iterator* iterator;
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  if ((iterator = iterator_started(ZEND_THIS)) == NULL) {
+    return;
+  }
+
+  RETURN_BOOL(!Z_ISUNDEF(iterator->current));
+}
+
+/* Compile the key path of an index, which is relative to the member, e.g. @.id. It can only consist of member */
+/* names, like the paths of filter operands it's compared with. Returns NULL if an exception was thrown. */
+static struct query_plan* compile_key(char* key, size_t key_len) {
+  if (key_len > 1 && key[0] == '@') {
+    struct query_plan* plan;
+
+    /* compile it as a path rooted at the member */
+    char* rooted = estrndup(key, key_len);
+    rooted[0] = '$';
+    plan = fetch_query(rooted, key_len, NULL);
+    efree(rooted);
+
+    if (plan == NULL) {
+      return NULL;
+    }
+
+    struct ast_node* tok = plan->head->next;
+
+    while (tok != NULL && tok->type == AST_SELECTOR) {
+      tok = tok->next;
+    }
+
+    if (tok == NULL) {
+      return plan;
+    }
+
+    plan_release(plan);
+  }
+
+#if PHP_VERSION_ID >= 80000
+  zend_argument_value_error(3, "must be a path of member names starting with @, e.g. @.id");
+#else
+  zend_throw_exception_ex(spl_ce_InvalidArgumentException, 0,
+                          "Argument 3 ($key) must be a path of member names starting with @, e.g. @.id");
 #endif
 
-zend_class_entry* jsonpath_ce;
+  return NULL;
+}
+
+/* Release the document and plans of the index object, leaving it as it was before it was constructed */
+static void index_reset(struct jsonpath_index* index) {
+  if (index->collection != NULL) {
+    index_destroy(&index->index);
+    plan_release(index->collection);
+    plan_release(index->key);
+    index->collection = NULL;
+    index->key = NULL;
+  }
+
+  zval_ptr_dtor(&index->data);
+  ZVAL_UNDEF(&index->data);
+}
+
+PHP_METHOD(JsonPathIndex, __construct) {
+  zval* search_target;
+  char* collection;
+  size_t collection_len;
+  char* key;
+  size_t key_len;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "Ass", &search_target, &collection, &collection_len, &key, &key_len) ==
+      FAILURE) {
+    return;
+  }
+
+  struct query_plan* collection_plan = fetch_query(collection, collection_len, NULL);
+  struct query_plan* key_plan;
+
+  if (collection_plan == NULL) {
+    return;
+  }
+
+  /* the index object keeps the references to its plans */
+
+  if ((key_plan = compile_key(key, key_len)) == NULL) {
+    plan_release(collection_plan);
+    return;
+  }
+
+  struct jsonpath_index* index = Z_JSONPATH_INDEX_P(ZEND_THIS);
+
+  index_reset(index);
+
+  /* arrays are held by value, so the index stays in step with its copy of them. Objects are handles shared with */
+  /* the caller, changes made to their keys afterwards aren't seen until the index is constructed again. */
+
+  ZVAL_COPY(&index->data, search_target);
+  index->collection = collection_plan;
+  index->key = key_plan;
+  index_build(&index->index, &index->data, collection_plan->head, key_plan->head->next);
+}
+
+/* Fetch the state of the index object, throwing if its constructor hasn't run */
+static struct jsonpath_index* index_state(zval* object) {
+  struct jsonpath_index* index = Z_JSONPATH_INDEX_P(object);
 
-#if PHP_VERSION_ID < 80000
-#include "jsonpath_legacy_arginfo.h"
-#else
-#include "jsonpath_arginfo.h"
-#endif
+  if (index->collection == NULL) {
+    zend_throw_error(NULL, "JsonPathIndex has not been constructed");
+    return NULL;
+  }
 
-PHP_METHOD(JsonPath, find) {
-  /* parse php method parameters */
+  return index;
+}
+
+PHP_METHOD(JsonPathIndex, get) {
+  zval* value;
+  zval* members;
+  struct jsonpath_index* index;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "z", &value) == FAILURE) {
+    return;
+  }
+
+  if ((index = index_state(ZEND_THIS)) == NULL) {
+    return;
+  }
+
+  if ((members = index_find(&index->index, value)) == NULL) {
+    RETURN_FALSE;
+  }
 
+  /* the list is shared by refcount, it's only separated if the caller writes to it */
+  ZVAL_COPY(return_value, members);
+}
+
+PHP_METHOD(JsonPathIndex, find) {
   char* j_path;
   size_t j_path_len;
-  zval* search_target;
+  zend_long limit = 0;
+  struct jsonpath_index* index;
 
-  if (zend_parse_parameters(ZEND_NUM_ARGS(), "as", &search_target, &j_path, &j_path_len) == FAILURE) {
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|l", &j_path, &j_path_len, &limit) == FAILURE) {
     return;
   }
 
-  /* tokenize JSON-path string */
+  if (!check_limit(limit, 2) || (index = index_state(ZEND_THIS)) == NULL) {
+    return;
+  }
 
-  lex_token lex_tok[PARSE_BUF_LEN];
-  char lex_tok_literals[PARSE_BUF_LEN][PARSE_BUF_LEN];
-  int lex_tok_count = 0;
+  struct query_plan* plan = fetch_query(j_path, j_path_len, NULL);
 
-  if (!scanTokens(j_path, lex_tok, lex_tok_literals, &lex_tok_count)) {
+  if (plan == NULL) {
     return;
   }
 
-  if (!sanity_check(lex_tok, lex_tok_count)) {
+  /* an equality filter on the key of the collection is a lookup, anything else is evaluated as usual */
+
+  zval value;
+  struct ast_node* filter = index_filter(index->collection->head, index->key->head->next, plan->head, &value);
+
+  if (filter != NULL) {
+    find_indexed(&index->data, &index->index, filter, &value, limit, return_value);
+  } else {
+    find_all(&index->data, plan, limit, false, return_value);
+  }
+
+  plan_release(plan);
+}
+
+/* Collect the matches, or their normalized paths, into return_value, stopping after limit matches if it's */
+/* positive. Sets return_value to false if nothing was found. */
+static void find_all(zval* search_target, struct query_plan* plan, zend_long limit, bool paths, zval* return_value) {
+  zend_ulong start = stats_now();
+  struct eval_ctx ctx;
+  struct eval_path path = {0};
+
+  array_init(return_value);
+
+  eval_init(&ctx, return_value, limit);
+  if (paths) {
+    eval_report_paths(&ctx, &path, false);
+  }
+  eval_ast(search_target, search_target, plan->head, &ctx);
+  eval_free(&ctx);
+  eval_path_free(&path);
+
+  count_execution(start);
+
+  if (zend_hash_num_elements(HASH_OF(return_value)) == 0) {
+    zval_ptr_dtor(return_value);
+    ZVAL_FALSE(return_value);
+  }
+}
+
+/* Evaluate the plans of the expressions in one traversal, returning the result find() gives for each expression */
+/* under the same key as the expression */
+static void find_many(zval* search_target, HashTable* expressions, struct query_plan** plans, zval* return_value) {
+  uint32_t count = zend_hash_num_elements(expressions);
+  zval* results = safe_emalloc(count, sizeof(zval), 0);
+
+  for (uint32_t i = 0; i < count; i++) {
+    array_init(&results[i]);
+  }
+
+  zend_ulong start = stats_now();
+  struct query_trie* trie = trie_build(plans, count);
+  trie_find(trie, search_target, results);
+  trie_free(trie);
+
+  JSONPATH_COUNT(queries_executed, count);
+  JSONPATH_COUNT(eval_ns, stats_now() - start);
+
+  if (EG(exception)) {
+    for (uint32_t i = 0; i < count; i++) {
+      zval_ptr_dtor(&results[i]);
+    }
+    efree(results);
     return;
   }
 
+  array_init_size(return_value, count);
+
+  zend_string* key;
+  zend_ulong index;
+  zval* result = results;
+
+  ZEND_HASH_FOREACH_KEY(expressions, index, key) {
+    if (zend_hash_num_elements(Z_ARRVAL_P(result)) == 0) {
+      zval_ptr_dtor(result);
+      ZVAL_FALSE(result);
+    }
+
+    if (key != NULL) {
+      zend_hash_update(Z_ARRVAL_P(return_value), key, result);
+    } else {
+      zend_hash_index_update(Z_ARRVAL_P(return_value), index, result);
+    }
+
+    result++;
+  }
+  ZEND_HASH_FOREACH_END();
+
+  efree(results);
+}
+
+/* Collect the matches of a query answered by an index, the same way find_all() would have collected them */
+static void find_indexed(zval* search_target, struct path_index* index, struct ast_node* filter, zval* value,
+                         zend_long limit, zval* return_value) {
+  struct eval_ctx ctx;
+
+  array_init(return_value);
+
+  zend_ulong start = stats_now();
+
+  eval_init(&ctx, return_value, limit);
+  index_eval(index, search_target, filter, value, &ctx);
+  eval_free(&ctx);
+
+  count_execution(start);
+
+  if (zend_hash_num_elements(HASH_OF(return_value)) == 0) {
+    zval_ptr_dtor(return_value);
+    ZVAL_FALSE(return_value);
+  }
+}
+
+/* Stop at the first match and return a pointer into the search target, or NULL if nothing was found */
+static zval* find_first(zval* search_target, struct query_plan* plan) {
+  zend_ulong start = stats_now();
+  zval result;
+
+  eval_first(search_target, search_target, plan->head, &result);
+
+  count_execution(start);
+
+  return Z_INDIRECT(result);
+}
+
+/* Write to the matches in place and return how many were written to */
+static void write_matches(zval* search_target, struct query_plan* plan, enum mutate_op op, zval* value,
+                          zend_fcall_info* fci, zend_fcall_info_cache* fcc, zval* return_value) {
+  zend_ulong start = stats_now();
+  zend_long count = mutate(search_target, plan, op, value, fci, fcc);
+
+  count_execution(start);
+
+  if (count >= 0) {
+    RETVAL_LONG(count);
+  }
+}
+
+/* Wrap a suspended evaluation of plan, which the iterator takes ownership of, in a JsonPathIterator */
+static void iterate(zval* search_target, struct query_plan* plan, zval* return_value) {
+  object_init_ex(return_value, jsonpath_iterator_ce);
+
+  struct jsonpath_iterator* iterator = Z_JSONPATH_ITERATOR_P(return_value);
+
+  iterator->plan = plan;
+  eval_iter_init(&iterator->iter, search_target, plan->head);
+
+  /* the evaluation time is counted as the matches are fetched */
+  JSONPATH_COUNT(queries_executed, 1);
+}
+
+/* Evaluate plan with every segment counting its work, and add the segments with their counters to return_value */
+static void profile(zval* search_target, struct query_plan* plan, zval* return_value) {
+  zend_ulong start = stats_now();
+  struct eval_profile counters;
+  struct eval_ctx ctx;
+  zval result;
+
+  array_init(&result);
+  eval_profile_init(&counters, plan);
+
+  eval_init(&ctx, &result, 0);
+  ctx.profile = &counters;
+  eval_ast(search_target, search_target, plan->head, &ctx);
+  eval_free(&ctx);
+
+  zend_ulong elapsed = stats_now() - start;
+
+  count_execution(start);
+
+  if (!EG(exception)) {
+    add_assoc_long(return_value, "matches", zend_hash_num_elements(Z_ARRVAL(result)));
+    add_assoc_long(return_value, "time_ns", elapsed);
+    explain_plan(plan, &counters, return_value);
+  }
+
+  eval_profile_free(&counters);
+  zval_ptr_dtor(&result);
+}
+
+/* Evaluate plan while scanning JSON text */
+static void find_in_json(char* json, size_t json_len, struct query_plan* plan, zval* return_value) {
+  zend_ulong start = stats_now();
+
+  stream_find(json, json_len, plan, return_value);
+
+  count_execution(start);
+}
+
+/* Count an evaluation of a query, which started at start */
+static void count_execution(zend_ulong start) {
+  JSONPATH_COUNT(queries_executed, 1);
+  JSONPATH_COUNT(eval_ns, stats_now() - start);
+}
+
+/* Throw if a limit argument is negative, 0 means no limit */
+static bool check_limit(zend_long limit, uint32_t arg_num) {
+  if (limit >= 0) {
+    return true;
+  }
+
+#if PHP_VERSION_ID >= 80000
+  zend_argument_value_error(arg_num, "must be greater than or equal to 0");
+#else
+  zend_throw_exception_ex(spl_ce_InvalidArgumentException, 0, "Argument %u ($limit) must be greater than or equal to 0",
+                          arg_num);
+#endif
+
+  return false;
+}
+
+static zend_object* jsonpath_query_create(zend_class_entry* ce) {
+  struct jsonpath_query* query = zend_object_alloc(sizeof(struct jsonpath_query), ce);
+
+  query->plan = NULL;
+
+  zend_object_std_init(&query->std, ce);
+  object_properties_init(&query->std, ce);
+  query->std.handlers = &jsonpath_query_object_handlers;
+
+  return &query->std;
+}
+
+static void jsonpath_query_free(zend_object* object) {
+  struct jsonpath_query* query = jsonpath_query_from_obj(object);
+
+  if (query->plan != NULL) {
+    plan_release(query->plan);
+    query->plan = NULL;
+  }
+
+  zend_object_std_dtor(object);
+}
+
+static zend_object* jsonpath_iterator_create(zend_class_entry* ce) {
+  struct jsonpath_iterator* iterator = zend_object_alloc(sizeof(struct jsonpath_iterator), ce);
+
+  iterator->plan = NULL;
+  iterator->key = 0;
+  iterator->started = false;
+  ZVAL_UNDEF(&iterator->current);
+#if PHP_VERSION_ID < 80000
+  iterator->gc = (zend_get_gc_buffer){0};
+#endif
+
+  zend_object_std_init(&iterator->std, ce);
+  object_properties_init(&iterator->std, ce);
+  iterator->std.handlers = &jsonpath_iterator_object_handlers;
+
+  return &iterator->std;
+}
+
+static void jsonpath_iterator_free(zend_object* object) {
+  struct jsonpath_iterator* iterator = jsonpath_iterator_from_obj(object);
+
+  if (iterator->plan != NULL) {
+    eval_iter_destroy(&iterator->iter);
+    plan_release(iterator->plan);
+    iterator->plan = NULL;
+  }
+
+  zval_ptr_dtor(&iterator->current);
+
+#if PHP_VERSION_ID < 80000
+  if (iterator->gc.start != NULL) {
+    efree(iterator->gc.start);
+  }
+#endif
+
+  zend_object_std_dtor(object);
+}
+
+/* The iterator holds the document, so storing it in the document makes a cycle */
+#if PHP_VERSION_ID >= 80000
+static HashTable* jsonpath_iterator_get_gc(zend_object* object, zval** table, int* n) {
+  struct jsonpath_iterator* iterator = jsonpath_iterator_from_obj(object);
+  zend_get_gc_buffer* gc = zend_get_gc_buffer_create();
+#else
+static HashTable* jsonpath_iterator_get_gc(zval* object, zval** table, int* n) {
+  struct jsonpath_iterator* iterator = Z_JSONPATH_ITERATOR_P(object);
+  zend_get_gc_buffer* gc = &iterator->gc;
+
+  gc->cur = gc->start;
+#endif
+
+  if (iterator->plan != NULL) {
+    eval_iter_gc(&iterator->iter, gc);
+  }
+
+  zend_get_gc_buffer_add_zval(gc, &iterator->current);
+  zend_get_gc_buffer_use(gc, table, n);
+
+  return zend_std_get_properties(object);
+}
+
+static zend_object* jsonpath_index_create(zend_class_entry* ce) {
+  struct jsonpath_index* index = zend_object_alloc(sizeof(struct jsonpath_index), ce);
+
+  index->collection = NULL;
+  index->key = NULL;
+  ZVAL_UNDEF(&index->data);
+#if PHP_VERSION_ID < 80000
+  index->gc = (zend_get_gc_buffer){0};
+#endif
+
+  zend_object_std_init(&index->std, ce);
+  object_properties_init(&index->std, ce);
+  index->std.handlers = &jsonpath_index_object_handlers;
+
+  return &index->std;
+}
+
+static void jsonpath_index_free(zend_object* object) {
+  struct jsonpath_index* index = jsonpath_index_from_obj(object);
+
+  index_reset(index);
+
+#if PHP_VERSION_ID < 80000
+  if (index->gc.start != NULL) {
+    efree(index->gc.start);
+  }
+#endif
+
+  zend_object_std_dtor(object);
+}
+
+/* The index holds the document and its members, so storing it in the document makes a cycle */
+#if PHP_VERSION_ID >= 80000
+static HashTable* jsonpath_index_get_gc(zend_object* object, zval** table, int* n) {
+  struct jsonpath_index* index = jsonpath_index_from_obj(object);
+  zend_get_gc_buffer* gc = zend_get_gc_buffer_create();
+#else
+static HashTable* jsonpath_index_get_gc(zval* object, zval** table, int* n) {
+  struct jsonpath_index* index = Z_JSONPATH_INDEX_P(object);
+  zend_get_gc_buffer* gc = &index->gc;
+
+  gc->cur = gc->start;
+#endif
+
+  zend_get_gc_buffer_add_zval(gc, &index->data);
+
+  if (index->collection != NULL) {
+    index_gc(&index->index, gc);
+  }
+
+  zend_get_gc_buffer_use(gc, table, n);
+
+  return zend_std_get_properties(object);
+}
+
+/* Tokenize, parse and validate a JSON-path expression. Returns the plan in request memory, */
+/* or NULL if an exception was thrown. */
+static struct query_plan* compile_query(char* j_path, size_t j_path_len) {
+  /* tokenize JSON-path string */
+
+  zend_ulong start = stats_now();
+  struct lex_tokens tokens;
+  lex_tokens_init(&tokens);
+
+  JSONPATH_COUNT(queries_compiled, 1);
+
+  bool scanned = scanTokens(j_path, &tokens);
+  zend_ulong lexed = stats_now();
+
+  JSONPATH_COUNT(lex_ns, lexed - start);
+
+  if (!scanned || !sanity_check(tokens.tok, tokens.count)) {
+    lex_tokens_free(&tokens);
+    return NULL;
+  }
+
 #ifdef JSONPATH_DEBUG
-  print_lex_tokens(lex_tok, lex_tok_literals, lex_tok_count, "Lexer - Processed tokens");
+  print_lex_tokens(&tokens, "Lexer - Processed tokens");
 #endif
 
   /* assemble an array of query execution instructions from parsed tokens */
 
-  struct ast_node head;
+  struct query_plan* plan = plan_alloc(tokens.count);
+  struct ast_node head = {0};
   int i = 0;
 
-  if (!build_parse_tree(lex_tok, lex_tok_literals, &i, lex_tok_count, &head)) {
-    free_ast_nodes(head.next);
-    return;
-  }
+  /* a plan that overflowed holds a partial tree, it isn't validated */
+  bool success = build_parse_tree(plan, tokens.tok, tokens.literals, &i, tokens.count, &head) && !plan->overflow &&
+                 validate_parse_tree(head.next);
 
-  if (!validate_parse_tree(head.next)) {
-    free_ast_nodes(head.next);
-    return;
+  lex_tokens_free(&tokens);
+
+  if (!success) {
+    JSONPATH_COUNT(parse_ns, stats_now() - lexed);
+    plan_release(plan);
+    return NULL;
   }
 
 #ifdef JSONPATH_DEBUG
   print_ast(head.next, "Parser - AST sent to interpreter", 0);
 #endif
 
-  /* execute the JSON-path query instructions against the search target (PHP object/array) */
+  plan->head = head.next;
 
-  array_init(return_value);
+  filter_compile_plan(plan);
 
-  eval_ast(search_target, search_target, head.next, return_value);
+  JSONPATH_COUNT(parse_ns, stats_now() - lexed);
 
-  free_ast_nodes(head.next);
+  /* resolving a =~ pattern may raise a warning, which an error handler can turn into an exception */
+  if (EG(exception) || plan->overflow) {
+    plan_release(plan);
+    return NULL;
+  }
 
-  /* return false if no results were found by the JSON-path query */
+  return plan;
+}
 
-  if (zend_hash_num_elements(HASH_OF(return_value)) == 0) {
-    convert_to_boolean(return_value);
-    RETURN_FALSE;
+/* Look up the compiled plan of a JSON-path expression in the query cache, compiling and caching it on a miss. */
+/* Compilation errors are cached too and re-thrown on the next lookup. The caller gets a reference to the plan */
+/* and must release it: evaluating a query can run user code (destructors, error handlers) that evicts the plan */
+/* from the cache, so the plan is pinned for as long as the caller uses it. If is_cached is given, it tells */
+/* whether the cache holds the plan too. */
+static struct query_plan* fetch_query(char* j_path, size_t j_path_len, bool* is_cached) {
+  zend_long capacity = JSONPATH_G(cache_size);
+  struct query_cache* cache = &JSONPATH_G(query_cache);
+  struct cache_entry* entry;
+  struct query_plan* plan;
+
+  if (is_cached != NULL) {
+    *is_cached = capacity > 0;
+  }
+
+  if (capacity <= 0) {
+    return compile_query(j_path, j_path_len);
+  }
+
+  if ((entry = cache_find(cache, j_path, j_path_len)) != NULL) {
+    if (entry->plan == NULL) {
+      zend_throw_exception(spl_ce_RuntimeException, ZSTR_VAL(entry->error), 0);
+      return NULL;
+    }
+
+    return plan_retain(entry->plan);
   }
+
+  if ((plan = compile_query(j_path, j_path_len)) == NULL) {
+    zend_string* error = compile_error_message();
+
+    if (error != NULL) {
+      cache_add(cache, capacity, j_path, j_path_len, NULL, error);
+    }
+
+    return NULL;
+  }
+
+  entry = cache_add(cache, capacity, j_path, j_path_len, plan_clone(plan, true), NULL);
+  plan_release(plan);
+
+  return plan_retain(entry->plan);
+}
+
+/* Copy the message of the RuntimeException thrown by the compiler into persistent memory */
+static zend_string* compile_error_message(void) {
+  zend_object* ex = EG(exception);
+  zval *message, rv;
+
+  if (ex == NULL || !instanceof_function(ex->ce, spl_ce_RuntimeException)) {
+    return NULL;
+  }
+
+#if PHP_MAJOR_VERSION >= 8
+  message = zend_read_property_ex(zend_ce_exception, ex, ZSTR_KNOWN(ZEND_STR_MESSAGE), 1, &rv);
+#else
+  zval obj;
+  ZVAL_OBJ(&obj, ex);
+  message = zend_read_property_ex(zend_ce_exception, &obj, ZSTR_KNOWN(ZEND_STR_MESSAGE), 1, &rv);
+#endif
+
+  if (Z_TYPE_P(message) != IS_STRING) {
+    return NULL;
+  }
+
+  return zend_string_init(Z_STRVAL_P(message), Z_STRLEN_P(message), 1);
 }
 
-bool scanTokens(char* json_path, lex_token tok[], char tok_literals[][PARSE_BUF_LEN], int* tok_count) {
+bool scanTokens(char* json_path, struct lex_tokens* tokens) {
   lex_token cur_tok;
+  struct lex_literal literal;
   char* p = json_path;
-  char buffer[PARSE_BUF_LEN];
-
-  int i = 0;
 
-  while ((cur_tok = scan(&p, buffer, sizeof(buffer), json_path)) != LEX_NOT_FOUND) {
-    if (i >= PARSE_BUF_LEN) {
-      zend_throw_exception(spl_ce_RuntimeException, "The query is too long. Token count exceeds PARSE_BUF_LEN.", 0);
+  while ((cur_tok = scan(&p, &literal, json_path)) != LEX_NOT_FOUND) {
+    if (cur_tok == LEX_ERR) {
       return false;
     }
 
-    switch (cur_tok) {
-      case LEX_NODE:
-      case LEX_LITERAL:
-      case LEX_LITERAL_BOOL:
-      case LEX_LITERAL_NUMERIC:
-        strcpy(tok_literals[i], buffer);
-        break;
-      case LEX_ERR:
-        return false;
-      default:
-        tok_literals[i][0] = '\0';
-        break;
-    }
-
-    tok[i] = cur_tok;
-    i++;
+    lex_tokens_add(tokens, cur_tok, literal);
   }
 
-  *tok_count = i;
-
   return true;
 }
 
 #ifdef JSONPATH_DEBUG
-void print_lex_tokens(lex_token lex_tok[PARSE_BUF_LEN], char lex_tok_literals[][PARSE_BUF_LEN], int lex_tok_count,
-                      const char* m) {
+void print_lex_tokens(struct lex_tokens* tokens, const char* m) {
   printf("--------------------------------------\n");
   printf("%s\n\n", m);
 
-  for (int i = 0; i < lex_tok_count; i++) {
-    printf("\t• %s", LEX_STR[lex_tok[i]]);
-    if (strlen(lex_tok_literals[i]) > 0) {
-      printf(" [val=%s]", lex_tok_literals[i]);
+  for (int i = 0; i < tokens->count; i++) {
+    printf("\t• %s", LEX_STR[tokens->tok[i]]);
+    if (tokens->literals[i].len > 0) {
+      printf(" [val=%.*s]", (int)tokens->literals[i].len, tokens->literals[i].val);
     }
     printf("\n");
   }
 }
 #endif
 
+/* {{{ PHP_INI
+ */
+PHP_INI_BEGIN()
+STD_PHP_INI_ENTRY("jsonpath.cache_size", "256", PHP_INI_SYSTEM, OnUpdateLong, cache_size, zend_jsonpath_globals,
+                  jsonpath_globals)
+PHP_INI_END()
+
+/* }}} */
+
+/* {{{ PHP_GINIT_FUNCTION
+ */
+static PHP_GINIT_FUNCTION(jsonpath) {
+#if defined(COMPILE_DL_JSONPATH) && defined(ZTS)
+  ZEND_TSRMLS_CACHE_UPDATE();
+#endif
+  jsonpath_globals->cache_size = 0;
+  cache_init(&jsonpath_globals->query_cache);
+  memset(&jsonpath_globals->stats, 0, sizeof(struct jsonpath_stats));
+  jsonpath_globals->pinned_regexes = NULL;
+}
+
+/* }}} */
+
+/* {{{ PHP_GSHUTDOWN_FUNCTION
+ */
+static PHP_GSHUTDOWN_FUNCTION(jsonpath) { cache_destroy(&jsonpath_globals->query_cache); }
+
+/* }}} */
+
 /* {{{ PHP_MINIT_FUNCTION
  */
 PHP_MINIT_FUNCTION(jsonpath) {
+  REGISTER_INI_ENTRIES();
+  stats_startup();
+
   zend_class_entry jsonpath_class_entry;
   INIT_CLASS_ENTRY(jsonpath_class_entry, "JsonPath", class_JsonPath_methods);
 
   jsonpath_ce = zend_register_internal_class(&jsonpath_class_entry);
 
+  zend_class_entry jsonpath_query_class_entry;
+  INIT_CLASS_ENTRY(jsonpath_query_class_entry, "JsonPathQuery", class_JsonPathQuery_methods);
+
+  jsonpath_query_ce = zend_register_internal_class(&jsonpath_query_class_entry);
+  jsonpath_query_ce->ce_flags |= ZEND_ACC_FINAL;
+  jsonpath_query_ce->create_object = jsonpath_query_create;
+
+  memcpy(&jsonpath_query_object_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+  jsonpath_query_object_handlers.offset = XtOffsetOf(struct jsonpath_query, std);
+  jsonpath_query_object_handlers.free_obj = jsonpath_query_free;
+  jsonpath_query_object_handlers.clone_obj = NULL;
+
+  zend_class_entry jsonpath_iterator_class_entry;
+  INIT_CLASS_ENTRY(jsonpath_iterator_class_entry, "JsonPathIterator", class_JsonPathIterator_methods);
+
+  jsonpath_iterator_ce = zend_register_internal_class(&jsonpath_iterator_class_entry);
+  jsonpath_iterator_ce->ce_flags |= ZEND_ACC_FINAL;
+  jsonpath_iterator_ce->create_object = jsonpath_iterator_create;
+  zend_class_implements(jsonpath_iterator_ce, 1, zend_ce_iterator);
+
+  memcpy(&jsonpath_iterator_object_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+  jsonpath_iterator_object_handlers.offset = XtOffsetOf(struct jsonpath_iterator, std);
+  jsonpath_iterator_object_handlers.free_obj = jsonpath_iterator_free;
+  jsonpath_iterator_object_handlers.get_gc = jsonpath_iterator_get_gc;
+  jsonpath_iterator_object_handlers.clone_obj = NULL;
+
+  zend_class_entry jsonpath_index_class_entry;
+  INIT_CLASS_ENTRY(jsonpath_index_class_entry, "JsonPathIndex", class_JsonPathIndex_methods);
+
+  jsonpath_index_ce = zend_register_internal_class(&jsonpath_index_class_entry);
+  jsonpath_index_ce->ce_flags |= ZEND_ACC_FINAL;
+  jsonpath_index_ce->create_object = jsonpath_index_create;
+
+  memcpy(&jsonpath_index_object_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+  jsonpath_index_object_handlers.offset = XtOffsetOf(struct jsonpath_index, std);
+  jsonpath_index_object_handlers.free_obj = jsonpath_index_free;
+  jsonpath_index_object_handlers.get_gc = jsonpath_index_get_gc;
+  jsonpath_index_object_handlers.clone_obj = NULL;
+
   return SUCCESS;
 }
 
@@ -162,39 +1432,68 @@ PHP_MINIT_FUNCTION(jsonpath) {
 /* {{{ PHP_MSHUTDOWN_FUNCTION
  */
 PHP_MSHUTDOWN_FUNCTION(jsonpath) {
-  /* uncomment this line if you have INI entries
-     UNREGISTER_INI_ENTRIES();
-   */
+  UNREGISTER_INI_ENTRIES();
+  stats_shutdown();
+
   return SUCCESS;
 }
 
 /* }}} */
 
-/* Remove if there's nothing to do at request start */
 /* {{{ PHP_RINIT_FUNCTION
  */
-PHP_RINIT_FUNCTION(jsonpath) { return SUCCESS; }
+PHP_RINIT_FUNCTION(jsonpath) {
+#if defined(COMPILE_DL_JSONPATH) && defined(ZTS)
+  ZEND_TSRMLS_CACHE_UPDATE();
+#endif
+  memset(&JSONPATH_G(stats), 0, sizeof(struct jsonpath_stats));
+
+  return SUCCESS;
+}
 
 /* }}} */
 
-/* Remove if there's nothing to do at request end */
 /* {{{ PHP_RSHUTDOWN_FUNCTION
  */
-PHP_RSHUTDOWN_FUNCTION(jsonpath) { return SUCCESS; }
+PHP_RSHUTDOWN_FUNCTION(jsonpath) {
+  stats_commit(&JSONPATH_G(stats));
+  regex_unpin_all();
+
+  return SUCCESS;
+}
 
 /* }}} */
 
 /* {{{ PHP_MINFO_FUNCTION
  */
 PHP_MINFO_FUNCTION(jsonpath) {
+  struct query_cache* cache = &JSONPATH_G(query_cache);
+  char buf[32];
+
   php_info_print_table_start();
   php_info_print_table_row(2, "jsonpath support", "enabled");
   php_info_print_table_row(2, "jsonpath version", PHP_JSONPATH_VERSION);
+  php_info_print_table_row(2, "query cache", JSONPATH_G(cache_size) > 0 ? "enabled" : "disabled");
+  snprintf(buf, sizeof(buf), "%u", zend_hash_num_elements(&cache->entries));
+  php_info_print_table_row(2, "query cache entries", buf);
+  snprintf(buf, sizeof(buf), ZEND_ULONG_FMT, cache->hits);
+  php_info_print_table_row(2, "query cache hits", buf);
+  snprintf(buf, sizeof(buf), ZEND_ULONG_FMT, cache->misses);
+  php_info_print_table_row(2, "query cache misses", buf);
+  snprintf(buf, sizeof(buf), ZEND_ULONG_FMT, cache->evictions);
+  php_info_print_table_row(2, "query cache evictions", buf);
+  php_info_print_table_end();
+
+  /* counters of the process, including the current request */
+  struct jsonpath_stats process = JSONPATH_G(stats);
+  stats_add_process(&process);
+
+  php_info_print_table_start();
+  php_info_print_table_header(2, "engine counter", "value");
+  stats_print_info(&process);
   php_info_print_table_end();
 
-  /* Remove comments if you have entries in php.ini
-     DISPLAY_INI_ENTRIES();
-   */
+  DISPLAY_INI_ENTRIES();
 }
 
 /* }}} */
@@ -209,16 +1508,30 @@ const zend_function_entry jsonpath_functions[] = {
 
 /* }}} */
 
+/* {{{ jsonpath_deps[]
+ */
+/* pcre shuts down after jsonpath, which unpins its compiled patterns first */
+static const zend_module_dep jsonpath_deps[] = {ZEND_MOD_REQUIRED("json") ZEND_MOD_REQUIRED("pcre") ZEND_MOD_END};
+
+/* }}} */
+
 /* {{{ jsonpath_module_entry
  */
 zend_module_entry jsonpath_module_entry = {
-    STANDARD_MODULE_HEADER,  "jsonpath",           jsonpath_functions,        PHP_MINIT(jsonpath),
-    PHP_MSHUTDOWN(jsonpath), PHP_RINIT(jsonpath), /* Replace with NULL if there's nothing to do at request start */
-    PHP_RSHUTDOWN(jsonpath),                      /* Replace with NULL if there's nothing to do at request end */
-    PHP_MINFO(jsonpath),     PHP_JSONPATH_VERSION, STANDARD_MODULE_PROPERTIES};
+    STANDARD_MODULE_HEADER_EX, NULL,
+    jsonpath_deps,           "jsonpath",
+    jsonpath_functions,      PHP_MINIT(jsonpath),
+    PHP_MSHUTDOWN(jsonpath), PHP_RINIT(jsonpath),
+    PHP_RSHUTDOWN(jsonpath),
+    PHP_MINFO(jsonpath),     PHP_JSONPATH_VERSION, PHP_MODULE_GLOBALS(jsonpath),
+    PHP_GINIT(jsonpath),     PHP_GSHUTDOWN(jsonpath), NULL,
+    STANDARD_MODULE_PROPERTIES_EX};
 
 /* }}} */
 
 #ifdef COMPILE_DL_JSONPATH
+#ifdef ZTS
+ZEND_TSRMLS_CACHE_DEFINE()
+#endif
 ZEND_GET_MODULE(jsonpath)
 #endif
@@ -7,11 +7,218 @@
 
 class JsonPath
 {
+    /**
+     * @param array|object $data
+     * @param string $expression
+     * @param int $limit Stop after this many matches, 0 for no limit
+     *
+     * @return array|bool
+     */
+    public function find(array|object $data, string $expression, int $limit = 0): array|bool;
+
+    /**
+     * @param array|object $data
+     * @param string $expression
+     * @param int $limit Stop after this many matches, 0 for no limit
+     *
+     * @return array|bool Normalized paths of the matches, e.g. $['store']['book'][3]
+     */
+    public function findPaths(array|object $data, string $expression, int $limit = 0): array|bool;
+
+    /**
+     * @param array|object $data
+     * @param string[] $expressions
+     *
+     * @return array The result find() returns for each expression, under the key of the expression
+     */
+    public function findMany(array|object $data, array $expressions): array;
+
+    /**
+     * @param string $json
+     * @param string $expression
+     *
+     * @return array|bool
+     */
+    public function findInJson(string $json, string $expression): array|bool;
+
+    /**
+     * @param array|object $data
+     * @param string $expression
+     *
+     * @return bool
+     */
+    public function exists(array|object $data, string $expression): bool;
+
+    /**
+     * @param array|object $data
+     * @param string $expression
+     *
+     * @return JsonPathIterator
+     */
+    public function iterate(array|object $data, string $expression): JsonPathIterator;
+
+    /**
+     * @param array $data
+     * @param string $expression
+     * @param mixed $value
+     *
+     * @return int Number of matches replaced
+     */
+    public function set(array &$data, string $expression, mixed $value): int;
+
+    /**
+     * @param array $data
+     * @param string $expression
+     * @param callable $fn Called with each match, returns its replacement
+     *
+     * @return int Number of matches replaced
+     */
+    public function update(array &$data, string $expression, callable $fn): int;
+
+    /**
+     * @param array $data
+     * @param string $expression
+     *
+     * @return int Number of matches removed
+     */
+    public function delete(array &$data, string $expression): int;
+
+    /**
+     * @param string $expression
+     *
+     * @return JsonPathQuery
+     */
+    public function compile(string $expression): JsonPathQuery;
+
+    /**
+     * @param string $expression
+     *
+     * @return array The segments of the compiled query, with the way each of them is evaluated
+     */
+    public function explain(string $expression): array;
+
+    /**
+     * @param array|object $data
+     * @param string $expression
+     *
+     * @return array The segments of the compiled query, with the work each of them did to evaluate it against $data
+     */
+    public function profile(array|object $data, string $expression): array;
+
+    /**
+     * @return array Engine counters of the current request under "request", and of the process under "process"
+     */
+    public static function stats(): array;
+}
+
+final class JsonPathQuery
+{
+    private function __construct() {}
+
+    /**
+     * @param array|object $data
+     * @param int $limit Stop after this many matches, 0 for no limit
+     *
+     * @return array|bool
+     */
+    public function find(array|object $data, int $limit = 0): array|bool;
+
+    /**
+     * @param array|object $data
+     * @param int $limit Stop after this many matches, 0 for no limit
+     *
+     * @return array|bool Normalized paths of the matches, e.g. $['store']['book'][3]
+     */
+    public function findPaths(array|object $data, int $limit = 0): array|bool;
+
+    /**
+     * @param string $json
+     *
+     * @return array|bool
+     */
+    public function findInJson(string $json): array|bool;
+
+    /**
+     * @param array|object $data
+     *
+     * @return mixed
+     */
+    public function first(array|object $data): mixed;
+
+    /**
+     * @param array|object $data
+     *
+     * @return bool
+     */
+    public function exists(array|object $data): bool;
+
+    /**
+     * @param array|object $data
+     *
+     * @return JsonPathIterator
+     */
+    public function iterate(array|object $data): JsonPathIterator;
+
+    /**
+     * @param array $data
+     * @param mixed $value
+     *
+     * @return int Number of matches replaced
+     */
+    public function set(array &$data, mixed $value): int;
+
+    /**
+     * @param array $data
+     * @param callable $fn Called with each match, returns its replacement
+     *
+     * @return int Number of matches replaced
+     */
+    public function update(array &$data, callable $fn): int;
+
     /**
      * @param array $data
+     *
+     * @return int Number of matches removed
+     */
+    public function delete(array &$data): int;
+}
+
+final class JsonPathIndex
+{
+    /**
+     * @param array|object $data
+     * @param string $collection Path of the members to index, e.g. $.items[*]
+     * @param string $key Path of the key relative to a member, e.g. @.id
+     */
+    public function __construct(array|object $data, string $collection, string $key) {}
+
+    /**
+     * @param mixed $value
+     *
+     * @return array|bool The members whose key is identical to $value
+     */
+    public function get(mixed $value): array|bool;
+
+    /**
      * @param string $expression
+     * @param int $limit Stop after this many matches, 0 for no limit
      *
      * @return array|bool
      */
-    public function find(array $data, string $expression): array|bool;
-}
\ No newline at end of file
+    public function find(string $expression, int $limit = 0): array|bool;
+}
+
+final class JsonPathIterator implements Iterator
+{
+    private function __construct() {}
+
+    public function current(): mixed;
+
+    public function key(): mixed;
+
+    public function next(): void;
+
+    public function rewind(): void;
+
+    public function valid(): bool;
+}
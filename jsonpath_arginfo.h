@@ -1,16 +1,219 @@
 /* This is a generated file, edit the .stub.php file instead.
- * Stub hash: 8c7e66dd5931d6f4c0d2baee3efdcb1eb834c9f7 */
+ * Stub hash: f08e1c09a7129a31023e111c70b1cb3059c11e88 */
 
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_MASK_EX(arginfo_class_JsonPath_find, 0, 2, MAY_BE_ARRAY|MAY_BE_BOOL)
-	ZEND_ARG_TYPE_INFO(0, data, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_MASK(0, data, MAY_BE_ARRAY|MAY_BE_OBJECT, NULL)
 	ZEND_ARG_TYPE_INFO(0, expression, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, limit, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_JsonPath_findPaths arginfo_class_JsonPath_find
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPath_findMany, 0, 2, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_MASK(0, data, MAY_BE_ARRAY|MAY_BE_OBJECT, NULL)
+	ZEND_ARG_TYPE_INFO(0, expressions, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_MASK_EX(arginfo_class_JsonPath_findInJson, 0, 2, MAY_BE_ARRAY|MAY_BE_BOOL)
+	ZEND_ARG_TYPE_INFO(0, json, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, expression, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPath_exists, 0, 2, _IS_BOOL, 0)
+	ZEND_ARG_TYPE_MASK(0, data, MAY_BE_ARRAY|MAY_BE_OBJECT, NULL)
+	ZEND_ARG_TYPE_INFO(0, expression, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_class_JsonPath_iterate, 0, 2, JsonPathIterator, 0)
+	ZEND_ARG_TYPE_MASK(0, data, MAY_BE_ARRAY|MAY_BE_OBJECT, NULL)
+	ZEND_ARG_TYPE_INFO(0, expression, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPath_set, 0, 3, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(1, data, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, expression, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, value, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPath_update, 0, 3, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(1, data, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, expression, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, fn, IS_CALLABLE, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPath_delete, 0, 2, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(1, data, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, expression, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_class_JsonPath_compile, 0, 1, JsonPathQuery, 0)
+	ZEND_ARG_TYPE_INFO(0, expression, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPath_explain, 0, 1, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, expression, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPath_profile, 0, 2, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_MASK(0, data, MAY_BE_ARRAY|MAY_BE_OBJECT, NULL)
+	ZEND_ARG_TYPE_INFO(0, expression, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPath_stats, 0, 0, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_JsonPathQuery___construct, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_MASK_EX(arginfo_class_JsonPathQuery_find, 0, 1, MAY_BE_ARRAY|MAY_BE_BOOL)
+	ZEND_ARG_TYPE_MASK(0, data, MAY_BE_ARRAY|MAY_BE_OBJECT, NULL)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, limit, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_JsonPathQuery_findPaths arginfo_class_JsonPathQuery_find
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_MASK_EX(arginfo_class_JsonPathQuery_findInJson, 0, 1, MAY_BE_ARRAY|MAY_BE_BOOL)
+	ZEND_ARG_TYPE_INFO(0, json, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPathQuery_first, 0, 1, IS_MIXED, 0)
+	ZEND_ARG_TYPE_MASK(0, data, MAY_BE_ARRAY|MAY_BE_OBJECT, NULL)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPathQuery_exists, 0, 1, _IS_BOOL, 0)
+	ZEND_ARG_TYPE_MASK(0, data, MAY_BE_ARRAY|MAY_BE_OBJECT, NULL)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_class_JsonPathQuery_iterate, 0, 1, JsonPathIterator, 0)
+	ZEND_ARG_TYPE_MASK(0, data, MAY_BE_ARRAY|MAY_BE_OBJECT, NULL)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPathQuery_set, 0, 2, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(1, data, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, value, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPathQuery_update, 0, 2, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(1, data, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, fn, IS_CALLABLE, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPathQuery_delete, 0, 1, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(1, data, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_JsonPathIndex___construct, 0, 0, 3)
+	ZEND_ARG_TYPE_MASK(0, data, MAY_BE_ARRAY|MAY_BE_OBJECT, NULL)
+	ZEND_ARG_TYPE_INFO(0, collection, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_MASK_EX(arginfo_class_JsonPathIndex_get, 0, 1, MAY_BE_ARRAY|MAY_BE_BOOL)
+	ZEND_ARG_TYPE_INFO(0, value, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_MASK_EX(arginfo_class_JsonPathIndex_find, 0, 1, MAY_BE_ARRAY|MAY_BE_BOOL)
+	ZEND_ARG_TYPE_INFO(0, expression, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, limit, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_JsonPathIterator___construct arginfo_class_JsonPathQuery___construct
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPathIterator_current, 0, 0, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_JsonPathIterator_key arginfo_class_JsonPathIterator_current
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPathIterator_next, 0, 0, IS_VOID, 0)
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_JsonPathIterator_rewind arginfo_class_JsonPathIterator_next
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_JsonPathIterator_valid, 0, 0, _IS_BOOL, 0)
 ZEND_END_ARG_INFO()
 
 
 ZEND_METHOD(JsonPath, find);
+ZEND_METHOD(JsonPath, findPaths);
+ZEND_METHOD(JsonPath, findMany);
+ZEND_METHOD(JsonPath, findInJson);
+ZEND_METHOD(JsonPath, exists);
+ZEND_METHOD(JsonPath, iterate);
+ZEND_METHOD(JsonPath, set);
+ZEND_METHOD(JsonPath, update);
+ZEND_METHOD(JsonPath, delete);
+ZEND_METHOD(JsonPath, compile);
+ZEND_METHOD(JsonPath, explain);
+ZEND_METHOD(JsonPath, profile);
+ZEND_METHOD(JsonPath, stats);
+ZEND_METHOD(JsonPathQuery, __construct);
+ZEND_METHOD(JsonPathQuery, find);
+ZEND_METHOD(JsonPathQuery, findPaths);
+ZEND_METHOD(JsonPathQuery, findInJson);
+ZEND_METHOD(JsonPathQuery, first);
+ZEND_METHOD(JsonPathQuery, exists);
+ZEND_METHOD(JsonPathQuery, iterate);
+ZEND_METHOD(JsonPathQuery, set);
+ZEND_METHOD(JsonPathQuery, update);
+ZEND_METHOD(JsonPathQuery, delete);
+ZEND_METHOD(JsonPathIndex, __construct);
+ZEND_METHOD(JsonPathIndex, get);
+ZEND_METHOD(JsonPathIndex, find);
+ZEND_METHOD(JsonPathIterator, __construct);
+ZEND_METHOD(JsonPathIterator, current);
+ZEND_METHOD(JsonPathIterator, key);
+ZEND_METHOD(JsonPathIterator, next);
+ZEND_METHOD(JsonPathIterator, rewind);
+ZEND_METHOD(JsonPathIterator, valid);
 
 
 static const zend_function_entry class_JsonPath_methods[] = {
 	ZEND_ME(JsonPath, find, arginfo_class_JsonPath_find, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPath, findPaths, arginfo_class_JsonPath_findPaths, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPath, findMany, arginfo_class_JsonPath_findMany, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPath, findInJson, arginfo_class_JsonPath_findInJson, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPath, exists, arginfo_class_JsonPath_exists, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPath, iterate, arginfo_class_JsonPath_iterate, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPath, set, arginfo_class_JsonPath_set, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPath, update, arginfo_class_JsonPath_update, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPath, delete, arginfo_class_JsonPath_delete, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPath, compile, arginfo_class_JsonPath_compile, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPath, explain, arginfo_class_JsonPath_explain, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPath, profile, arginfo_class_JsonPath_profile, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPath, stats, arginfo_class_JsonPath_stats, ZEND_ACC_PUBLIC|ZEND_ACC_STATIC)
+	ZEND_FE_END
+};
+
+
+static const zend_function_entry class_JsonPathQuery_methods[] = {
+	ZEND_ME(JsonPathQuery, __construct, arginfo_class_JsonPathQuery___construct, ZEND_ACC_PRIVATE)
+	ZEND_ME(JsonPathQuery, find, arginfo_class_JsonPathQuery_find, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPathQuery, findPaths, arginfo_class_JsonPathQuery_findPaths, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPathQuery, findInJson, arginfo_class_JsonPathQuery_findInJson, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPathQuery, first, arginfo_class_JsonPathQuery_first, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPathQuery, exists, arginfo_class_JsonPathQuery_exists, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPathQuery, iterate, arginfo_class_JsonPathQuery_iterate, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPathQuery, set, arginfo_class_JsonPathQuery_set, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPathQuery, update, arginfo_class_JsonPathQuery_update, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPathQuery, delete, arginfo_class_JsonPathQuery_delete, ZEND_ACC_PUBLIC)
+	ZEND_FE_END
+};
+
+
+static const zend_function_entry class_JsonPathIndex_methods[] = {
+	ZEND_ME(JsonPathIndex, __construct, arginfo_class_JsonPathIndex___construct, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPathIndex, get, arginfo_class_JsonPathIndex_get, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPathIndex, find, arginfo_class_JsonPathIndex_find, ZEND_ACC_PUBLIC)
+	ZEND_FE_END
+};
+
+
+static const zend_function_entry class_JsonPathIterator_methods[] = {
+	ZEND_ME(JsonPathIterator, __construct, arginfo_class_JsonPathIterator___construct, ZEND_ACC_PRIVATE)
+	ZEND_ME(JsonPathIterator, current, arginfo_class_JsonPathIterator_current, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPathIterator, key, arginfo_class_JsonPathIterator_key, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPathIterator, next, arginfo_class_JsonPathIterator_next, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPathIterator, rewind, arginfo_class_JsonPathIterator_rewind, ZEND_ACC_PUBLIC)
+	ZEND_ME(JsonPathIterator, valid, arginfo_class_JsonPathIterator_valid, ZEND_ACC_PUBLIC)
 	ZEND_FE_END
 };
@@ -34,25 +34,23 @@ extern zend_module_entry jsonpath_module_entry;
 #	define PHP_JSONPATH_API
 #endif
 
-/* 
-  	Declare any global variables you may need between the BEGIN
-	and END macros here:     
+#include "src/jsonpath/cache.h"
+#include "src/jsonpath/stats.h"
 
 ZEND_BEGIN_MODULE_GLOBALS(jsonpath)
-	long  global_value;
-	char *global_string;
+	zend_long cache_size;
+	struct query_cache query_cache;
+	struct jsonpath_stats stats; /* the current request */
+	struct regex* pinned_regexes; /* the regexes whose compiled pattern the current request pinned */
 ZEND_END_MODULE_GLOBALS(jsonpath)
-*/
 
-/* In every utility function you add that needs to use variables 
-   in php_jsonpath_globals, call TSRMLS_FETCH(); after declaring other 
-   variables used by that function, or better yet, pass in TSRMLS_CC
-   after the last function argument and declare your utility function
-   with TSRMLS_DC after the last declared argument.  Always refer to
-   the globals in your function as JSONPATH_G(variable).  You are 
-   encouraged to rename these macros something shorter, see
-   examples in any other php module directory.
-*/
+ZEND_EXTERN_MODULE_GLOBALS(jsonpath)
+
+#define JSONPATH_G(v) ZEND_MODULE_GLOBALS_ACCESSOR(jsonpath, v)
+
+#if defined(ZTS) && defined(COMPILE_DL_JSONPATH)
+ZEND_TSRMLS_CACHE_EXTERN()
+#endif
 
 #endif	/* PHP_JSONPATH_H */
 
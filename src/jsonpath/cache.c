@@ -0,0 +1,119 @@
+#include "cache.h"
+
+static void cache_entry_free(struct cache_entry* entry);
+static void cache_link_head(struct query_cache* cache, struct cache_entry* entry);
+static void cache_unlink(struct query_cache* cache, struct cache_entry* entry);
+
+void cache_init(struct query_cache* cache) {
+  zend_hash_init(&cache->entries, 0, NULL, NULL, 1);
+  cache->head = NULL;
+  cache->tail = NULL;
+  cache->hits = 0;
+  cache->misses = 0;
+  cache->evictions = 0;
+}
+
+void cache_destroy(struct query_cache* cache) {
+  struct cache_entry* entry = cache->head;
+
+  while (entry != NULL) {
+    struct cache_entry* next = entry->next;
+    cache_entry_free(entry);
+    entry = next;
+  }
+
+  zend_hash_destroy(&cache->entries);
+
+  cache->head = NULL;
+  cache->tail = NULL;
+}
+
+/* Look up a compiled query and mark it as the most recently used entry */
+struct cache_entry* cache_find(struct query_cache* cache, const char* key, size_t key_len) {
+  struct cache_entry* entry = zend_hash_str_find_ptr(&cache->entries, key, key_len);
+
+  if (entry == NULL) {
+    cache->misses++;
+    return NULL;
+  }
+
+  cache->hits++;
+
+  if (entry != cache->head) {
+    cache_unlink(cache, entry);
+    cache_link_head(cache, entry);
+  }
+
+  return entry;
+}
+
+/* Store a compiled query (or a compilation error), evicting the least recently used entries */
+/* to stay within capacity. The cache takes over the reference to the persistent plan, and the error. An evicted */
+/* plan is only freed once the calls evaluating it have released it too. */
+struct cache_entry* cache_add(struct query_cache* cache, zend_long capacity, const char* key, size_t key_len,
+                              struct query_plan* plan, zend_string* error) {
+  while (cache->tail != NULL && (zend_long)zend_hash_num_elements(&cache->entries) >= capacity) {
+    struct cache_entry* lru = cache->tail;
+
+    zend_hash_del(&cache->entries, lru->key);
+    cache_unlink(cache, lru);
+    cache_entry_free(lru);
+    cache->evictions++;
+  }
+
+  struct cache_entry* entry = pemalloc(sizeof(struct cache_entry), 1);
+
+  entry->key = zend_string_init(key, key_len, 1);
+  entry->plan = plan;
+  entry->error = error;
+
+  zend_hash_add_ptr(&cache->entries, entry->key, entry);
+  cache_link_head(cache, entry);
+
+  return entry;
+}
+
+static void cache_entry_free(struct cache_entry* entry) {
+  if (entry->plan != NULL) {
+    plan_release(entry->plan);
+  }
+
+  if (entry->error != NULL) {
+    zend_string_release_ex(entry->error, 1);
+  }
+
+  zend_string_release_ex(entry->key, 1);
+  pefree(entry, 1);
+}
+
+static void cache_link_head(struct query_cache* cache, struct cache_entry* entry) {
+  entry->prev = NULL;
+  entry->next = cache->head;
+
+  if (cache->head != NULL) {
+    cache->head->prev = entry;
+  }
+
+  cache->head = entry;
+
+  if (cache->tail == NULL) {
+    cache->tail = entry;
+  }
+}
+
+static void cache_unlink(struct query_cache* cache, struct cache_entry* entry) {
+  if (entry->prev != NULL) {
+    entry->prev->next = entry->next;
+  } else {
+    cache->head = entry->next;
+  }
+
+  if (entry->next != NULL) {
+    entry->next->prev = entry->prev;
+  } else {
+    cache->tail = entry->prev;
+  }
+
+  entry->prev = NULL;
+  entry->next = NULL;
+}
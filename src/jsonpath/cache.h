@@ -0,0 +1,33 @@
+#ifndef CACHE_H
+#define CACHE_H 1
+
+#include "parser.h"
+#include "php.h"
+
+/* A compiled JSONPath expression, or the error message of an expression that failed to compile */
+struct cache_entry {
+  struct cache_entry* prev;
+  struct cache_entry* next;
+  zend_string* key;
+  struct query_plan* plan;
+  zend_string* error;
+};
+
+/* LRU cache of compiled queries, keyed by the expression string. It lives in the module globals as long as the */
+/* process, or as long as the thread under ZTS: every thread has a cache of its own and never waits for another. */
+struct query_cache {
+  HashTable entries;
+  struct cache_entry* head; /* most recently used */
+  struct cache_entry* tail; /* least recently used */
+  zend_ulong hits;
+  zend_ulong misses;
+  zend_ulong evictions;
+};
+
+void cache_init(struct query_cache* cache);
+void cache_destroy(struct query_cache* cache);
+struct cache_entry* cache_find(struct query_cache* cache, const char* key, size_t key_len);
+struct cache_entry* cache_add(struct query_cache* cache, zend_long capacity, const char* key, size_t key_len,
+                              struct query_plan* plan, zend_string* error);
+
+#endif /* CACHE_H */
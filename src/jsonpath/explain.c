@@ -0,0 +1,386 @@
+#include "explain.h"
+
+#include <ctype.h>
+#include <zend_smart_str.h>
+
+#include "filter.h"
+#include "regex.h"
+
+/* Describes a compiled plan as PHP arrays, for JsonPath::explain() and JsonPath::profile(). Each segment of the */
+/* query is listed with the decisions the compiler made for it, and a filter with the instructions it was */
+/* compiled to, in the order they run. Nothing returned points into the plan, which may be freed right after. */
+
+/* Names of the filter opcodes, in the order of enum filter_opcode */
+static const char* FILTER_OPCODE_STR[] = {"const", "cur", "root", "exists", "missing", "is_true",
+                                          "is_false", "not", "eq", "ne", "lt", "lte",
+                                          "gt", "gte", "rgxp", "match", "jmp_false", "jmp_true"};
+
+static void render_segment(smart_str* buf, struct ast_node* tok, bool after_descent);
+static void render_expression(smart_str* buf, struct ast_node* tok);
+
+/* Keys the dot notation can express, the others are rendered in brackets */
+static bool is_dot_name(zend_string* key) {
+  if (ZSTR_LEN(key) == 0) {
+    return false;
+  }
+
+  for (size_t i = 0; i < ZSTR_LEN(key); i++) {
+    unsigned char c = (unsigned char)ZSTR_VAL(key)[i];
+
+    if (!isalnum(c) && c != '_' && c != '-') {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* Quote a string, the lexer has no escapes so the quote it doesn't contain is used */
+static void render_string(smart_str* buf, zend_string* str) {
+  char quote = memchr(ZSTR_VAL(str), '\'', ZSTR_LEN(str)) != NULL ? '"' : '\'';
+
+  smart_str_appendc(buf, quote);
+  smart_str_append(buf, str);
+  smart_str_appendc(buf, quote);
+}
+
+/* Render a float so it reads back as the same float, and not as an integer: == is strict */
+static void render_double(smart_str* buf, double value) {
+  char num[64];
+
+  snprintf(num, sizeof(num), "%.15g", value);
+  if (zend_strtod(num, NULL) != value) {
+    snprintf(num, sizeof(num), "%.17g", value);
+  }
+
+  smart_str_appends(buf, num);
+
+  if (strpbrk(num, ".eEn") == NULL) {
+    smart_str_appendl(buf, ".0", 2);
+  }
+}
+
+static void render_path(smart_str* buf, struct ast_node* tok) {
+  bool after_descent = false;
+
+  smart_str_appendc(buf, tok->type == AST_ROOT ? '$' : '@');
+
+  for (; tok != NULL; tok = tok->next) {
+    if (tok->type != AST_ROOT) {
+      render_segment(buf, tok, after_descent);
+      after_descent = tok->type == AST_RECURSE;
+    }
+  }
+}
+
+/* Render a segment as written in a query. Directly after .. the dot of a name or wildcard is left out. */
+static void render_segment(smart_str* buf, struct ast_node* tok, bool after_descent) {
+  switch (tok->type) {
+    case AST_SELECTOR:
+      if (is_dot_name(tok->data.d_selector.key)) {
+        if (!after_descent) {
+          smart_str_appendc(buf, '.');
+        }
+        smart_str_append(buf, tok->data.d_selector.key);
+      } else {
+        smart_str_appendc(buf, '[');
+        render_string(buf, tok->data.d_selector.key);
+        smart_str_appendc(buf, ']');
+      }
+      break;
+    case AST_WILD_CARD:
+      smart_str_appends(buf, after_descent ? "*" : "[*]");
+      break;
+    case AST_RECURSE:
+      smart_str_appendl(buf, "..", 2);
+      break;
+    case AST_INDEX_LIST:
+      smart_str_appendc(buf, '[');
+      for (int i = 0; i < tok->data.d_list.count; i++) {
+        if (i > 0) {
+          smart_str_appendc(buf, ',');
+        }
+        smart_str_append_long(buf, tok->data.d_list.indexes[i]);
+      }
+      smart_str_appendc(buf, ']');
+      break;
+    case AST_INDEX_SLICE:
+      smart_str_appendc(buf, '[');
+      for (int i = 0; i < tok->data.d_list.count || i < 2; i++) {
+        if (i > 0) {
+          smart_str_appendc(buf, ':');
+        }
+        if (i < tok->data.d_list.count && tok->data.d_list.indexes[i] != ZEND_LONG_MAX) {
+          smart_str_append_long(buf, tok->data.d_list.indexes[i]);
+        }
+      }
+      smart_str_appendc(buf, ']');
+      break;
+    case AST_EXPR:
+      smart_str_appendl(buf, "[?(", 3);
+      render_expression(buf, tok->data.d_expression.head);
+      smart_str_appendl(buf, ")]", 2);
+      break;
+    default:
+      break;
+  }
+}
+
+static const char* operator_str(enum ast_type type) {
+  switch (type) {
+    case AST_AND:
+      return "&&";
+    case AST_OR:
+      return "||";
+    case AST_EQ:
+      return "==";
+    case AST_NE:
+      return "!=";
+    case AST_LT:
+      return "<";
+    case AST_LTE:
+      return "<=";
+    case AST_GT:
+      return ">";
+    case AST_GTE:
+      return ">=";
+    default:
+      return "=~";
+  }
+}
+
+/* Render an operand of parent, parenthesized where the precedence of the operators requires it */
+static void render_operand(smart_str* buf, struct ast_node* tok, enum ast_type parent) {
+  bool logical = tok->type == AST_AND || tok->type == AST_OR;
+  bool paren = (parent == AST_AND || parent == AST_OR) ? logical && tok->type != parent : is_binary(tok->type);
+
+  if (paren) {
+    smart_str_appendc(buf, '(');
+  }
+
+  render_expression(buf, tok);
+
+  if (paren) {
+    smart_str_appendc(buf, ')');
+  }
+}
+
+static void render_expression(smart_str* buf, struct ast_node* tok) {
+  switch (tok->type) {
+    case AST_ROOT:
+    case AST_SELECTOR:
+      render_path(buf, tok);
+      break;
+    case AST_NEGATION:
+      smart_str_appendc(buf, '!');
+      render_operand(buf, tok->data.d_unary.right, AST_NEGATION);
+      break;
+    case AST_LITERAL:
+      render_string(buf, tok->data.d_literal.value);
+      break;
+    case AST_LONG:
+      smart_str_append_long(buf, tok->data.d_long.value);
+      break;
+    case AST_DOUBLE:
+      render_double(buf, tok->data.d_double.value);
+      break;
+    case AST_BOOL:
+      smart_str_appends(buf, tok->data.d_literal.value_bool ? "true" : "false");
+      break;
+    case AST_NULL:
+      smart_str_appendl(buf, "null", 4);
+      break;
+    default:
+      if (is_binary(tok->type)) {
+        render_operand(buf, tok->data.d_binary.left, tok->type);
+        smart_str_appendc(buf, ' ');
+        smart_str_appends(buf, operator_str(tok->type));
+        smart_str_appendc(buf, ' ');
+        render_operand(buf, tok->data.d_binary.right, tok->type);
+      }
+      break;
+  }
+}
+
+static zend_string* path_string(struct ast_node* tok) {
+  smart_str buf = {0};
+
+  render_path(&buf, tok);
+  smart_str_0(&buf);
+
+  return buf.s;
+}
+
+/* Describe an instruction of a filter program, registers as numbers and jumps by the index of their target */
+static void explain_op(struct filter_program* program, struct filter_op* op, zval* entry) {
+  zval* constant;
+
+  array_init(entry);
+  add_assoc_string(entry, "op", (char*)FILTER_OPCODE_STR[op->opcode]);
+  add_assoc_long(entry, "dst", op->dst);
+
+  switch (op->opcode) {
+    case FILTER_CONST:
+      constant = &program->constants[op->lhs];
+      if (Z_TYPE_P(constant) == IS_STRING) {
+        /* the plan's strings live as long as the plan */
+        add_assoc_stringl(entry, "value", Z_STRVAL_P(constant), Z_STRLEN_P(constant));
+      } else {
+        add_assoc_zval(entry, "value", constant);
+      }
+      break;
+    case FILTER_CUR:
+    case FILTER_ROOT:
+      add_assoc_str(entry, "path", path_string(op->path));
+      /* a single key is looked up directly, longer paths are evaluated as queries of their own */
+      add_assoc_string(entry, "lookup",
+                       op->path->type == AST_SELECTOR && op->path->next == NULL ? "key" : "path");
+      break;
+    case FILTER_MATCH:
+      add_assoc_long(entry, "lhs", op->lhs);
+      if (op->regex == NULL) {
+        /* the pattern is invalid and never matches */
+        add_assoc_null(entry, "pattern");
+        break;
+      }
+      add_assoc_stringl(entry, "pattern", ZSTR_VAL(op->regex->pattern), ZSTR_LEN(op->regex->pattern));
+      if (op->regex->literal != NULL) {
+        add_assoc_stringl(entry, "literal", ZSTR_VAL(op->regex->literal), ZSTR_LEN(op->regex->literal));
+      } else {
+        add_assoc_null(entry, "literal");
+      }
+      add_assoc_bool(entry, "exact", op->regex->exact);
+      break;
+    case FILTER_JMP_FALSE:
+    case FILTER_JMP_TRUE:
+      add_assoc_long(entry, "target", op->rhs);
+      break;
+    case FILTER_EXISTS:
+    case FILTER_MISSING:
+    case FILTER_IS_TRUE:
+    case FILTER_IS_FALSE:
+    case FILTER_NOT:
+      add_assoc_long(entry, "lhs", op->lhs);
+      break;
+    default:
+      add_assoc_long(entry, "lhs", op->lhs);
+      add_assoc_long(entry, "rhs", op->rhs);
+      break;
+  }
+}
+
+static void explain_filter(struct ast_node* tok, zval* segment) {
+  struct filter_program* program = tok->data.d_expression.program;
+  smart_str expression = {0};
+  zval ops, entry;
+
+  render_expression(&expression, tok->data.d_expression.head);
+  smart_str_0(&expression);
+
+  add_assoc_str(segment, "expression", expression.s);
+  add_assoc_long(segment, "registers", program->reg_count);
+  /* the first instructions evaluate the $-rooted operands, once per evaluation */
+  add_assoc_long(segment, "prologue", program->prologue_count);
+
+  array_init_size(&ops, program->op_count);
+  for (uint32_t i = 0; i < program->op_count; i++) {
+    explain_op(program, &program->ops[i], &entry);
+    add_next_index_zval(&ops, &entry);
+  }
+  add_assoc_zval(segment, "program", &ops);
+}
+
+static void explain_counters(struct ast_node* tok, struct eval_profile_node* counters, zval* segment) {
+  add_assoc_long(segment, "visits", counters->visits);
+  add_assoc_long(segment, "candidates", counters->candidates);
+  add_assoc_long(segment, "matches", counters->matches);
+
+  if (tok->type == AST_EXPR) {
+    /* a filter's candidates are the elements its predicate was evaluated on */
+    add_assoc_long(segment, "evaluations", counters->candidates);
+    if (counters->candidates > 0) {
+      add_assoc_double(segment, "pass_rate", (double)counters->matches / (double)counters->candidates);
+    } else {
+      add_assoc_null(segment, "pass_rate");
+    }
+  }
+
+  add_assoc_long(segment, "time_ns", counters->time_ns);
+}
+
+static void explain_segment(struct ast_node* tok, zval* segment) {
+  smart_str text = {0};
+  zval indexes;
+
+  render_segment(&text, tok, false);
+  smart_str_0(&text);
+
+  array_init(segment);
+  add_assoc_str(segment, "segment", text.s);
+
+  switch (tok->type) {
+    case AST_SELECTOR:
+      add_assoc_string(segment, "type", "selector");
+      add_assoc_stringl(segment, "key", ZSTR_VAL(tok->data.d_selector.key), ZSTR_LEN(tok->data.d_selector.key));
+      /* numeric keys are read from their position in lists, other keys are hashed when the query is compiled */
+      add_assoc_string(segment, "lookup", tok->data.d_selector.is_index ? "index" : "key");
+      break;
+    case AST_WILD_CARD:
+      add_assoc_string(segment, "type", "wildcard");
+      break;
+    case AST_RECURSE:
+      add_assoc_string(segment, "type", "descent");
+      /* ..key is a single lookup in each container, any other segment is applied to each container */
+      add_assoc_string(segment, "lookup",
+                       tok->next != NULL && tok->next->type == AST_SELECTOR ? "key" : "segment");
+      break;
+    case AST_INDEX_LIST:
+      add_assoc_string(segment, "type", "index");
+      array_init_size(&indexes, tok->data.d_list.count);
+      for (int i = 0; i < tok->data.d_list.count; i++) {
+        add_next_index_long(&indexes, tok->data.d_list.indexes[i]);
+      }
+      add_assoc_zval(segment, "indexes", &indexes);
+      break;
+    case AST_INDEX_SLICE:
+      add_assoc_string(segment, "type", "slice");
+      for (int i = 0; i < 3; i++) {
+        static const char* bounds[] = {"start", "end", "step"};
+        if (i < tok->data.d_list.count && tok->data.d_list.indexes[i] != ZEND_LONG_MAX) {
+          add_assoc_long(segment, bounds[i], tok->data.d_list.indexes[i]);
+        } else {
+          add_assoc_null(segment, bounds[i]);
+        }
+      }
+      break;
+    case AST_EXPR:
+      add_assoc_string(segment, "type", "filter");
+      explain_filter(tok, segment);
+      break;
+    default:
+      break;
+  }
+}
+
+/* Add the segments of plan to result, an array, with the counters of profile if it isn't NULL */
+void explain_plan(struct query_plan* plan, struct eval_profile* profile, zval* result) {
+  zval segments, segment;
+
+  array_init(&segments);
+
+  for (struct ast_node* tok = plan->head; tok != NULL; tok = tok->next) {
+    if (tok->type == AST_ROOT) {
+      continue;
+    }
+
+    explain_segment(tok, &segment);
+
+    if (profile != NULL) {
+      explain_counters(tok, &profile->counters[tok - profile->nodes], &segment);
+    }
+
+    add_next_index_zval(&segments, &segment);
+  }
+
+  add_assoc_zval(result, "segments", &segments);
+}
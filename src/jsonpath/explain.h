@@ -0,0 +1,10 @@
+#ifndef EXPLAIN_H
+#define EXPLAIN_H 1
+
+#include "interpreter.h"
+#include "parser.h"
+#include "php.h"
+
+void explain_plan(struct query_plan* plan, struct eval_profile* profile, zval* result);
+
+#endif /* EXPLAIN_H */
@@ -0,0 +1,435 @@
+#include "filter.h"
+
+/* Compiles filter expressions into register code, so evaluating a filter against an element is a single loop */
+/* over the instructions instead of a recursive walk of the expression tree. The generated code does what the */
+/* tree walk did: a bare @.path tests whether the path exists, and a negated literal or $.path is true only if it */
+/* is false. Chains of && and || stop at the first operand that decides the result, with the operands reordered */
+/* so the cheapest ones run first. Matching a pattern only known at run time can raise a warning, so operands that */
+/* do keep their place in the chain, and no operand is moved past them: a warning is raised exactly when it would */
+/* be with the operands in the order they were written. */
+/* $-rooted operands don't depend on the element being filtered. They are evaluated by a prologue into registers */
+/* of their own, once per evaluation, the first time the filter is applied. A $-rooted path with a filter that can */
+/* warn isn't: the prologue would evaluate it even where the chain never reaches it, so it's evaluated in place. */
+
+/* Estimated cost of evaluating an operand, from cheapest to most expensive */
+enum filter_cost {
+  COST_EXISTS,   /* literals, single path lookups and $-rooted paths, which are mostly evaluated by the prologue */
+  COST_SCALAR,   /* comparisons that don't involve a string literal */
+  COST_STRING,   /* comparisons with a string literal */
+  COST_REGEX,    /* regular expression matches */
+  COST_SUBQUERY, /* paths with a filter of their own */
+};
+
+struct filter_compiler {
+  struct filter_program* program; /* NULL while sizing the program */
+  uint32_t op_count;
+  uint32_t constant_count;
+  uint32_t reg_count;  /* registers used for intermediate values */
+  uint32_t root_base;  /* first register of the $-rooted operands, once the program is sized */
+  struct ast_node** roots;
+  uint32_t root_count;
+  uint32_t root_capacity;
+};
+
+static void compile_node(struct filter_compiler* c, struct ast_node* tok, uint32_t dst);
+static bool node_warns(struct ast_node* tok);
+
+static void emit(struct filter_compiler* c, enum filter_opcode opcode, uint32_t dst, uint32_t lhs, uint32_t rhs,
+                 struct ast_node* path) {
+  if (c->program != NULL) {
+    c->program->ops[c->op_count] = (struct filter_op){opcode, dst, lhs, rhs, path, NULL};
+  }
+
+  c->op_count++;
+
+  if (dst >= c->reg_count) {
+    c->reg_count = dst + 1;
+  }
+}
+
+/* Point the jump at instruction op to the next instruction to be emitted */
+static void patch_jump(struct filter_compiler* c, uint32_t op) {
+  if (c->program != NULL) {
+    c->program->ops[op].rhs = c->op_count;
+  }
+}
+
+/* Build the value of a literal operand, strings are borrowed from the plan, which holds their reference */
+void filter_literal(struct ast_node* tok, zval* value) {
+  switch (tok->type) {
+    case AST_BOOL:
+      ZVAL_BOOL(value, tok->data.d_literal.value_bool);
+      break;
+    case AST_DOUBLE:
+      ZVAL_DOUBLE(value, tok->data.d_double.value);
+      break;
+    case AST_LITERAL:
+      ZVAL_STR(value, tok->data.d_literal.value);
+      break;
+    case AST_LONG:
+      ZVAL_LONG(value, tok->data.d_long.value);
+      break;
+    default:
+      ZVAL_NULL(value);
+      break;
+  }
+}
+
+static void emit_constant(struct filter_compiler* c, struct ast_node* tok, uint32_t dst) {
+  if (c->program != NULL) {
+    filter_literal(tok, &c->program->constants[c->constant_count]);
+  }
+
+  emit(c, FILTER_CONST, dst, c->constant_count++, 0, NULL);
+}
+
+/* Get the register of a $-rooted operand, adding its evaluation to the prologue unless the same path already is */
+static uint32_t root_register(struct filter_compiler* c, struct ast_node* tok) {
+  for (uint32_t i = 0; i < c->root_count; i++) {
+    if (ast_chain_equal(c->roots[i], tok)) {
+      return c->root_base + i;
+    }
+  }
+
+  if (c->root_count == c->root_capacity) {
+    c->root_capacity = c->root_capacity ? c->root_capacity * 2 : 4;
+    c->roots = safe_erealloc(c->roots, c->root_capacity, sizeof(struct ast_node*), 0);
+  }
+
+  if (c->program != NULL) {
+    c->program->ops[c->root_count] = (struct filter_op){FILTER_ROOT, c->root_base + c->root_count, 0, 0, tok, NULL};
+  }
+
+  c->roots[c->root_count] = tok;
+
+  return c->root_base + c->root_count++;
+}
+
+/* Get the register holding the value of an operand, loading it into r[dst] unless it's $-rooted */
+static uint32_t compile_value(struct filter_compiler* c, struct ast_node* tok, uint32_t dst) {
+  switch (tok->type) {
+    case AST_ROOT:
+      if (node_warns(tok)) {
+        emit(c, FILTER_ROOT, dst, 0, 0, tok);
+        return dst;
+      }
+      return root_register(c, tok);
+    case AST_SELECTOR:
+      emit(c, FILTER_CUR, dst, 0, 0, tok);
+      return dst;
+    default:
+      emit_constant(c, tok, dst);
+      return dst;
+  }
+}
+
+static void compile_negation(struct filter_compiler* c, struct ast_node* tok, uint32_t dst) {
+  struct ast_node* operand = tok->data.d_unary.right;
+
+  if (is_unary(operand->type) || is_binary(operand->type)) {
+    compile_node(c, operand, dst);
+    emit(c, FILTER_NOT, dst, dst, 0, NULL);
+  } else if (operand->type == AST_SELECTOR) {
+    /* ?(!@.selector) */
+    emit(c, FILTER_MISSING, dst, compile_value(c, operand, dst), 0, NULL);
+  } else {
+    emit(c, FILTER_IS_FALSE, dst, compile_value(c, operand, dst), 0, NULL);
+  }
+}
+
+/* Load an operand of && or || into r[dst] as a boolean. @.paths test existence, other values must be true. */
+static void compile_condition(struct filter_compiler* c, struct ast_node* operand, uint32_t dst) {
+  if (is_binary(operand->type) || is_unary(operand->type)) {
+    compile_node(c, operand, dst);
+  } else if (operand->type == AST_SELECTOR) {
+    /* ?(@.selector <or|and> [operand]) */
+    emit(c, FILTER_EXISTS, dst, compile_value(c, operand, dst), 0, NULL);
+  } else {
+    emit(c, FILTER_IS_TRUE, dst, compile_value(c, operand, dst), 0, NULL);
+  }
+}
+
+/* Get the register holding an operand of a comparison, see compile_value() */
+static uint32_t compile_operand(struct filter_compiler* c, struct ast_node* operand, uint32_t dst) {
+  if (is_binary(operand->type) || is_unary(operand->type)) {
+    compile_node(c, operand, dst);
+    return dst;
+  }
+
+  return compile_value(c, operand, dst);
+}
+
+static enum filter_cost path_cost(struct ast_node* tok) {
+  if (tok->type == AST_ROOT) {
+    return COST_EXISTS;
+  }
+
+  for (; tok != NULL; tok = tok->next) {
+    if (tok->type != AST_SELECTOR) {
+      return COST_SUBQUERY;
+    }
+  }
+
+  return COST_EXISTS;
+}
+
+static enum filter_cost node_cost(struct ast_node* tok) {
+  enum filter_cost cost, rhs_cost;
+
+  switch (tok->type) {
+    case AST_ROOT:
+    case AST_SELECTOR:
+      return path_cost(tok);
+    case AST_NEGATION:
+      return node_cost(tok->data.d_unary.right);
+    case AST_AND:
+    case AST_OR:
+    case AST_EQ:
+    case AST_NE:
+    case AST_LT:
+    case AST_LTE:
+    case AST_GT:
+    case AST_GTE:
+    case AST_RGXP:
+      cost = node_cost(tok->data.d_binary.left);
+      rhs_cost = node_cost(tok->data.d_binary.right);
+      cost = MAX(cost, rhs_cost);
+
+      if (tok->type == AST_RGXP) {
+        cost = MAX(cost, COST_REGEX);
+      } else if (tok->type != AST_AND && tok->type != AST_OR) {
+        bool string = tok->data.d_binary.left->type == AST_LITERAL || tok->data.d_binary.right->type == AST_LITERAL;
+        cost = MAX(cost, string ? COST_STRING : COST_SCALAR);
+      }
+
+      return cost;
+    default:
+      return COST_EXISTS;
+  }
+}
+
+/* Whether evaluating tok can raise a warning, i.e. it matches a pattern that is only known at run time */
+static bool node_warns(struct ast_node* tok) {
+  switch (tok->type) {
+    case AST_ROOT:
+    case AST_SELECTOR:
+      for (tok = tok->next; tok != NULL; tok = tok->next) {
+        if (tok->type == AST_EXPR && tok->data.d_expression.head != NULL && node_warns(tok->data.d_expression.head)) {
+          return true;
+        }
+      }
+      return false;
+    case AST_NEGATION:
+      return node_warns(tok->data.d_unary.right);
+    case AST_RGXP:
+      if (tok->data.d_binary.right->type != AST_LITERAL) {
+        return true;
+      }
+      return node_warns(tok->data.d_binary.left);
+    case AST_AND:
+    case AST_OR:
+    case AST_EQ:
+    case AST_NE:
+    case AST_LT:
+    case AST_LTE:
+    case AST_GT:
+    case AST_GTE:
+      return node_warns(tok->data.d_binary.left) || node_warns(tok->data.d_binary.right);
+    default:
+      return false;
+  }
+}
+
+/* Collect the operands of a chain of && (or ||), e.g. the three operands of a && (b && c) */
+static void collect_chain(struct ast_node* tok, enum ast_type type, struct ast_node*** operands, uint32_t* count,
+                          uint32_t* capacity) {
+  if (tok->type == type) {
+    collect_chain(tok->data.d_binary.left, type, operands, count, capacity);
+    collect_chain(tok->data.d_binary.right, type, operands, count, capacity);
+    return;
+  }
+
+  if (*count == *capacity) {
+    *capacity *= 2;
+    *operands = safe_erealloc(*operands, *capacity, sizeof(struct ast_node*), 0);
+  }
+
+  (*operands)[(*count)++] = tok;
+}
+
+/* Compile a chain of && or || into r[dst], jumping past the remaining operands once the result is known */
+static void compile_chain(struct filter_compiler* c, struct ast_node* tok, uint32_t dst) {
+  uint32_t count = 0, capacity = 8;
+  struct ast_node** operands = safe_emalloc(capacity, sizeof(struct ast_node*), 0);
+  enum filter_opcode jump = tok->type == AST_AND ? FILTER_JMP_FALSE : FILTER_JMP_TRUE;
+
+  collect_chain(tok, tok->type, &operands, &count, &capacity);
+
+  /* stable insertion sort by cost, operands of the same cost keep their order and operands that can warn stay put */
+  for (uint32_t i = 1; i < count; i++) {
+    struct ast_node* operand = operands[i];
+
+    if (node_warns(operand)) {
+      continue;
+    }
+
+    enum filter_cost cost = node_cost(operand);
+    uint32_t j = i;
+
+    while (j > 0 && !node_warns(operands[j - 1]) && node_cost(operands[j - 1]) > cost) {
+      operands[j] = operands[j - 1];
+      j--;
+    }
+
+    operands[j] = operand;
+  }
+
+  uint32_t* jumps = safe_emalloc(count, sizeof(uint32_t), 0);
+
+  for (uint32_t i = 0; i < count; i++) {
+    compile_condition(c, operands[i], dst);
+
+    if (i + 1 < count) {
+      jumps[i] = c->op_count;
+      emit(c, jump, dst, 0, 0, NULL);
+    }
+  }
+
+  for (uint32_t i = 0; i + 1 < count; i++) {
+    patch_jump(c, jumps[i]);
+  }
+
+  efree(jumps);
+  efree(operands);
+}
+
+static enum filter_opcode binary_opcode(enum ast_type type) {
+  switch (type) {
+    case AST_EQ:
+      return FILTER_EQ;
+    case AST_GT:
+      return FILTER_GT;
+    case AST_GTE:
+      return FILTER_GTE;
+    case AST_LT:
+      return FILTER_LT;
+    case AST_LTE:
+      return FILTER_LTE;
+    case AST_NE:
+      return FILTER_NE;
+    default:
+      ZEND_ASSERT(type == AST_RGXP);
+      return FILTER_RGXP;
+  }
+}
+
+/* Match r[lhs] against a literal pattern, resolved now rather than on every match. An invalid pattern raises its */
+/* warning once, here, and never matches. */
+static void emit_match(struct filter_compiler* c, uint32_t dst, uint32_t lhs, struct ast_node* pattern) {
+  emit(c, FILTER_MATCH, dst, lhs, 0, NULL);
+
+  if (c->program != NULL) {
+    c->program->ops[c->op_count - 1].regex = regex_compile(pattern->data.d_literal.value);
+  }
+}
+
+/* Compile a boolean expression into r[dst], using the registers above dst for intermediate values */
+static void compile_node(struct filter_compiler* c, struct ast_node* tok, uint32_t dst) {
+  if (tok->type == AST_AND || tok->type == AST_OR) {
+    compile_chain(c, tok, dst);
+  } else if (tok->type == AST_RGXP && tok->data.d_binary.right->type == AST_LITERAL) {
+    emit_match(c, dst, compile_operand(c, tok->data.d_binary.left, dst), tok->data.d_binary.right);
+  } else if (is_binary(tok->type)) {
+    uint32_t lhs = compile_operand(c, tok->data.d_binary.left, dst);
+    uint32_t rhs = compile_operand(c, tok->data.d_binary.right, dst + 1);
+    emit(c, binary_opcode(tok->type), dst, lhs, rhs, NULL);
+  } else if (is_unary(tok->type)) {
+    compile_negation(c, tok, dst);
+  } else {
+    /* ?(@.selector) */
+    emit(c, FILTER_EXISTS, dst, compile_value(c, tok, dst), 0, NULL);
+  }
+}
+
+static struct filter_program* filter_compile(struct query_plan* plan, struct ast_node* head) {
+  struct filter_compiler c = {0};
+
+  /* size the program, then allocate it in the pool and generate it. the prologue comes first, and the */
+  /* registers of the $-rooted operands follow the ones for intermediate values. */
+  compile_node(&c, head, 0);
+
+  uint32_t op_count = c.root_count + c.op_count;
+  size_t header_size = ZEND_MM_ALIGNED_SIZE(sizeof(struct filter_program));
+  size_t ops_size = op_count * sizeof(struct filter_op);
+  char* mem = plan_pool_alloc(plan, header_size + ops_size + c.constant_count * sizeof(zval));
+
+  if (mem == NULL) {
+    /* the plan is too small and fails to compile */
+    if (c.roots != NULL) {
+      efree(c.roots);
+    }
+    return NULL;
+  }
+
+  c.program = (struct filter_program*)mem;
+  c.program->ops = (struct filter_op*)(mem + header_size);
+  c.program->constants = (zval*)(mem + header_size + ops_size);
+  c.program->op_count = op_count;
+  c.program->prologue_count = c.root_count;
+  c.program->constant_count = c.constant_count;
+  c.program->reg_count = c.reg_count + c.root_count;
+
+  c.root_base = c.reg_count;
+  c.op_count = c.root_count;
+  c.constant_count = 0;
+  c.root_count = 0;
+  compile_node(&c, head, 0);
+
+  if (c.roots != NULL) {
+    efree(c.roots);
+  }
+
+  return c.program;
+}
+
+/* Compile every filter expression of a validated plan, including the ones nested in other filters */
+void filter_compile_plan(struct query_plan* plan) {
+  for (int i = 0; i < plan->node_count; i++) {
+    struct ast_node* node = &plan->nodes[i];
+
+    if (node->type == AST_EXPR) {
+      node->data.d_expression.program = filter_compile(plan, node->data.d_expression.head);
+    }
+  }
+}
+
+/* The regexes of a program are shared by the copies of its plan */
+void filter_retain(struct filter_program* program) {
+  for (uint32_t i = 0; i < program->op_count; i++) {
+    if (program->ops[i].regex != NULL) {
+      regex_retain(program->ops[i].regex);
+    }
+  }
+}
+
+void filter_release(struct filter_program* program) {
+  for (uint32_t i = 0; i < program->op_count; i++) {
+    if (program->ops[i].regex != NULL) {
+      regex_release(program->ops[i].regex);
+    }
+  }
+}
+
+#define RELOCATE(ptr, delta) ((ptr) = (ptr) == NULL ? NULL : (void*)((char*)(ptr) + (delta)))
+
+/* Shift the pointers of a program copied along with its plan, see plan_relocate() */
+void filter_relocate(struct filter_program* program, ptrdiff_t delta) {
+  RELOCATE(program->ops, delta);
+  RELOCATE(program->constants, delta);
+
+  for (uint32_t i = 0; i < program->op_count; i++) {
+    RELOCATE(program->ops[i].path, delta);
+  }
+}
+
+#undef RELOCATE
@@ -0,0 +1,64 @@
+#ifndef FILTER_H
+#define FILTER_H 1
+
+#include <stdint.h>
+
+#include "parser.h"
+#include "php.h"
+#include "regex.h"
+
+/* Instructions of a compiled filter expression, operating on a file of registers. r[n] is register n. */
+enum filter_opcode {
+  FILTER_CONST,     /* r[dst] = constants[lhs] */
+  FILTER_CUR,       /* r[dst] = first value path selects from the element being filtered, undefined if none */
+  FILTER_ROOT,      /* r[dst] = first value path selects from the root, in the prologue unless path can warn */
+  FILTER_EXISTS,    /* r[dst] = r[lhs] is defined */
+  FILTER_MISSING,   /* r[dst] = r[lhs] is undefined */
+  FILTER_IS_TRUE,   /* r[dst] = r[lhs] === true */
+  FILTER_IS_FALSE,  /* r[dst] = r[lhs] === false */
+  FILTER_NOT,       /* r[dst] = !r[lhs] */
+  FILTER_EQ,        /* r[dst] = r[lhs] === r[rhs] */
+  FILTER_NE,
+  FILTER_LT,
+  FILTER_LTE,
+  FILTER_GT,
+  FILTER_GTE,
+  FILTER_RGXP,      /* r[dst] = r[lhs] matches the pattern r[rhs] */
+  FILTER_MATCH,     /* r[dst] = r[lhs] matches regex, a pattern resolved at compile time */
+  FILTER_JMP_FALSE, /* continue at instruction rhs if r[dst] is false */
+  FILTER_JMP_TRUE,  /* continue at instruction rhs if r[dst] is true */
+};
+
+struct filter_op {
+  enum filter_opcode opcode;
+  uint32_t dst;
+  uint32_t lhs;
+  uint32_t rhs;          /* the jump target of FILTER_JMP_FALSE and FILTER_JMP_TRUE */
+  struct ast_node* path; /* FILTER_CUR and FILTER_ROOT */
+  struct regex* regex;   /* FILTER_MATCH, NULL if the pattern isn't valid */
+};
+
+/* A filter expression flattened into a list of instructions, stored in the plan's pool. Literals are prebuilt */
+/* zvals in the constant pool, their strings are borrowed from the plan. The result is left in r[0]. */
+/* The first prologue_count instructions evaluate the $-rooted operands, which are the same for every element. */
+struct filter_program {
+  struct filter_op* ops;
+  zval* constants;
+  uint32_t op_count;
+  uint32_t prologue_count;
+  uint32_t constant_count;
+  uint32_t reg_count;
+};
+
+/* Upper bounds for a plan of n tokens, used to size the plan's pool */
+#define FILTER_POOL_SIZE(n)                                                                                  \
+  ((n) * (2 * sizeof(struct filter_op) + sizeof(zval) + ZEND_MM_ALIGNED_SIZE(sizeof(struct filter_program)) + \
+          ZEND_MM_ALIGNMENT))
+
+void filter_compile_plan(struct query_plan* plan);
+void filter_literal(struct ast_node* tok, zval* value);
+void filter_relocate(struct filter_program* program, ptrdiff_t delta);
+void filter_retain(struct filter_program* program);
+void filter_release(struct filter_program* program);
+
+#endif /* FILTER_H */
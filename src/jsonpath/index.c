@@ -0,0 +1,191 @@
+#include "index.h"
+
+#include "filter.h"
+#include "php_jsonpath.h"
+
+/* Groups the members of a collection by the value of a key, so a filter comparing the key with a literal is a */
+/* hash lookup instead of a scan of the collection. Keys are compared the way the filter's == compares them, */
+/* i.e. strictly: 1, 1.0 and "1" are different keys. A member whose key is missing or isn't a scalar can't be */
+/* equal to a literal, so it isn't indexed. */
+
+/* Key of a float, boolean or null in the scalars table: its type followed by the bytes of the float */
+static zend_string* scalar_key(zval* value) {
+  char buf[1 + sizeof(double)] = {0};
+
+  buf[0] = (char)Z_TYPE_P(value);
+
+  if (Z_TYPE_P(value) == IS_DOUBLE) {
+    /* -0.0 === 0.0 */
+    double d = Z_DVAL_P(value) == 0 ? 0 : Z_DVAL_P(value);
+    memcpy(buf + 1, &d, sizeof(double));
+  }
+
+  return zend_string_init(buf, sizeof(buf), 0);
+}
+
+/* Look up the group of a key, adding an empty one if add is set. Returns NULL if there's no group, or if no */
+/* literal is identical to the key. */
+static zval* key_group(struct path_index* index, zval* key, bool add) {
+  zend_string* str;
+  zval* group;
+  zval empty;
+
+  ZVAL_DEREF(key);
+
+  switch (Z_TYPE_P(key)) {
+    case IS_LONG:
+      if ((group = zend_hash_index_find(&index->members, Z_LVAL_P(key))) == NULL && add) {
+        array_init(&empty);
+        group = zend_hash_index_add_new(&index->members, Z_LVAL_P(key), &empty);
+      }
+      return group;
+    case IS_STRING:
+      /* not a symtable, "1" and 1 are different keys */
+      if ((group = zend_hash_find(&index->members, Z_STR_P(key))) == NULL && add) {
+        array_init(&empty);
+        group = zend_hash_add_new(&index->members, Z_STR_P(key), &empty);
+      }
+      return group;
+    case IS_DOUBLE:
+      if (zend_isnan(Z_DVAL_P(key))) {
+        return NULL;
+      }
+      /* fallthrough */
+    case IS_NULL:
+    case IS_FALSE:
+    case IS_TRUE:
+      str = scalar_key(key);
+      if ((group = zend_hash_find(&index->scalars, str)) == NULL && add) {
+        array_init(&empty);
+        group = zend_hash_add_new(&index->scalars, str, &empty);
+      }
+      zend_string_release(str);
+      return group;
+    default:
+      return NULL;
+  }
+}
+
+/* Index the values collection selects from root by the first value key selects from each of them, which is the */
+/* value a filter's @-path operand takes */
+void index_build(struct path_index* index, zval* root, struct ast_node* collection, struct ast_node* key) {
+  struct eval_ctx ctx;
+  zval members;
+  zval* member;
+
+  zend_hash_init(&index->members, 8, NULL, ZVAL_PTR_DTOR, 0);
+  zend_hash_init(&index->scalars, 8, NULL, ZVAL_PTR_DTOR, 0);
+
+  array_init(&members);
+  eval_init(&ctx, &members, 0);
+  eval_ast(root, root, collection, &ctx);
+  eval_free(&ctx);
+
+  ZEND_HASH_FOREACH_VAL(Z_ARRVAL(members), member) {
+    zval first;
+    zval* group;
+
+    eval_first(root, member, key, &first);
+
+    if (Z_INDIRECT(first) != NULL && (group = key_group(index, Z_INDIRECT(first), true)) != NULL) {
+      Z_TRY_ADDREF_P(member);
+      add_next_index_zval(group, member);
+    }
+  }
+  ZEND_HASH_FOREACH_END();
+
+  zval_ptr_dtor(&members);
+}
+
+/* Get the members whose key is identical to value, or NULL if there are none */
+zval* index_find(struct path_index* index, zval* value) { return key_group(index, value, false); }
+
+static bool is_literal(struct ast_node* tok) {
+  switch (tok->type) {
+    case AST_BOOL:
+    case AST_DOUBLE:
+    case AST_LITERAL:
+    case AST_LONG:
+    case AST_NULL:
+      return tok->next == NULL;
+    default:
+      return false;
+  }
+}
+
+/* Check whether head is the collection with its last segment, a wildcard, replaced by a filter comparing the key */
+/* with a literal, e.g. $.items[?(@.id == 42)] for $.items[*] keyed on @.id. Segments may follow the filter. */
+/* Returns the filter and loads the literal into value, or returns NULL if the index can't answer the query. */
+struct ast_node* index_filter(struct ast_node* collection, struct ast_node* key, struct ast_node* head, zval* value) {
+  for (; collection->next != NULL; collection = collection->next, head = head->next) {
+    if (head == NULL || !ast_node_equal(collection, head)) {
+      return NULL;
+    }
+  }
+
+  if (collection->type != AST_WILD_CARD || head == NULL || head->type != AST_EXPR) {
+    return NULL;
+  }
+
+  struct ast_node* condition = head->data.d_expression.head;
+
+  if (condition == NULL || condition->type != AST_EQ || condition->next != NULL) {
+    return NULL;
+  }
+
+  struct ast_node* left = condition->data.d_binary.left;
+  struct ast_node* right = condition->data.d_binary.right;
+
+  if (is_literal(right) && ast_chain_equal(left, key)) {
+    filter_literal(right, value);
+  } else if (is_literal(left) && ast_chain_equal(right, key)) {
+    filter_literal(left, value);
+  } else {
+    return NULL;
+  }
+
+  return head;
+}
+
+/* Continue the evaluation after filter with the members whose key is identical to value, which are the members */
+/* the filter would have selected, in the same order */
+void index_eval(struct path_index* index, zval* root, struct ast_node* filter, zval* value, struct eval_ctx* ctx) {
+  zval* group = key_group(index, value, false);
+  zval* member;
+  zend_ulong visited = 0;
+
+  if (group == NULL) {
+    return;
+  }
+
+  ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(group), member) {
+    copy_result_or_continue(root, member, filter, ctx);
+    visited++;
+    if (eval_halted(ctx)) {
+      break;
+    }
+  }
+  ZEND_HASH_FOREACH_END();
+
+  JSONPATH_COUNT(nodes_visited, visited);
+}
+
+/* Report the groups to the cycle collector, they hold references to the members */
+void index_gc(struct path_index* index, zend_get_gc_buffer* gc) {
+  zval* group;
+
+  ZEND_HASH_FOREACH_VAL(&index->members, group) {
+    zend_get_gc_buffer_add_zval(gc, group);
+  }
+  ZEND_HASH_FOREACH_END();
+
+  ZEND_HASH_FOREACH_VAL(&index->scalars, group) {
+    zend_get_gc_buffer_add_zval(gc, group);
+  }
+  ZEND_HASH_FOREACH_END();
+}
+
+void index_destroy(struct path_index* index) {
+  zend_hash_destroy(&index->members);
+  zend_hash_destroy(&index->scalars);
+}
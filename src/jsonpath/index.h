@@ -0,0 +1,21 @@
+#ifndef INDEX_H
+#define INDEX_H 1
+
+#include "interpreter.h"
+#include "parser.h"
+#include "php.h"
+
+/* The members of a collection grouped by the value of their key, each group a list in document order */
+struct path_index {
+  HashTable members; /* groups of integer and string keys */
+  HashTable scalars; /* groups of float, boolean and null keys, see scalar_key() */
+};
+
+void index_build(struct path_index* index, zval* root, struct ast_node* collection, struct ast_node* key);
+zval* index_find(struct path_index* index, zval* value);
+struct ast_node* index_filter(struct ast_node* collection, struct ast_node* key, struct ast_node* head, zval* value);
+void index_eval(struct path_index* index, zval* root, struct ast_node* filter, zval* value, struct eval_ctx* ctx);
+void index_gc(struct path_index* index, zend_get_gc_buffer* gc);
+void index_destroy(struct path_index* index);
+
+#endif /* INDEX_H */
@@ -1,49 +1,111 @@
 #include "interpreter.h"
 
 #include <ext/pcre/php_pcre.h>
+#include <zend_smart_str.h>
 
+#include "filter.h"
 #include "lexer.h"
+#include "php_jsonpath.h"
 
 int compare(zval* lh, zval* rh);
 bool compare_rgxp(zval* lh, zval* rh);
-void exec_expression(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value);
-void exec_index_filter(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value);
-void exec_recursive_descent(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value);
-void exec_selector(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value);
-void exec_slice(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value);
-void exec_wildcard(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value);
-zval* evaluate_primary(struct ast_node* src, zval* tmp_dest, zval* arr_head, zval* arr_cur);
-bool break_if_result_found(zval* return_value);
-void copy_result_or_continue(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value);
-bool evaluate_unary(zval* arr_head, zval* arr_cur, struct ast_node* tok);
-bool evaluate_binary(zval* arr_head, zval* arr_cur, struct ast_node* tok);
+void exec_expression(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx);
+void exec_index_filter(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx);
+void exec_recursive_descent(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx);
+void exec_selector(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx);
+void exec_slice(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx);
+void exec_wildcard(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx);
+void copy_result_or_continue(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx);
 bool evaluate_expression(zval* arr_head, zval* arr_cur, struct ast_node* tok);
 bool can_check_inequality(zval* lhs, zval* rhs);
-
-void eval_ast(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value) {
+static HashTable* node_children(zval* node);
+static bool is_hidden_property(zval* node, zend_string* key);
+static zval* deref_property(zval* data);
+static zval* find_child(zval* node, HashTable* ht, struct ast_node* tok);
+static zval* find_child_index(zval* node, HashTable* ht, zend_long index);
+static inline void path_push(struct eval_ctx* ctx, zval* node, zend_string* key, zend_long index);
+static inline void path_pop(struct eval_ctx* ctx);
+static zend_string* path_render(struct eval_path* path);
+static void path_keys(struct eval_path* path, zval* keys);
+static void filter_prologue(struct filter_program* program, zval* r, zval* arr_head, struct eval_filters* filters);
+static zval* filter_regs(struct eval_filters* filters, struct filter_program* program, zval* arr_head);
+static void filters_free(struct eval_filters* filters);
+static zval* filter_enter(struct filter_program* program, zval* arr_head, zval* inline_regs);
+static zend_always_inline bool filter_match(struct filter_program* program, zval* r, zval* arr_head, zval* arr_cur,
+                                            struct eval_filters* filters);
+static void filter_leave(zval* r, zval* inline_regs);
+
+#define DESCENT_INLINE_FRAMES 32
+#define FILTER_INLINE_REGS 8
+
+/* Count children, keys or containers examined by the segment being profiled */
+#define PROFILE_CANDIDATES(ctx, n)                                          \
+  do {                                                                      \
+    if (UNEXPECTED((ctx)->profile != NULL)) {                               \
+      (ctx)->profile->counters[(ctx)->profile->current].candidates += (n); \
+    }                                                                       \
+  } while (0)
+
+#define PROFILE_CANDIDATE(ctx) PROFILE_CANDIDATES(ctx, 1)
+
+/* Position of a segment in the container it's applied to. The step functions (children_next(), filter_next(), */
+/* index_list_next(), slice_next() and descent_next()) produce the children a segment selects one at a time. */
+/* They are shared by the eager evaluation and the iterator, which only differ in what they do with a child and */
+/* in where they keep their cursors: on the C stack, or in frames that survive between matches. */
+struct segment_cursor {
+  HashTable* ht;
+  uint32_t pos;          /* next bucket, or next entry of an index list */
+  zend_long index;       /* next index of a slice */
+  zend_long end;
+  zend_long step;
+  zend_string* key;      /* key of the child last produced, NULL for integer keys */
+  zend_ulong h;          /* the integer key */
+  zend_ulong candidates; /* children, keys and indexes examined */
+  bool shared;           /* the container last produced by descent_next() may have other parents, so it may be one */
+                         /* of the containers being descended into */
+};
+
+/* A container being descended into, and the position of its next child */
+struct descent_frame {
+  zval* node;
+  bool shared; /* the container may have other parents, so the descent may reach it again */
+  struct segment_cursor c;
+};
+
+/* The containers a descent is inside of. A descent started by another one in the same evaluation, e.g. the ..name */
+/* of $..child..name, is inside of the containers of the outer descent too, as the frames of the iterator are. */
+struct descent_scope {
+  struct descent_frame* stack;
+  uint32_t depth;
+  HashTable* shared; /* the shared containers of the stack once it's deeper than DESCENT_INLINE_FRAMES, or NULL */
+  struct descent_scope* outer;
+};
+
+static zend_always_inline void eval_segment(zval* arr_head, zval* arr_cur, struct ast_node* tok,
+                                            struct eval_ctx* ctx) {
   while (tok != NULL) {
     switch (tok->type) {
       case AST_INDEX_LIST:
-        exec_index_filter(arr_head, arr_cur, tok, return_value);
+        exec_index_filter(arr_head, arr_cur, tok, ctx);
         return;
       case AST_INDEX_SLICE:
-        exec_slice(arr_head, arr_cur, tok, return_value);
+        exec_slice(arr_head, arr_cur, tok, ctx);
         return;
       case AST_ROOT:
         tok = tok->next;
         break;
       case AST_RECURSE:
         tok = tok->next;
-        exec_recursive_descent(arr_head, arr_cur, tok, return_value);
+        exec_recursive_descent(arr_head, arr_cur, tok, ctx);
         return;
       case AST_SELECTOR:
-        exec_selector(arr_head, arr_cur, tok, return_value);
+        exec_selector(arr_head, arr_cur, tok, ctx);
         return;
       case AST_WILD_CARD:
-        exec_wildcard(arr_head, arr_cur, tok, return_value);
+        exec_wildcard(arr_head, arr_cur, tok, ctx);
         return;
       case AST_EXPR:
-        exec_expression(arr_head, arr_cur, tok, return_value);
+        exec_expression(arr_head, arr_cur, tok, ctx);
         return;
       default:
         assert(0);
@@ -52,109 +114,392 @@ void eval_ast(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_
   }
 }
 
-void exec_selector(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value) {
-  if (arr_cur == NULL || Z_TYPE_P(arr_cur) != IS_ARRAY) {
+/* Start timing tok, charging the time since the last switch to the node being evaluated. Returns that node. */
+static int profile_enter(struct eval_profile* profile, struct ast_node* tok) {
+  zend_ulong now = stats_now();
+  int previous = profile->current;
+
+  if (previous >= 0) {
+    profile->counters[previous].time_ns += now - profile->since;
+  }
+
+  profile->current = tok - profile->nodes;
+  profile->since = now;
+  profile->counters[profile->current].visits++;
+
+  return previous;
+}
+
+/* Stop timing the current node and resume timing previous */
+static void profile_leave(struct eval_profile* profile, int previous) {
+  zend_ulong now = stats_now();
+
+  profile->counters[profile->current].time_ns += now - profile->since;
+  profile->current = previous;
+  profile->since = now;
+}
+
+void eval_ast(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx) {
+  if (UNEXPECTED(ctx->profile != NULL)) {
+    while (tok != NULL && tok->type == AST_ROOT) {
+      tok = tok->next;
+    }
+
+    if (tok == NULL) {
+      return;
+    }
+
+    int previous = profile_enter(ctx->profile, tok);
+    eval_segment(arr_head, arr_cur, tok, ctx);
+    profile_leave(ctx->profile, previous);
     return;
   }
 
-  zend_ulong idx;
-  int len = strlen(tok->data.d_selector.value);
+  eval_segment(arr_head, arr_cur, tok, ctx);
+}
 
-  if (ZEND_HANDLE_NUMERIC_STR(tok->data.d_selector.value, len, idx)) {
-    /* look up numeric index */
-    arr_cur = zend_hash_index_find(HASH_OF(arr_cur), idx);
-  } else {
-    /* look up string index */
-    arr_cur = zend_hash_str_find(HASH_OF(arr_cur), tok->data.d_selector.value, len);
+/* Start collecting matches into result, an array, stopping after limit matches if limit is positive */
+void eval_init(struct eval_ctx* ctx, zval* result, zend_long limit) {
+  ctx->result = result;
+  ctx->limit = limit;
+  ctx->count = 0;
+  ctx->path = NULL;
+  ctx->visit = NULL;
+  ctx->visit_data = NULL;
+  ctx->profile = NULL;
+  ctx->descent = NULL;
+  ctx->filters = &ctx->own_filters;
+  ctx->own_filters = (struct eval_filters){0};
+}
+
+/* Release what the evaluation kept between the containers it visited */
+void eval_free(struct eval_ctx* ctx) {
+  if (ctx->result != NULL && ctx->path == NULL && ctx->visit == NULL && Z_TYPE_P(ctx->result) == IS_ARRAY) {
+    /* every match was a result slot, see copy_result_or_continue() */
+    JSONPATH_COUNT(results_copied, ctx->count);
+    JSONPATH_COUNT(bytes_copied, sizeof(zval) * ctx->count);
   }
 
-  if (arr_cur != NULL) {
-    copy_result_or_continue(arr_head, arr_cur, tok, return_value);
+  filters_free(&ctx->own_filters);
+}
+
+/* Prepare counters for every node of plan, see JsonPath::profile() */
+void eval_profile_init(struct eval_profile* profile, struct query_plan* plan) {
+  profile->nodes = plan->nodes;
+  profile->counters = ecalloc(MAX(plan->node_count, 1), sizeof(struct eval_profile_node));
+  profile->current = -1;
+  profile->since = 0;
+}
+
+void eval_profile_free(struct eval_profile* profile) {
+  efree(profile->counters);
+  profile->counters = NULL;
+}
+
+/* Report the path of each match instead of its value, as a normalized path string or as an array of keys. The */
+/* path stack is reused across evaluations. */
+void eval_report_paths(struct eval_ctx* ctx, struct eval_path* path, bool as_keys) {
+  path->count = 0;
+  path->as_keys = as_keys;
+  ctx->path = path;
+}
+
+void eval_path_free(struct eval_path* path) {
+  if (path->segments != NULL) {
+    efree(path->segments);
   }
+  path->segments = NULL;
+  path->count = 0;
+  path->capacity = 0;
 }
 
-void exec_wildcard(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value) {
-  if (arr_cur == NULL || Z_TYPE_P(arr_cur) != IS_ARRAY) {
+/* Record the key of the child about to be visited, the stack only grows so no allocation is needed once it's */
+/* as deep as the data. Object members are always named, even if their name is numeric. */
+static inline void path_push(struct eval_ctx* ctx, zval* node, zend_string* key, zend_long index) {
+  struct eval_path* path = ctx->path;
+
+  if (path == NULL) {
     return;
   }
 
-  zval* data;
-  zval* zv_dest;
-  zend_string* key;
-  zend_ulong num_key;
+  if (path->count == path->capacity) {
+    path->capacity = path->capacity ? path->capacity * 2 : 16;
+    path->segments = erealloc(path->segments, sizeof(struct eval_path_segment) * path->capacity);
+  }
 
-  ZEND_HASH_FOREACH_KEY_VAL(HASH_OF(arr_cur), num_key, key, data) {
-    copy_result_or_continue(arr_head, data, tok, return_value);
-    if (break_if_result_found(return_value)) {
-      break;
+  struct eval_path_segment* segment = &path->segments[path->count++];
+
+  segment->key = key;
+  segment->index = index;
+  segment->is_member = Z_TYPE_P(node) == IS_OBJECT;
+}
+
+static inline void path_pop(struct eval_ctx* ctx) {
+  if (ctx->path != NULL) {
+    ctx->path->count--;
+  }
+}
+
+/* Append a member name as a single-quoted string, escaped as in RFC 9535 normalized paths */
+static void path_render_name(smart_str* buf, const char* name, size_t len) {
+  smart_str_appendc(buf, '\'');
+
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = (unsigned char)name[i];
+
+    switch (c) {
+      case '\'':
+        smart_str_appendl(buf, "\\'", 2);
+        break;
+      case '\\':
+        smart_str_appendl(buf, "\\\\", 2);
+        break;
+      case '\b':
+        smart_str_appendl(buf, "\\b", 2);
+        break;
+      case '\f':
+        smart_str_appendl(buf, "\\f", 2);
+        break;
+      case '\n':
+        smart_str_appendl(buf, "\\n", 2);
+        break;
+      case '\r':
+        smart_str_appendl(buf, "\\r", 2);
+        break;
+      case '\t':
+        smart_str_appendl(buf, "\\t", 2);
+        break;
+      default:
+        if (c < 0x20) {
+          static const char hex[] = "0123456789abcdef";
+          smart_str_appendl(buf, "\\u00", 4);
+          smart_str_appendc(buf, hex[c >> 4]);
+          smart_str_appendc(buf, hex[c & 0xf]);
+        } else {
+          smart_str_appendc(buf, c);
+        }
+        break;
     }
   }
-  ZEND_HASH_FOREACH_END();
+
+  smart_str_appendc(buf, '\'');
 }
 
-void exec_recursive_descent(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value) {
-  if (arr_cur == NULL || Z_TYPE_P(arr_cur) != IS_ARRAY) {
-    return;
+/* Build the keys leading to the current node, e.g. ["store", "book", 3]. Object members are always strings. */
+static void path_keys(struct eval_path* path, zval* keys) {
+  array_init_size(keys, path->count);
+
+  for (uint32_t i = 0; i < path->count; i++) {
+    struct eval_path_segment* segment = &path->segments[i];
+
+    if (segment->key != NULL) {
+      add_next_index_str(keys, zend_string_copy(segment->key));
+    } else if (segment->is_member) {
+      add_next_index_str(keys, zend_long_to_str(segment->index));
+    } else {
+      add_next_index_long(keys, segment->index);
+    }
   }
+}
 
-  zval* data;
-  zval* zv_dest;
-  zend_string* key;
-  zend_ulong num_key;
+/* Build the normalized path of the current node, e.g. $['store']['book'][3] */
+static zend_string* path_render(struct eval_path* path) {
+  smart_str buf = {0};
+
+  smart_str_appendc(&buf, '$');
+
+  for (uint32_t i = 0; i < path->count; i++) {
+    struct eval_path_segment* segment = &path->segments[i];
+
+    smart_str_appendc(&buf, '[');
+    if (segment->key != NULL) {
+      path_render_name(&buf, ZSTR_VAL(segment->key), ZSTR_LEN(segment->key));
+    } else if (segment->is_member) {
+      char num[MAX_LENGTH_OF_LONG + 1];
+      char* end = num + sizeof(num) - 1;
+      char* str = zend_print_long_to_buf(end, segment->index);
+      path_render_name(&buf, str, end - str);
+    } else {
+      smart_str_append_long(&buf, segment->index);
+    }
+    smart_str_appendc(&buf, ']');
+  }
+
+  smart_str_0(&buf);
+
+  return buf.s;
+}
 
-  eval_ast(arr_head, arr_cur, tok, return_value);
+/* Evaluate tok as part of the evaluation owning filters, if not NULL, see eval_first() */
+static void eval_first_in(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* result,
+                          struct eval_filters* filters) {
+  struct eval_ctx ctx;
 
-  ZEND_HASH_FOREACH_KEY_VAL(HASH_OF(arr_cur), num_key, key, data) {
-    exec_recursive_descent(arr_head, data, tok, return_value);
+  ZVAL_INDIRECT(result, NULL);
+  eval_init(&ctx, result, 1);
+
+  if (filters != NULL) {
+    ctx.filters = filters;
+  }
+
+  eval_ast(arr_head, arr_cur, tok, &ctx);
+  eval_free(&ctx);
+}
+
+/* Evaluate tok and point result (IS_INDIRECT) at the first match, or at NULL if nothing matched */
+void eval_first(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* result) {
+  eval_first_in(arr_head, arr_cur, tok, result, NULL);
+}
+
+/* Get the children of an array, or the property table of an object. Returns NULL for scalars. */
+static HashTable* node_children(zval* node) {
+  if (node == NULL) {
+    return NULL;
+  }
+
+  switch (Z_TYPE_P(node)) {
+    case IS_ARRAY:
+      return Z_ARRVAL_P(node);
+    case IS_OBJECT:
+      return Z_OBJPROP_P(node);
+    default:
+      return NULL;
   }
-  ZEND_HASH_FOREACH_END();
 }
 
-void exec_index_filter(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value) {
-  for (int i = 0; i < tok->data.d_list.count; i++) {
-    if (tok->data.d_list.indexes[i] < 0) {
-      tok->data.d_list.indexes[i] = zend_hash_num_elements(HASH_OF(arr_cur)) - abs(tok->data.d_list.indexes[i]);
+/* Private and protected properties have mangled names starting with a NUL byte, skip them */
+static bool is_hidden_property(zval* node, zend_string* key) {
+  return Z_TYPE_P(node) == IS_OBJECT && key != NULL && ZSTR_LEN(key) > 0 && ZSTR_VAL(key)[0] == '\0';
+}
+
+/* Resolve the property slot of a declared property, which is NULL if the property is uninitialized */
+static zval* deref_property(zval* data) {
+  if (data != NULL && Z_TYPE_P(data) == IS_INDIRECT) {
+    data = Z_INDIRECT_P(data);
+
+    if (Z_ISUNDEF_P(data)) {
+      return NULL;
     }
-    zval* data;
-    if ((data = zend_hash_index_find(HASH_OF(arr_cur), tok->data.d_list.indexes[i])) != NULL) {
-      copy_result_or_continue(arr_head, data, tok, return_value);
-      if (break_if_result_found(return_value)) {
-        break;
-      }
+  }
+
+  return data;
+}
+
+/* Look up an integer key of an array. The elements of packed arrays (lists) are stored at their index, so they're */
+/* read directly instead of going through the hash functions. */
+static zend_always_inline zval* array_index(HashTable* ht, zend_long index) {
+  if (HT_IS_PACKED(ht)) {
+    if ((zend_ulong)index >= ht->nNumUsed) {
+      return NULL;
     }
+#if PHP_VERSION_ID >= 80200
+    zval* data = &ht->arPacked[index];
+#else
+    zval* data = &ht->arData[index].val;
+#endif
+    return Z_TYPE_P(data) == IS_UNDEF ? NULL : data;
   }
+
+  return zend_hash_index_find(ht, index);
 }
 
-void exec_slice(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value) {
-  zval* data;
+static zval* find_child(zval* node, HashTable* ht, struct ast_node* tok) {
+  if (Z_TYPE_P(node) == IS_ARRAY && tok->data.d_selector.is_index) {
+    /* look up numeric index */
+    return array_index(ht, tok->data.d_selector.index);
+  }
+
+  /* look up string index, the key's hash was computed by the parser. property tables only have string keys. */
+  return deref_property(zend_hash_find_ex(ht, tok->data.d_selector.key, 1));
+}
+
+static zval* find_child_index(zval* node, HashTable* ht, zend_long index) {
+  if (Z_TYPE_P(node) == IS_ARRAY) {
+    return array_index(ht, index);
+  }
+
+  char buf[MAX_LENGTH_OF_LONG + 1];
+  char* end = buf + sizeof(buf) - 1;
+  char* str = zend_print_long_to_buf(end, index);
+
+  return deref_property(zend_hash_str_find(ht, str, end - str));
+}
+
+/* Apply a selector to a container. Returns whether it has the key. */
+static zend_always_inline bool select_child(zval* arr_head, zval* node, HashTable* ht, struct ast_node* tok,
+                                            struct eval_ctx* ctx) {
+  zval* data = find_child(node, ht, tok);
+
+  if (data == NULL) {
+    return false;
+  }
+
+  if (Z_TYPE_P(node) == IS_ARRAY && tok->data.d_selector.is_index) {
+    path_push(ctx, node, NULL, tok->data.d_selector.index);
+  } else {
+    path_push(ctx, node, tok->data.d_selector.key, 0);
+  }
+  copy_result_or_continue(arr_head, data, tok, ctx);
+  path_pop(ctx);
+
+  return true;
+}
+
+/* Get the first element of ht at or after position *pos and move *pos past it. Returns NULL at the end. */
+static zend_always_inline zval* next_child(HashTable* ht, uint32_t* pos, zend_string** key, zend_ulong* index) {
+#if PHP_VERSION_ID >= 80200
+  if (HT_IS_PACKED(ht)) {
+    while (*pos < ht->nNumUsed) {
+      zval* data = &ht->arPacked[(*pos)++];
+      if (Z_TYPE_P(data) != IS_UNDEF) {
+        *key = NULL;
+        *index = *pos - 1;
+        return data;
+      }
+    }
+    return NULL;
+  }
+#endif
+
+  while (*pos < ht->nNumUsed) {
+    Bucket* p = &ht->arData[(*pos)++];
+    if (Z_TYPE(p->val) != IS_UNDEF) {
+      *key = p->key;
+      *index = p->h;
+      return &p->val;
+    }
+  }
 
-  int data_length = zend_hash_num_elements(HASH_OF(arr_cur));
+  return NULL;
+}
 
-  int range_start = tok->data.d_list.indexes[0];
-  int range_end = tok->data.d_list.count > 1 ? tok->data.d_list.indexes[1] : INT_MAX;
-  int range_step = tok->data.d_list.count > 2 ? tok->data.d_list.indexes[2] : 1;
+/* Resolve the bounds of a slice over data_length elements. Returns false if the slice selects nothing. */
+static bool slice_range(struct ast_node* tok, zend_long data_length, zend_long* start, zend_long* end, zend_long* step) {
+  zend_long range_start = tok->data.d_list.indexes[0];
+  zend_long range_end = tok->data.d_list.count > 1 ? tok->data.d_list.indexes[1] : ZEND_LONG_MAX;
+  zend_long range_step = tok->data.d_list.count > 2 ? tok->data.d_list.indexes[2] : 1;
 
   // Zero-steps are not allowed, abort
   if (range_step == 0) {
-    return;
+    return false;
   }
 
   // Replace placeholder with actual value
-  if (range_start == INT_MAX) {
+  if (range_start == ZEND_LONG_MAX) {
     range_start = range_step > 0 ? 0 : data_length - 1;
   }
   // Indexing from the end of the list
   else if (range_start < 0) {
-    range_start = data_length - abs(range_start);
+    range_start += data_length;
   }
 
   // Replace placeholder with actual value
-  if (range_end == INT_MAX) {
+  if (range_end == ZEND_LONG_MAX) {
     range_end = range_step > 0 ? data_length : -1;
   }
   // Indexing from the end of the list
   else if (range_end < 0) {
-    range_end = data_length - abs(range_end);
+    range_end += data_length;
   }
 
   // Set suitable boundaries for start index
@@ -165,55 +510,405 @@ void exec_slice(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* retur
   range_end = range_end < -1 ? -1 : range_end;
   range_end = range_end > data_length ? data_length : range_end;
 
-  if (range_step > 0) {
-    // Make sure that the range is sane so we don't end up in an infinite loop
-    if (range_start >= range_end) {
-      return;
+  // Steps larger than the array visit a single element, clamp them so the loop counter can't overflow
+  if (range_step > data_length) {
+    range_step = data_length + 1;
+  } else if (range_step < -data_length) {
+    range_step = -data_length - 1;
+  }
+
+  *start = range_start;
+  *end = range_end;
+  *step = range_step;
+
+  // Make sure that the range is sane so we don't end up in an infinite loop
+  return range_step > 0 ? range_start < range_end : range_start > range_end;
+}
+
+static inline bool slice_has_next(zend_long i, zend_long end, zend_long step) {
+  return step > 0 ? i < end : i > end;
+}
+
+/* Start applying tok to node, a dereferenced value. Returns false if node has no children, or if tok is a slice */
+/* selecting none of them. tok is NULL for a recursive descent. */
+static zend_always_inline bool cursor_start(struct segment_cursor* c, zval* node, struct ast_node* tok) {
+  if ((c->ht = node_children(node)) == NULL) {
+    return false;
+  }
+
+  c->pos = 0;
+  c->candidates = 0;
+
+  if (tok != NULL && tok->type == AST_INDEX_SLICE) {
+    return slice_range(tok, zend_hash_num_elements(c->ht), &c->index, &c->end, &c->step);
+  }
+
+  return true;
+}
+
+/* Produce the next visible child of node, for wildcards and filters. Private and protected properties, and */
+/* uninitialized declared properties, aren't visible. */
+static zend_always_inline zval* children_next(struct segment_cursor* c, zval* node) {
+  zval* data;
+
+  while ((data = next_child(c->ht, &c->pos, &c->key, &c->h)) != NULL) {
+    if ((data = deref_property(data)) != NULL && !is_hidden_property(node, c->key)) {
+      c->candidates++;
+      return data;
     }
+  }
 
-    for (int i = range_start; i < range_end; i += range_step) {
-      if ((data = zend_hash_index_find(HASH_OF(arr_cur), i)) != NULL) {
-        copy_result_or_continue(arr_head, data, tok, return_value);
-        if (break_if_result_found(return_value)) {
-          break;
-        }
+  return NULL;
+}
+
+/* Produce the next visible child of node the filter program accepts, r holding its registers */
+static zend_always_inline zval* filter_next(struct segment_cursor* c, zval* node, struct filter_program* program,
+                                            zval* r, zval* arr_head, struct eval_filters* filters) {
+  zval* data;
+
+  while ((data = children_next(c, node)) != NULL) {
+    if (filter_match(program, r, arr_head, data, filters)) {
+      return data;
+    }
+  }
+
+  return NULL;
+}
+
+/* Produce the next child of node listed by an index list */
+static zend_always_inline zval* index_list_next(struct segment_cursor* c, zval* node, struct ast_node* tok) {
+  zval* data;
+
+  while (c->pos < (uint32_t)tok->data.d_list.count) {
+    zend_long index = tok->data.d_list.indexes[c->pos++];
+    /* resolve negative indexes without touching the AST, it may be cached and evaluated again */
+    if (index < 0) {
+      index += zend_hash_num_elements(c->ht);
+    }
+    c->candidates++;
+    if ((data = find_child_index(node, c->ht, index)) != NULL) {
+      c->key = NULL;
+      c->h = index;
+      return data;
+    }
+  }
+
+  return NULL;
+}
+
+/* Produce the next child of node in the range of a slice, resolved by cursor_start() */
+static zend_always_inline zval* slice_next(struct segment_cursor* c, zval* node) {
+  zval* data;
+
+  while (slice_has_next(c->index, c->end, c->step)) {
+    zend_long index = c->index;
+    c->index += c->step;
+    c->candidates++;
+    if ((data = find_child_index(node, c->ht, index)) != NULL) {
+      c->key = NULL;
+      c->h = index;
+      return data;
+    }
+  }
+
+  return NULL;
+}
+
+/* Produce the next visible child of node that is an array or an object, dereferenced, for a recursive descent. */
+/* Scalars are skipped here, so they cost neither a frame nor a call. */
+static zend_always_inline zval* descent_next(struct segment_cursor* c, zval* node) {
+  zval* data;
+
+  while ((data = next_child(c->ht, &c->pos, &c->key, &c->h)) != NULL) {
+    if ((data = deref_property(data)) == NULL || is_hidden_property(node, c->key)) {
+      continue;
+    }
+
+    c->shared = Z_ISREF_P(data);
+    ZVAL_DEREF(data);
+
+    if (Z_TYPE_P(data) == IS_OBJECT) {
+      c->shared = true;
+      return data;
+    }
+
+    if (Z_TYPE_P(data) == IS_ARRAY) {
+      /* an array only this one holds can't be an ancestor, immutable arrays can't contain references */
+      c->shared = c->shared || (Z_REFCOUNTED_P(data) && Z_REFCOUNT_P(data) > 1);
+      return data;
+    }
+  }
+
+  return NULL;
+}
+
+void exec_selector(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx) {
+  HashTable* ht;
+  bool found;
+
+  ZVAL_DEREF(arr_cur);
+
+  if ((ht = node_children(arr_cur)) == NULL) {
+    return;
+  }
+
+  PROFILE_CANDIDATE(ctx);
+  found = select_child(arr_head, arr_cur, ht, tok, ctx);
+  JSONPATH_COUNT(hash_lookups, 1);
+  JSONPATH_COUNT(nodes_visited, found);
+}
+
+void exec_wildcard(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx) {
+  struct segment_cursor c;
+  zval* data;
+
+  ZVAL_DEREF(arr_cur);
+
+  if (!cursor_start(&c, arr_cur, tok)) {
+    return;
+  }
+
+  while ((data = children_next(&c, arr_cur)) != NULL) {
+    path_push(ctx, arr_cur, c.key, c.h);
+    copy_result_or_continue(arr_head, data, tok, ctx);
+    path_pop(ctx);
+    if (eval_halted(ctx)) {
+      break;
+    }
+  }
+
+  PROFILE_CANDIDATES(ctx, c.candidates);
+  JSONPATH_COUNT(nodes_visited, c.candidates);
+}
+
+/* The key of a container in the set of containers being descended into */
+static zend_always_inline zend_ulong descent_key(zval* node) { return (zend_ulong)(uintptr_t)Z_COUNTED_P(node); }
+
+/* Whether node is one of the containers on the stack of a descent, i.e. the data is cyclic. Only containers that */
+/* may have other parents are looked up. The document's own recursion flags are left alone: a filter's $..path or */
+/* user code may walk the same containers meanwhile. */
+static bool descent_on_stack(struct descent_scope* scope, zval* node) {
+  for (; scope != NULL; scope = scope->outer) {
+    if (scope->shared != NULL) {
+      if (zend_hash_index_exists(scope->shared, descent_key(node))) {
+        return true;
       }
+      continue;
     }
+
+    for (uint32_t i = 0; i < scope->depth; i++) {
+      if (scope->stack[i].shared && Z_COUNTED_P(scope->stack[i].node) == Z_COUNTED_P(node)) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+/* Add a container to the stack of a descent. Past DESCENT_INLINE_FRAMES the shared containers are kept in a set */
+/* too, so looking one up doesn't scan the whole stack. */
+static void descent_push(struct descent_scope* scope, zval* node, bool shared) {
+  struct descent_frame* frame = &scope->stack[scope->depth++];
+
+  frame->node = node;
+  frame->shared = shared;
+
+  if (scope->shared == NULL && scope->depth > DESCENT_INLINE_FRAMES) {
+    ALLOC_HASHTABLE(scope->shared);
+    zend_hash_init(scope->shared, DESCENT_INLINE_FRAMES * 2, NULL, NULL, 0);
+
+    for (uint32_t i = 0; i < scope->depth; i++) {
+      if (scope->stack[i].shared) {
+        zend_hash_index_add_empty_element(scope->shared, descent_key(scope->stack[i].node));
+      }
+    }
+  } else if (scope->shared != NULL && shared) {
+    zend_hash_index_add_empty_element(scope->shared, descent_key(node));
+  }
+}
+
+static void descent_pop(struct descent_scope* scope) {
+  struct descent_frame* frame = &scope->stack[--scope->depth];
+
+  if (scope->shared != NULL && frame->shared) {
+    zend_hash_index_del(scope->shared, descent_key(frame->node));
+  }
+}
+
+/* Apply tok to a container about to be descended into and start a cursor over its children. Returns the matches */
+/* of a ..key looked up here, other segments count their own. */
+static zend_always_inline bool descent_visit(zval* arr_head, zval* node, struct ast_node* tok,
+                                             struct segment_cursor* c, struct eval_ctx* ctx) {
+  bool found = false;
+
+  PROFILE_CANDIDATE(ctx);
+
+  if (tok->type == AST_SELECTOR && ctx->profile == NULL) {
+    /* ..key is a single hash lookup per container. profiled evaluations go through eval_ast() to time the key. */
+    found = select_child(arr_head, node, node_children(node), tok, ctx);
   } else {
-    // Make sure that the range is sane so we don't end up in an infinite loop
-    if (range_start <= range_end) {
-      return;
+    eval_ast(arr_head, node, tok, ctx);
+  }
+
+  cursor_start(c, node, NULL);
+
+  return found;
+}
+
+/* Visit the containers below arr_cur depth-first, applying tok to each of them. The traversal runs on an */
+/* explicit stack, so the depth of the data doesn't count against the C stack. */
+void exec_recursive_descent(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx) {
+  struct descent_frame inline_stack[DESCENT_INLINE_FRAMES];
+  struct descent_scope scope = {inline_stack, 0, NULL, ctx->descent};
+  uint32_t capacity = DESCENT_INLINE_FRAMES;
+  zend_ulong visited = 1;
+  zend_ulong found;
+  zval* data;
+
+  ZVAL_DEREF(arr_cur);
+
+  if (Z_TYPE_P(arr_cur) != IS_ARRAY && Z_TYPE_P(arr_cur) != IS_OBJECT) {
+    return;
+  }
+
+  /* descents started by tok are inside of the containers of this one */
+  ctx->descent = &scope;
+
+  /* the container the descent starts from may be reached again whoever holds it */
+  descent_push(&scope, arr_cur, true);
+  found = descent_visit(arr_head, arr_cur, tok, &scope.stack[0].c, ctx);
+
+  while (scope.depth > 0) {
+    struct descent_frame* frame = &scope.stack[scope.depth - 1];
+
+    if (eval_halted(ctx) || (data = descent_next(&frame->c, frame->node)) == NULL) {
+      descent_pop(&scope);
+      if (scope.depth > 0) {
+        /* the key of the container in its parent */
+        path_pop(ctx);
+      }
+      continue;
     }
 
-    for (int i = range_start; i > range_end; i += range_step) {
-      if ((data = zend_hash_index_find(HASH_OF(arr_cur), i)) != NULL) {
-        copy_result_or_continue(arr_head, data, tok, return_value);
-        if (break_if_result_found(return_value)) {
-          break;
-        }
+    if (frame->c.shared && descent_on_stack(&scope, data)) {
+      /* the data is cyclic */
+      continue;
+    }
+
+    path_push(ctx, frame->node, frame->c.key, frame->c.h);
+
+    if (scope.depth == capacity) {
+      capacity *= 2;
+      if (scope.stack == inline_stack) {
+        scope.stack = safe_emalloc(capacity, sizeof(struct descent_frame), 0);
+        memcpy(scope.stack, inline_stack, sizeof(inline_stack));
+      } else {
+        scope.stack = safe_erealloc(scope.stack, capacity, sizeof(struct descent_frame), 0);
       }
+      frame = &scope.stack[scope.depth - 1];
     }
+
+    visited++;
+    descent_push(&scope, data, frame->c.shared);
+    found += descent_visit(arr_head, data, tok, &scope.stack[scope.depth - 1].c, ctx);
+  }
+
+  ctx->descent = scope.outer;
+
+  if (scope.stack != inline_stack) {
+    efree(scope.stack);
+  }
+
+  if (scope.shared != NULL) {
+    zend_hash_destroy(scope.shared);
+    FREE_HASHTABLE(scope.shared);
+  }
+
+  /* counted once per descent rather than per container, the request's counters live in the module globals */
+  JSONPATH_COUNT(nodes_visited, visited + found);
+  if (tok->type == AST_SELECTOR && ctx->profile == NULL) {
+    JSONPATH_COUNT(hash_lookups, visited);
   }
 }
 
-void exec_expression(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value) {
-  if (arr_cur == NULL || Z_TYPE_P(arr_cur) != IS_ARRAY) {
+void exec_index_filter(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx) {
+  struct segment_cursor c;
+  zend_ulong found = 0;
+  zval* data;
+
+  ZVAL_DEREF(arr_cur);
+
+  if (!cursor_start(&c, arr_cur, tok)) {
     return;
   }
 
-  zend_ulong num_key;
-  zend_string* key;
+  while ((data = index_list_next(&c, arr_cur, tok)) != NULL) {
+    path_push(ctx, arr_cur, NULL, c.h);
+    copy_result_or_continue(arr_head, data, tok, ctx);
+    path_pop(ctx);
+    found++;
+    if (eval_halted(ctx)) {
+      break;
+    }
+  }
+
+  PROFILE_CANDIDATES(ctx, c.candidates);
+  JSONPATH_COUNT(hash_lookups, c.candidates);
+  JSONPATH_COUNT(nodes_visited, found);
+}
+
+void exec_slice(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx) {
+  struct segment_cursor c;
+  zend_ulong found = 0;
   zval* data;
 
-  ZEND_HASH_FOREACH_KEY_VAL(HASH_OF(arr_cur), num_key, key, data) {
-    if (evaluate_expression(arr_head, data, tok->data.d_expression.head)) {
-      copy_result_or_continue(arr_head, data, tok, return_value);
-      if (break_if_result_found(return_value)) {
-        break;
-      }
+  ZVAL_DEREF(arr_cur);
+
+  if (!cursor_start(&c, arr_cur, tok)) {
+    return;
+  }
+
+  while ((data = slice_next(&c, arr_cur)) != NULL) {
+    path_push(ctx, arr_cur, NULL, c.h);
+    copy_result_or_continue(arr_head, data, tok, ctx);
+    path_pop(ctx);
+    found++;
+    if (eval_halted(ctx)) {
+      break;
+    }
+  }
+
+  PROFILE_CANDIDATES(ctx, c.candidates);
+  JSONPATH_COUNT(hash_lookups, c.candidates);
+  JSONPATH_COUNT(nodes_visited, found);
+}
+
+void exec_expression(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx) {
+  struct segment_cursor c;
+  zval* data;
+
+  ZVAL_DEREF(arr_cur);
+
+  if (!cursor_start(&c, arr_cur, tok)) {
+    return;
+  }
+
+  struct filter_program* program = tok->data.d_expression.program;
+  zval* r = filter_regs(ctx->filters, program, arr_head);
+
+  while ((data = filter_next(&c, arr_cur, program, r, arr_head, ctx->filters)) != NULL) {
+    path_push(ctx, arr_cur, c.key, c.h);
+    copy_result_or_continue(arr_head, data, tok, ctx);
+    path_pop(ctx);
+    if (eval_halted(ctx)) {
+      break;
     }
   }
-  ZEND_HASH_FOREACH_END();
+
+  /* every element the filter was tested on counts, whether it passed or not */
+  PROFILE_CANDIDATES(ctx, c.candidates);
+  JSONPATH_COUNT(nodes_visited, c.candidates);
 }
 
 int compare(zval* lh, zval* rh) {
@@ -228,7 +923,6 @@ bool compare_rgxp(zval* lh, zval* rh) {
   pcre_cache_entry* pce;
 
   if ((pce = pcre_get_compiled_regex_cache(Z_STR_P(rh))) == NULL) {
-    zval_ptr_dtor(rh);
     return false;
   }
 
@@ -248,190 +942,276 @@ bool compare_rgxp(zval* lh, zval* rh) {
   return Z_LVAL(retval) > 0;
 }
 
-zval* evaluate_primary(struct ast_node* src, zval* tmp_dest, zval* arr_head, zval* arr_cur) {
-  switch (src->type) {
-    case AST_BOOL:
-      ZVAL_BOOL(tmp_dest, src->data.d_literal.value_bool);
-      return tmp_dest;
-    case AST_DOUBLE:
-      ZVAL_DOUBLE(tmp_dest, src->data.d_double.value);
-      return tmp_dest;
-    case AST_LITERAL:
-      ZVAL_STRING(tmp_dest, src->data.d_literal.value);
-      return tmp_dest;
-    case AST_LONG:
-      ZVAL_LONG(tmp_dest, src->data.d_long.value);
-      return tmp_dest;
-    case AST_NULL:
-      ZVAL_NULL(tmp_dest);
-      return tmp_dest;
-    case AST_ROOT:
-      ZVAL_INDIRECT(tmp_dest, NULL);
-      eval_ast(arr_head, arr_head, src, tmp_dest);
-      if (Z_INDIRECT_P(tmp_dest) == NULL) {
-        ZVAL_UNDEF(tmp_dest);
-        return tmp_dest;
-      }
-      return Z_INDIRECT_P(tmp_dest);
-    case AST_SELECTOR:
-      ZVAL_INDIRECT(tmp_dest, NULL);
-      eval_ast(arr_head, arr_cur, src, tmp_dest);
-      if (Z_INDIRECT_P(tmp_dest) == NULL) {
-        ZVAL_UNDEF(tmp_dest);
-        return tmp_dest;
-      }
-      return Z_INDIRECT_P(tmp_dest);
-    default:
-      assert(0);
-      return NULL;
+void copy_result_or_continue(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx) {
+  if (UNEXPECTED(ctx->profile != NULL)) {
+    ctx->profile->counters[tok - ctx->profile->nodes].matches++;
   }
-}
 
-bool break_if_result_found(zval* return_value) {
-  return Z_TYPE_P(return_value) == IS_INDIRECT && Z_INDIRECT_P(return_value) != NULL;
-}
+  if (ctx->visit != NULL) {
+    ctx->visit(arr_head, arr_cur, ctx);
+    return;
+  }
+
+  if (tok->next != NULL) {
+    eval_ast(arr_head, arr_cur, tok->next, ctx);
+    return;
+  }
 
-void copy_result_or_continue(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value) {
-  if (tok->next == NULL) {
-    if (Z_TYPE_P(return_value) == IS_ARRAY) {
-      zval tmp;
-      ZVAL_COPY_VALUE(&tmp, arr_cur);
-      zval_copy_ctor(&tmp);
-      add_next_index_zval(return_value, &tmp);
-    } else if (Z_TYPE_P(return_value) == IS_INDIRECT) {
-      ZVAL_INDIRECT(return_value, arr_cur);
+  if (Z_TYPE_P(ctx->result) == IS_ARRAY && ctx->path != NULL) {
+    if (ctx->path->as_keys) {
+      zval keys;
+      path_keys(ctx->path, &keys);
+      add_next_index_zval(ctx->result, &keys);
+      JSONPATH_COUNT(bytes_copied, sizeof(zval) * (1 + ctx->path->count));
+    } else {
+      zend_string* path = path_render(ctx->path);
+      add_next_index_str(ctx->result, path);
+      JSONPATH_COUNT(bytes_copied, sizeof(zval) + ZSTR_LEN(path));
     }
-  } else {
-    eval_ast(arr_head, arr_cur, tok->next, return_value);
+    JSONPATH_COUNT(results_copied, 1);
+  } else if (Z_TYPE_P(ctx->result) == IS_ARRAY) {
+    /* share the matched value by refcount, arrays are only separated if the caller writes to them */
+    zval tmp;
+    ZVAL_COPY_DEREF(&tmp, arr_cur);
+    add_next_index_zval(ctx->result, &tmp);
+  } else if (Z_INDIRECT_P(ctx->result) == NULL) {
+    /* first-match mode, evaluation halts at the match */
+    ZVAL_INDIRECT(ctx->result, arr_cur);
   }
+
+  ctx->count++;
 }
 
-bool evaluate_expression(zval* arr_head, zval* arr_cur, struct ast_node* tok) {
-  if (is_binary(tok->type)) {
-    return evaluate_binary(arr_head, arr_cur, tok);
+/* Load the first value path selects from node into dst, or undef if it selects nothing. Returns the keys it */
+/* looked up itself, a longer path is an evaluation of its own, which counts them. */
+static zend_always_inline uint32_t filter_fetch(zval* arr_head, zval* node, struct ast_node* path, zval* dst,
+                                                struct eval_filters* filters) {
+  zval* data = NULL;
+  uint32_t lookups = 0;
+
+  if (path->type == AST_SELECTOR && path->next == NULL) {
+    /* @.key, a single lookup */
+    HashTable* ht;
+
+    ZVAL_DEREF(node);
+
+    if ((ht = node_children(node)) != NULL) {
+      data = find_child(node, ht, path);
+      lookups++;
+    }
+  } else {
+    zval first;
+    eval_first_in(arr_head, node, path, &first, filters);
+    data = Z_INDIRECT(first);
   }
 
-  if (is_unary(tok->type)) {
-    return evaluate_unary(arr_head, arr_cur, tok);
+  if (data == NULL) {
+    ZVAL_UNDEF(dst);
+    return lookups;
   }
 
-  if (tok->type == AST_SELECTOR) {
-    zval tmp = {0};
-    return Z_TYPE_P(evaluate_primary(tok, &tmp, arr_head, arr_cur)) != IS_UNDEF;
+  ZVAL_DEREF(data);
+  /* registers borrow values from the document and the plan, filter_regs() pins those kept by the evaluation */
+  ZVAL_COPY_VALUE(dst, data);
+
+  return lookups;
+}
+
+/* Add the work of a filter to the counters of the evaluation owning filters, which filters_free() adds to the */
+/* request's, or straight to the request's if the filter isn't part of an evaluation */
+static zend_always_inline void filters_count(struct eval_filters* filters, uint32_t lookups, uint32_t regex_matches) {
+  if (filters != NULL) {
+    filters->hash_lookups += lookups;
+    filters->regex_matches += regex_matches;
+  } else {
+    JSONPATH_COUNT(hash_lookups, lookups);
+    JSONPATH_COUNT(regex_matches, regex_matches);
   }
+}
 
-  zval tmp = {0};
-  zval* val = evaluate_primary(tok->data.d_unary.right, &tmp, arr_head, arr_cur);
+/* Run instructions [first, last) of a compiled filter, with arr_cur the element being filtered */
+static void filter_exec(struct filter_program* program, zval* r, zval* arr_head, zval* arr_cur, uint32_t first,
+                        uint32_t last, struct eval_filters* filters) {
+  struct filter_op* op = program->ops + first;
+  struct filter_op* end = program->ops + last;
+  uint32_t lookups = 0;
+  uint32_t regex_matches = 0;
+
+  while (op < end) {
+    zval* dst = &r[op->dst];
+    zval* lhs = &r[op->lhs];
+    zval* rhs = &r[op->rhs];
+
+    switch (op->opcode) {
+      case FILTER_CONST:
+        ZVAL_COPY_VALUE(dst, &program->constants[op->lhs]);
+        break;
+      case FILTER_CUR:
+        lookups += filter_fetch(arr_head, arr_cur, op->path, dst, filters);
+        break;
+      case FILTER_ROOT:
+        lookups += filter_fetch(arr_head, arr_head, op->path, dst, filters);
+        break;
+      case FILTER_EXISTS:
+        ZVAL_BOOL(dst, Z_TYPE_P(lhs) != IS_UNDEF);
+        break;
+      case FILTER_MISSING:
+        ZVAL_BOOL(dst, Z_TYPE_P(lhs) == IS_UNDEF);
+        break;
+      case FILTER_IS_TRUE:
+        ZVAL_BOOL(dst, Z_TYPE_P(lhs) == IS_TRUE);
+        break;
+      case FILTER_IS_FALSE:
+        ZVAL_BOOL(dst, Z_TYPE_P(lhs) == IS_FALSE);
+        break;
+      case FILTER_NOT:
+        ZVAL_BOOL(dst, Z_TYPE_P(lhs) != IS_TRUE);
+        break;
+      case FILTER_EQ:
+        ZVAL_BOOL(dst, fast_is_identical_function(lhs, rhs));
+        break;
+      case FILTER_NE:
+        ZVAL_BOOL(dst, !fast_is_identical_function(lhs, rhs));
+        break;
+      case FILTER_LT:
+        ZVAL_BOOL(dst, can_check_inequality(lhs, rhs) && compare(lhs, rhs) < 0);
+        break;
+      case FILTER_LTE:
+        ZVAL_BOOL(dst, can_check_inequality(lhs, rhs) && compare(lhs, rhs) <= 0);
+        break;
+      case FILTER_GT:
+        ZVAL_BOOL(dst, can_check_inequality(lhs, rhs) && compare(lhs, rhs) > 0);
+        break;
+      case FILTER_GTE:
+        ZVAL_BOOL(dst, can_check_inequality(lhs, rhs) && compare(lhs, rhs) >= 0);
+        break;
+      case FILTER_RGXP:
+        if (Z_TYPE_P(lhs) == IS_STRING && Z_TYPE_P(rhs) == IS_STRING) {
+          regex_matches++;
+          ZVAL_BOOL(dst, compare_rgxp(lhs, rhs));
+        } else {
+          ZVAL_FALSE(dst);
+        }
+        break;
+      case FILTER_MATCH:
+        if (Z_TYPE_P(lhs) == IS_STRING && op->regex != NULL) {
+          regex_matches++;
+          ZVAL_BOOL(dst, regex_match(op->regex, Z_STR_P(lhs)));
+        } else {
+          ZVAL_FALSE(dst);
+        }
+        break;
+      case FILTER_JMP_FALSE:
+        if (Z_TYPE_P(dst) == IS_FALSE) {
+          op = program->ops + op->rhs;
+          continue;
+        }
+        break;
+      case FILTER_JMP_TRUE:
+        if (Z_TYPE_P(dst) == IS_TRUE) {
+          op = program->ops + op->rhs;
+          continue;
+        }
+        break;
+    }
 
-  if (Z_TYPE_P(val) == IS_FALSE) {
-    return true;
+    op++;
   }
 
-  return false;
+  filters_count(filters, lookups, regex_matches);
 }
 
-bool evaluate_unary(zval* arr_head, zval* arr_cur, struct ast_node* tok) {
-  zval tmp = {0};
+/* Run the prologue of a filter into its registers r, evaluating the $-rooted operands */
+static void filter_prologue(struct filter_program* program, zval* r, zval* arr_head, struct eval_filters* filters) {
+  filter_exec(program, r, arr_head, NULL, 0, program->prologue_count, filters);
+}
 
-  if (is_unary(tok->data.d_unary.right->type)) {
-    return !evaluate_unary(arr_head, arr_cur, tok->data.d_unary.right);
-  } else if (is_binary(tok->data.d_unary.right->type)) {
-    return !evaluate_binary(arr_head, arr_cur, tok->data.d_unary.right);
-  } else if (tok->data.d_unary.right->type == AST_SELECTOR) {
-    /* ?(!@.selector) */
-    return Z_TYPE_P(evaluate_primary(tok->data.d_unary.right, &tmp, arr_head, arr_cur)) == IS_UNDEF;
+/* Get the registers of a filter applied by the evaluation owning filters, running its prologue the first time. The */
+/* values the prologue loaded are pinned, they must outlive whatever user code runs until the evaluation ends. */
+static zval* filter_regs(struct eval_filters* filters, struct filter_program* program, zval* arr_head) {
+  for (uint32_t i = 0; i < filters->count; i++) {
+    if (filters->entries[i].program == program) {
+      return filters->entries[i].regs;
+    }
   }
 
-  zval* val = evaluate_primary(tok->data.d_unary.right, &tmp, arr_head, arr_cur);
+  zval* r = safe_emalloc(program->reg_count, sizeof(zval), 0);
 
-  if (Z_TYPE_P(val) == IS_FALSE) {
-    return true;
+  /* the prologue may apply filters of its own, adding them to filters */
+  filter_prologue(program, r, arr_head, filters);
+
+  for (uint32_t i = 0; i < program->prologue_count; i++) {
+    Z_TRY_ADDREF(r[program->ops[i].dst]);
   }
 
-  return false;
+  if (filters->count == filters->capacity) {
+    filters->capacity = filters->capacity ? filters->capacity * 2 : 4;
+    filters->entries = safe_erealloc(filters->entries, filters->capacity, sizeof(struct eval_filter), 0);
+  }
+
+  filters->entries[filters->count++] = (struct eval_filter){program, r};
+
+  return r;
 }
 
-bool evaluate_binary(zval* arr_head, zval* arr_cur, struct ast_node* tok) {
-  /* use stack-allocated zvals in order to avoid malloc, if possible */
-  zval tmp_lh = {0}, tmp_rh = {0};
-  zval *val_lh = &tmp_lh, *val_rh = &tmp_rh;
-  struct ast_node *lh_operand = tok->data.d_binary.left, *rh_operand = tok->data.d_binary.right;
-
-  if (is_binary(lh_operand->type)) {
-    bool result = evaluate_binary(arr_head, arr_cur, lh_operand);
-    ZVAL_BOOL(val_lh, result);
-  } else if (is_unary(tok->type)) {
-    bool result = evaluate_unary(arr_head, arr_cur, lh_operand);
-    ZVAL_BOOL(val_lh, result);
-  } else if (lh_operand->type == AST_SELECTOR && (tok->type == AST_OR || tok->type == AST_AND)) {
-    /* ?(@.selector <or|and> [operand]) */
-    bool exists = Z_TYPE_P(evaluate_primary(lh_operand, &tmp_lh, arr_head, arr_cur)) != IS_UNDEF;
-    ZVAL_BOOL(val_lh, exists);
-  } else {
-    val_lh = evaluate_primary(lh_operand, &tmp_lh, arr_head, arr_cur);
-  }
-
-  if (is_binary(rh_operand->type)) {
-    bool result = evaluate_binary(arr_head, arr_cur, rh_operand);
-    ZVAL_BOOL(val_rh, result);
-  } else if (is_unary(tok->type)) {
-    bool result = evaluate_unary(arr_head, arr_cur, rh_operand);
-    ZVAL_BOOL(val_rh, result);
-  } else if (rh_operand->type == AST_SELECTOR && (tok->type == AST_OR || tok->type == AST_AND)) {
-    /* ?([operand] <or|and> @.selector) */
-    bool exists = Z_TYPE_P(evaluate_primary(rh_operand, &tmp_rh, arr_head, arr_cur)) != IS_UNDEF;
-    ZVAL_BOOL(val_rh, exists);
-  } else {
-    val_rh = evaluate_primary(rh_operand, &tmp_rh, arr_head, arr_cur);
-  }
+static void filters_free(struct eval_filters* filters) {
+  for (uint32_t i = 0; i < filters->count; i++) {
+    struct eval_filter* filter = &filters->entries[i];
+
+    for (uint32_t j = 0; j < filter->program->prologue_count; j++) {
+      zval_ptr_dtor(&filter->regs[filter->program->ops[j].dst]);
+    }
 
-  bool ret = false;
+    efree(filter->regs);
+  }
 
-  switch (tok->type) {
-    case AST_EQ:
-      ret = fast_is_identical_function(val_lh, val_rh);
-      break;
-    case AST_NE:
-      ret = !fast_is_identical_function(val_lh, val_rh);
-      break;
-    case AST_LT:
-      ret = can_check_inequality(val_lh, val_rh) && compare(val_lh, val_rh) < 0;
-      break;
-    case AST_LTE:
-      ret = can_check_inequality(val_lh, val_rh) && compare(val_lh, val_rh) <= 0;
-      break;
-    case AST_OR:
-      ret = (Z_TYPE_P(val_lh) == IS_TRUE) || (Z_TYPE_P(val_rh) == IS_TRUE);
-      break;
-    case AST_AND:
-      ret = (Z_TYPE_P(val_lh) == IS_TRUE) && (Z_TYPE_P(val_rh) == IS_TRUE);
-      break;
-    case AST_GT:
-      ret = can_check_inequality(val_lh, val_rh) && compare(val_lh, val_rh) > 0;
-      break;
-    case AST_GTE:
-      ret = can_check_inequality(val_lh, val_rh) && compare(val_lh, val_rh) >= 0;
-      break;
-    case AST_RGXP:
-      ret = compare_rgxp(val_lh, val_rh);
-      break;
-    default:
-      assert(0);
-      break;
+  if (filters->entries != NULL) {
+    efree(filters->entries);
   }
 
-  /* clean up strings allocated in evaluate_primary() */
+  JSONPATH_COUNT(hash_lookups, filters->hash_lookups);
+  JSONPATH_COUNT(regex_matches, filters->regex_matches);
 
-  if (rh_operand->type == AST_LITERAL) {
-    zval_ptr_dtor(val_rh);
+  *filters = (struct eval_filters){0};
+}
+
+/* Get the registers of a filter about to be applied to the children of a node, inline_regs if they fit, and run */
+/* its prologue */
+static zval* filter_enter(struct filter_program* program, zval* arr_head, zval* inline_regs) {
+  zval* r = inline_regs;
+
+  if (program->reg_count > FILTER_INLINE_REGS) {
+    r = safe_emalloc(program->reg_count, sizeof(zval), 0);
   }
 
-FREE_LHS:
-  if (lh_operand->type == AST_LITERAL) {
-    zval_ptr_dtor(val_lh);
+  filter_prologue(program, r, arr_head, NULL);
+
+  return r;
+}
+
+static zend_always_inline bool filter_match(struct filter_program* program, zval* r, zval* arr_head, zval* arr_cur,
+                                            struct eval_filters* filters) {
+  filter_exec(program, r, arr_head, arr_cur, program->prologue_count, program->op_count, filters);
+
+  return Z_TYPE(r[0]) == IS_TRUE;
+}
+
+static void filter_leave(zval* r, zval* inline_regs) {
+  if (r != inline_regs) {
+    efree(r);
   }
+}
+
+/* Run the compiled filter of tok, an AST_EXPR, against arr_cur */
+bool evaluate_expression(zval* arr_head, zval* arr_cur, struct ast_node* tok) {
+  struct filter_program* program = tok->data.d_expression.program;
+  zval inline_regs[FILTER_INLINE_REGS];
+  zval* r = filter_enter(program, arr_head, inline_regs);
+  bool result = filter_match(program, r, arr_head, arr_cur, NULL);
 
-  return ret;
+  filter_leave(r, inline_regs);
+
+  return result;
 }
 
 /* Determine if two zvals can be checked for inequality (>, <, >=, <=). */
@@ -450,4 +1230,266 @@ bool can_check_inequality(zval* lhs, zval* rhs) {
   bool rhs_is_string = Z_TYPE_P(rhs) == IS_STRING;
 
   return lhs_is_string && rhs_is_string;
-}
\ No newline at end of file
+}
+/* A node of the document being matched against a segment of the query, or descended into by a recursive descent */
+struct eval_frame {
+  zval node; /* counted copy, so the node outlives changes the caller makes to the document */
+  struct ast_node* tok;
+  bool descend;
+  bool started;
+  zval* regs; /* registers of the filter, held by the iterator's filters */
+  struct segment_cursor c;
+  zend_ulong produced; /* children produced, counted when the frame is popped */
+};
+
+/* Whether node is being descended into by a frame, i.e. the data is cyclic. Past DESCENT_INLINE_FRAMES frames */
+/* the containers being descended into are kept in a set, as a descent's stack is. */
+static bool iter_on_stack(struct eval_iter* it, zval* node) {
+  if (it->descending != NULL) {
+    return zend_hash_index_exists(it->descending, descent_key(node));
+  }
+
+  for (int i = 0; i < it->frame_count; i++) {
+    struct eval_frame* f = &it->frames[i];
+    if (f->descend && Z_COUNTED(f->node) == Z_COUNTED_P(node)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/* Schedule matching tok against node, scalars never produce matches so they don't get a frame */
+static void iter_push(struct eval_iter* it, zval* node, struct ast_node* tok, bool descend) {
+  while (!descend && tok != NULL && tok->type == AST_ROOT) {
+    tok = tok->next;
+  }
+
+  if (!descend && tok != NULL && tok->type == AST_RECURSE) {
+    tok = tok->next;
+    descend = true;
+  }
+
+  ZVAL_DEREF(node);
+
+  if (tok == NULL || node_children(node) == NULL) {
+    return;
+  }
+
+  if (descend && iter_on_stack(it, node)) {
+    return;
+  }
+
+  if (it->frame_count == it->frame_cap) {
+    it->frame_cap = it->frame_cap ? it->frame_cap * 2 : 8;
+    it->frames = erealloc(it->frames, sizeof(struct eval_frame) * it->frame_cap);
+  }
+
+  struct eval_frame* f = &it->frames[it->frame_count++];
+
+  ZVAL_COPY(&f->node, node);
+  f->tok = tok;
+  f->descend = descend;
+  f->started = false;
+  f->c.pos = 0;
+  f->c.candidates = 0;
+  f->produced = 0;
+
+  if (it->descending == NULL && it->frame_count > DESCENT_INLINE_FRAMES) {
+    ALLOC_HASHTABLE(it->descending);
+    zend_hash_init(it->descending, DESCENT_INLINE_FRAMES * 2, NULL, NULL, 0);
+
+    for (int i = 0; i < it->frame_count; i++) {
+      if (it->frames[i].descend) {
+        zend_hash_index_add_empty_element(it->descending, descent_key(&it->frames[i].node));
+      }
+    }
+  } else if (it->descending != NULL && descend) {
+    zend_hash_index_add_empty_element(it->descending, descent_key(&f->node));
+  }
+}
+
+/* Add the work of a frame to the request's counters, the way the eager evaluation counts its segment */
+static void iter_count(struct eval_frame* f) {
+  if (f->descend) {
+    JSONPATH_COUNT(nodes_visited, f->produced);
+    return;
+  }
+
+  switch (f->tok->type) {
+    case AST_SELECTOR:
+      JSONPATH_COUNT(hash_lookups, f->c.pos > 0);
+      JSONPATH_COUNT(nodes_visited, f->produced);
+      break;
+    case AST_EXPR:
+      JSONPATH_COUNT(nodes_visited, f->c.candidates);
+      break;
+    case AST_INDEX_LIST:
+    case AST_INDEX_SLICE:
+      JSONPATH_COUNT(hash_lookups, f->c.candidates);
+      JSONPATH_COUNT(nodes_visited, f->produced);
+      break;
+    default:
+      JSONPATH_COUNT(nodes_visited, f->produced);
+      break;
+  }
+}
+
+static void iter_pop(struct eval_iter* it) {
+  struct eval_frame* f = &it->frames[--it->frame_count];
+
+  if (it->descending != NULL && f->descend) {
+    zend_hash_index_del(it->descending, descent_key(&f->node));
+  }
+
+  iter_count(f);
+  zval_ptr_dtor(&f->node);
+}
+
+/* Position a frame before its first child. Returns false if the frame can't produce any. */
+static bool iter_start(struct eval_iter* it, struct eval_frame* f) {
+  f->started = true;
+
+  if (!cursor_start(&f->c, &f->node, f->descend ? NULL : f->tok)) {
+    return false;
+  }
+
+  if (!f->descend && f->tok->type == AST_EXPR) {
+    f->regs = filter_regs(&it->filters, f->tok->data.d_expression.program, &it->root);
+  }
+
+  return true;
+}
+
+/* Produce the next child of a frame selected by its segment, or NULL once the frame is exhausted. The children */
+/* are produced by the step functions the eager evaluation uses. */
+static zval* iter_step(struct eval_iter* it, struct eval_frame* f) {
+  zval* node = &f->node;
+
+  if (!f->started && !iter_start(it, f)) {
+    return NULL;
+  }
+
+  /* user code may have replaced the property table of an object since the last match */
+  f->c.ht = node_children(node);
+
+  if (f->descend) {
+    return descent_next(&f->c, node);
+  }
+
+  switch (f->tok->type) {
+    case AST_SELECTOR:
+      if (f->c.pos++ > 0) {
+        return NULL;
+      }
+      return find_child(node, f->c.ht, f->tok);
+    case AST_WILD_CARD:
+      return children_next(&f->c, node);
+    case AST_EXPR:
+      return filter_next(&f->c, node, f->tok->data.d_expression.program, f->regs, &it->root, &it->filters);
+    case AST_INDEX_LIST:
+      return index_list_next(&f->c, node, f->tok);
+    case AST_INDEX_SLICE:
+      return slice_next(&f->c, node);
+    default:
+      assert(0);
+      return NULL;
+  }
+}
+
+/* Start a lazy evaluation of the query at head against root, matches are produced by eval_iter_next() */
+void eval_iter_init(struct eval_iter* it, zval* root, struct ast_node* head) {
+  ZVAL_COPY(&it->root, root);
+  it->head = head;
+  it->frames = NULL;
+  it->frame_count = 0;
+  it->frame_cap = 0;
+  it->descending = NULL;
+  it->filters = (struct eval_filters){0};
+
+  iter_push(it, &it->root, head, false);
+}
+
+/*
+ * Resume the evaluation until the next match, in the same order the eager evaluation produces them. The match lives
+ * in a node held by the iterator and stays valid until the next call. Returns NULL once all matches were produced.
+ */
+zval* eval_iter_next(struct eval_iter* it) {
+  while (it->frame_count > 0) {
+    struct eval_frame* f = &it->frames[it->frame_count - 1];
+
+    if (f->descend && !f->started) {
+      /* a node's own matches come before the matches of its descendants */
+      zval node;
+      ZVAL_COPY_VALUE(&node, &f->node);
+      iter_start(it, f);
+      iter_push(it, &node, f->tok, false);
+      continue;
+    }
+
+    zval* data = iter_step(it, f);
+
+    if (data != NULL) {
+      f->produced++;
+    }
+
+    if (data == NULL) {
+      iter_pop(it);
+    } else if (f->descend) {
+      iter_push(it, data, f->tok, true);
+    } else if (f->tok->next == NULL) {
+      return data;
+    } else {
+      iter_push(it, data, f->tok->next, false);
+    }
+
+    if (EG(exception)) {
+      break;
+    }
+  }
+
+  return NULL;
+}
+
+void eval_iter_rewind(struct eval_iter* it) {
+  while (it->frame_count > 0) {
+    iter_pop(it);
+  }
+
+  /* the document may have changed since, objects are shared with the caller */
+  filters_free(&it->filters);
+  iter_push(it, &it->root, it->head, false);
+}
+
+/* Report the values the evaluation holds references to: the document, the nodes of its frames and the operands */
+/* the filter prologues pinned */
+void eval_iter_gc(struct eval_iter* it, zend_get_gc_buffer* gc) {
+  zend_get_gc_buffer_add_zval(gc, &it->root);
+
+  for (int i = 0; i < it->frame_count; i++) {
+    zend_get_gc_buffer_add_zval(gc, &it->frames[i].node);
+  }
+
+  for (uint32_t i = 0; i < it->filters.count; i++) {
+    struct eval_filter* filter = &it->filters.entries[i];
+
+    for (uint32_t j = 0; j < filter->program->prologue_count; j++) {
+      zend_get_gc_buffer_add_zval(gc, &filter->regs[filter->program->ops[j].dst]);
+    }
+  }
+}
+
+void eval_iter_destroy(struct eval_iter* it) {
+  while (it->frame_count > 0) {
+    iter_pop(it);
+  }
+
+  if (it->descending != NULL) {
+    zend_hash_destroy(it->descending);
+    FREE_HASHTABLE(it->descending);
+  }
+
+  efree(it->frames);
+  filters_free(&it->filters);
+  zval_ptr_dtor(&it->root);
+}
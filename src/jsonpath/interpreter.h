@@ -4,6 +4,133 @@
 #include "parser.h"
 #include "php.h"
 
-void eval_ast(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* return_value);
+#if PHP_VERSION_ID < 80000
+/* PHP 8's list of the values an object reports to the cycle collector. PHP 7 lends none to get_gc handlers, */
+/* so the object keeps its own and releases it with its other state. */
+typedef struct {
+  zval* cur;
+  zval* end;
+  zval* start;
+} zend_get_gc_buffer;
 
-#endif /* INTERPRETER_H */
\ No newline at end of file
+static inline void zend_get_gc_buffer_add_zval(zend_get_gc_buffer* gc_buffer, zval* zv) {
+  if (!Z_REFCOUNTED_P(zv)) {
+    return;
+  }
+
+  if (gc_buffer->cur == gc_buffer->end) {
+    size_t size = gc_buffer->end - gc_buffer->start;
+    size_t new_size = size ? size * 2 : 16;
+
+    gc_buffer->start = safe_erealloc(gc_buffer->start, new_size, sizeof(zval), 0);
+    gc_buffer->cur = gc_buffer->start + size;
+    gc_buffer->end = gc_buffer->start + new_size;
+  }
+
+  ZVAL_COPY_VALUE(gc_buffer->cur, zv);
+  gc_buffer->cur++;
+}
+
+static inline void zend_get_gc_buffer_use(zend_get_gc_buffer* gc_buffer, zval** table, int* n) {
+  *table = gc_buffer->start;
+  *n = (int)(gc_buffer->cur - gc_buffer->start);
+}
+#endif
+
+/* Key of a node in its parent, key is NULL for integer keys */
+struct eval_path_segment {
+  zend_string* key;
+  zend_long index;
+  bool is_member;
+};
+
+/* Keys from the root to the node being visited, reused across evaluations */
+struct eval_path {
+  struct eval_path_segment* segments;
+  uint32_t count;
+  uint32_t capacity;
+  bool as_keys;
+};
+
+/* Counters of a plan node, collected by JsonPath::profile() */
+struct eval_profile_node {
+  zend_ulong visits;     /* values the segment was applied to */
+  zend_ulong candidates; /* children, keys and containers the segment examined, i.e. filter evaluations */
+  zend_ulong matches;    /* values the segment selected */
+  zend_ulong time_ns;    /* time spent in the segment, not counting the segments after it */
+};
+
+/* Counters of a profiled evaluation, one per node of the plan */
+struct eval_profile {
+  struct ast_node* nodes;
+  struct eval_profile_node* counters;
+  int current;      /* the node being evaluated, -1 if none */
+  zend_ulong since; /* when the current node started being timed */
+};
+
+/* Registers of a filter applied by an evaluation, with its prologue run when the filter was first applied */
+struct eval_filter {
+  struct filter_program* program;
+  zval* regs;
+};
+
+/* The $-rooted operands of a filter don't change during an evaluation, so the prologue evaluating them runs once */
+/* per evaluation, however many containers the filter is applied to. The work of the filters is counted here too, */
+/* and added to the request's counters once the evaluation ends. */
+struct eval_filters {
+  struct eval_filter* entries;
+  uint32_t count;
+  uint32_t capacity;
+  zend_ulong hash_lookups;
+  zend_ulong regex_matches;
+};
+
+/* State of an evaluation: where matches go, and when to stop looking for more */
+struct eval_ctx {
+  zval* result;    /* array collecting the matches, or IS_INDIRECT pointing to the first match */
+  zend_long limit; /* number of matches after which evaluation halts, 0 for no limit */
+  zend_long count;
+  struct eval_path* path; /* if set, the normalized paths of the matches are collected instead of their values */
+  /* if set, receives every node selected by a segment instead of the next segment being evaluated on it */
+  void (*visit)(zval* arr_head, zval* node, struct eval_ctx* ctx);
+  void* visit_data;
+  struct eval_profile* profile; /* if set, the segments count their work into it */
+  struct descent_scope* descent; /* the innermost recursive descent being evaluated, or NULL */
+  struct eval_filters* filters; /* own_filters, or those of the evaluation this one is part of */
+  struct eval_filters own_filters;
+};
+
+static inline bool eval_halted(struct eval_ctx* ctx) { return ctx->limit > 0 && ctx->count >= ctx->limit; }
+
+void eval_init(struct eval_ctx* ctx, zval* result, zend_long limit);
+void eval_free(struct eval_ctx* ctx);
+void eval_report_paths(struct eval_ctx* ctx, struct eval_path* path, bool as_keys);
+void eval_path_free(struct eval_path* path);
+void eval_profile_init(struct eval_profile* profile, struct query_plan* plan);
+void eval_profile_free(struct eval_profile* profile);
+void eval_first(zval* arr_head, zval* arr_cur, struct ast_node* tok, zval* result);
+void eval_ast(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx);
+void exec_recursive_descent(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx);
+void copy_result_or_continue(zval* arr_head, zval* arr_cur, struct ast_node* tok, struct eval_ctx* ctx);
+bool evaluate_expression(zval* arr_head, zval* arr_cur, struct ast_node* tok); /* tok is an AST_EXPR */
+
+struct eval_frame;
+
+/* Suspended evaluation, keeping the traversal on an explicit stack instead of the C stack */
+struct eval_iter {
+  zval root;
+  struct ast_node* head;
+  struct eval_frame* frames;
+  int frame_count;
+  int frame_cap;
+  HashTable* descending; /* the nodes of the frames descended into once there are many frames, or NULL */
+  struct eval_filters filters;
+};
+
+void eval_iter_init(struct eval_iter* it, zval* root, struct ast_node* head);
+zval* eval_iter_next(struct eval_iter* it);
+void eval_iter_rewind(struct eval_iter* it);
+void eval_iter_destroy(struct eval_iter* it);
+void eval_iter_gc(struct eval_iter* it, zend_get_gc_buffer* gc);
+
+#endif /* INTERPRETER_H */
@@ -12,13 +12,11 @@
 #include <stdbool.h>
 #include <stdio.h>
 
-#include "safe_string.h"
-
 static int count_numeric_str_len(char* p);
-static bool extract_quoted_literal(char* p, char* buffer, size_t bufSize, char* json_path);
-static bool extract_unbounded_literal(char* p, char* buffer, size_t bufSize, char* json_path);
-static bool extract_unbounded_numeric_literal(char* p, char* buffer, size_t bufSize, char* json_path);
-static bool extract_boolean_or_null_literal(char* p, char* buffer, size_t bufSize, char* json_path);
+static bool extract_quoted_literal(char* p, struct lex_literal* literal, char* json_path);
+static bool extract_unbounded_literal(char* p, struct lex_literal* literal, char* json_path);
+static bool extract_unbounded_numeric_literal(char* p, struct lex_literal* literal, char* json_path);
+static bool extract_boolean_or_null_literal(char* p, struct lex_literal* literal, char* json_path);
 
 const char* LEX_STR[] = {
     "LEX_NOT_FOUND",       /* Token not found */
@@ -55,10 +53,12 @@ void raise_error(const char* msg, char* json_path, char* cur_pos) {
   zend_throw_exception_ex(spl_ce_RuntimeException, 0, "%s at position %ld", msg, (cur_pos - json_path));
 }
 
-lex_token scan(char** p, char* buffer, size_t bufSize, char* json_path) {
-  char* start = *p;
+lex_token scan(char** p, struct lex_literal* literal, char* json_path) {
   lex_token found_token = LEX_NOT_FOUND;
 
+  literal->val = "";
+  literal->len = 0;
+
   while (**p != '\0' && found_token == LEX_NOT_FOUND) {
     switch (**p) {
       case '$':
@@ -96,11 +96,11 @@ lex_token scan(char** p, char* buffer, size_t bufSize, char* json_path) {
             return LEX_ERR;
           }
 
-          if (!extract_unbounded_literal(*p, buffer, bufSize, json_path)) {
+          if (!extract_unbounded_literal(*p, literal, json_path)) {
             return LEX_ERR;
           }
 
-          *p += strlen(buffer) - 1;
+          *p += (ptrdiff_t)literal->len - 1;
         }
 
         break;
@@ -112,10 +112,10 @@ lex_token scan(char** p, char* buffer, size_t bufSize, char* json_path) {
 
         switch (**p) {
           case '\'':
-            if (!extract_quoted_literal(*p, buffer, bufSize, json_path)) {
+            if (!extract_quoted_literal(*p, literal, json_path)) {
               return LEX_ERR;
             }
-            *p += strlen(buffer) + 2;
+            *p += literal->len + 2;
 
             for (; **p == ' '; (*p)++)
               ;
@@ -127,10 +127,10 @@ lex_token scan(char** p, char* buffer, size_t bufSize, char* json_path) {
             found_token = LEX_NODE;
             break;
           case '"':
-            if (!extract_quoted_literal(*p, buffer, bufSize, json_path)) {
+            if (!extract_quoted_literal(*p, literal, json_path)) {
               return LEX_ERR;
             }
-            *p += strlen(buffer) + 2;
+            *p += literal->len + 2;
 
             for (; **p == ' '; (*p)++)
               ;
@@ -227,17 +227,17 @@ lex_token scan(char** p, char* buffer, size_t bufSize, char* json_path) {
         found_token = LEX_PAREN_CLOSE;
         break;
       case '\'':
-        if (!extract_quoted_literal(*p, buffer, bufSize, json_path)) {
+        if (!extract_quoted_literal(*p, literal, json_path)) {
           return LEX_ERR;
         }
-        *p += strlen(buffer) + 1;
+        *p += literal->len + 1;
         found_token = LEX_LITERAL;
         break;
       case '"':
-        if (!extract_quoted_literal(*p, buffer, bufSize, json_path)) {
+        if (!extract_quoted_literal(*p, literal, json_path)) {
           return LEX_ERR;
         }
-        *p += strlen(buffer) + 1;
+        *p += literal->len + 1;
         found_token = LEX_LITERAL;
         break;
       case '*':
@@ -247,18 +247,18 @@ lex_token scan(char** p, char* buffer, size_t bufSize, char* json_path) {
       case 'T':
       case 'f':
       case 'F':
-        if (!extract_boolean_or_null_literal(*p, buffer, bufSize, json_path)) {
+        if (!extract_boolean_or_null_literal(*p, literal, json_path)) {
           return LEX_ERR;
         }
-        *p += strlen(buffer) - 1;
+        *p += (ptrdiff_t)literal->len - 1;
         found_token = LEX_LITERAL_BOOL;
         break;
       case 'n':
       case 'N':
-        if (!extract_boolean_or_null_literal(*p, buffer, bufSize, json_path)) {
+        if (!extract_boolean_or_null_literal(*p, literal, json_path)) {
           return LEX_ERR;
         }
-        *p += strlen(buffer) - 1;
+        *p += (ptrdiff_t)literal->len - 1;
         found_token = LEX_LITERAL_NULL;
         break;
       case '-':
@@ -272,10 +272,10 @@ lex_token scan(char** p, char* buffer, size_t bufSize, char* json_path) {
       case '7':
       case '8':
       case '9':
-        if (!extract_unbounded_numeric_literal(*p, buffer, bufSize, json_path)) {
+        if (!extract_unbounded_numeric_literal(*p, literal, json_path)) {
           return LEX_ERR;
         }
-        *p += strlen(buffer) - 1;
+        *p += (ptrdiff_t)literal->len - 1;
         found_token = LEX_LITERAL_NUMERIC;
         break;
       case ' ':
@@ -292,12 +292,49 @@ lex_token scan(char** p, char* buffer, size_t bufSize, char* json_path) {
   return found_token;
 }
 
+void lex_tokens_init(struct lex_tokens* tokens) {
+  tokens->tok = tokens->inline_tok;
+  tokens->literals = tokens->inline_literals;
+  tokens->count = 0;
+  tokens->cap = LEX_TOKENS_INLINE;
+}
+
+void lex_tokens_add(struct lex_tokens* tokens, lex_token tok, struct lex_literal literal) {
+  if (tokens->count == tokens->cap) {
+    int cap = tokens->cap * 2;
+
+    if (tokens->tok == tokens->inline_tok) {
+      tokens->tok = safe_emalloc(cap, sizeof(lex_token), 0);
+      tokens->literals = safe_emalloc(cap, sizeof(struct lex_literal), 0);
+      memcpy(tokens->tok, tokens->inline_tok, sizeof(tokens->inline_tok));
+      memcpy(tokens->literals, tokens->inline_literals, sizeof(tokens->inline_literals));
+    } else {
+      tokens->tok = safe_erealloc(tokens->tok, cap, sizeof(lex_token), 0);
+      tokens->literals = safe_erealloc(tokens->literals, cap, sizeof(struct lex_literal), 0);
+    }
+
+    tokens->cap = cap;
+  }
+
+  tokens->tok[tokens->count] = tok;
+  tokens->literals[tokens->count] = literal;
+  tokens->count++;
+}
+
+void lex_tokens_free(struct lex_tokens* tokens) {
+  if (tokens->tok != tokens->inline_tok) {
+    efree(tokens->tok);
+    efree(tokens->literals);
+  }
+
+  lex_tokens_init(tokens);
+}
+
 /* Extract contents of string bounded by either single or double quotes */
-static bool extract_quoted_literal(char* p, char* buffer, size_t bufSize, char* json_path) {
-  char* start;
+static bool extract_quoted_literal(char* p, struct lex_literal* literal, char* json_path) {
+  char* start = p;
   char quote_type;
   bool quote_found = false;
-  size_t cpy_len;
 
   for (; *p != '\0' && (*p == '\'' || *p == '"' || *p == ' '); p++) {
     // Find first occurrence
@@ -316,23 +353,18 @@ static bool extract_quoted_literal(char* p, char* buffer, size_t bufSize, char*
 
   start = p;
 
-  for (; *p != '\0' && *p != quote_type && *(p - 1) != '\\'; p++)
+  for (; *p != '\0' && *p != quote_type; p++)
     ;
 
-  cpy_len = (size_t)(p - start);
-
-  if (jp_str_cpy(buffer, bufSize, start, cpy_len) > 0) {
-    raise_error("String exceeded buffer size", json_path, start + bufSize);
-    return false;
-  }
+  literal->val = start;
+  literal->len = (size_t)(p - start);
 
   return true;
 }
 
 /* Extract literal without clear bounds that ends in non alpha-numeric char */
-static bool extract_unbounded_literal(char* p, char* buffer, size_t bufSize, char* json_path) {
+static bool extract_unbounded_literal(char* p, struct lex_literal* literal, char* json_path) {
   char* start;
-  size_t cpy_len;
 
   for (; *p == ' '; p++)
     ;
@@ -342,12 +374,8 @@ static bool extract_unbounded_literal(char* p, char* buffer, size_t bufSize, cha
   for (; *p != '\0' && !isspace(*p) && (*p == '_' || *p == '-' || !ispunct(*p)); p++)
     ;
 
-  cpy_len = (size_t)(p - start);
-
-  if (jp_str_cpy(buffer, bufSize, start, cpy_len) > 0) {
-    raise_error("String exceeded buffer size", json_path, start + bufSize);
-    return false;
-  }
+  literal->val = start;
+  literal->len = (size_t)(p - start);
 
   return true;
 }
@@ -369,20 +397,16 @@ static int count_numeric_str_len(char* p) {
 }
 
 /* Extract literal without clear bounds that ends in non alpha-numeric char */
-static bool extract_unbounded_numeric_literal(char* p, char* buffer, size_t bufSize, char* json_path) {
-  int len = count_numeric_str_len(p);
+static bool extract_unbounded_numeric_literal(char* p, struct lex_literal* literal, char* json_path) {
+  literal->val = p;
+  literal->len = count_numeric_str_len(p);
 
-  if (jp_str_cpy(buffer, bufSize, p, len) > 0) {
-    raise_error("String exceeded buffer size", json_path, p + bufSize);
-    return false;
-  }
   return true;
 }
 
 /* Extract boolean or null */
-static bool extract_boolean_or_null_literal(char* p, char* buffer, size_t bufSize, char* json_path) {
+static bool extract_boolean_or_null_literal(char* p, struct lex_literal* literal, char* json_path) {
   char* start;
-  size_t cpy_len;
 
   for (; *p == ' '; p++)
     ;
@@ -392,12 +416,8 @@ static bool extract_boolean_or_null_literal(char* p, char* buffer, size_t bufSiz
   for (; *p != '\0' && !isspace(*p) && (*p == '_' || *p == '-' || !ispunct(*p)); p++)
     ;
 
-  cpy_len = (size_t)(p - start);
-
-  if (jp_str_cpy(buffer, bufSize, start, cpy_len) > 0) {
-    raise_error("String exceeded buffer size", json_path, start + bufSize);
-    return false;
-  }
+  literal->val = start;
+  literal->len = (size_t)(p - start);
 
   return true;
-}
\ No newline at end of file
+}
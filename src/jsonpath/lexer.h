@@ -36,6 +36,28 @@ typedef enum {
 
 extern const char* LEX_STR[];
 
-lex_token scan(char** p, char* buffer, size_t bufSize, char* json_path);
+/* Number of tokens stored inline before the token list grows on the heap */
+#define LEX_TOKENS_INLINE 32
+
+/* The text of a token, pointing into the JSON-path string */
+struct lex_literal {
+  const char* val;
+  size_t len;
+};
+
+/* Tokens of a JSON-path string. Short queries fit in the inline buffers. */
+struct lex_tokens {
+  lex_token* tok;
+  struct lex_literal* literals;
+  int count;
+  int cap;
+  lex_token inline_tok[LEX_TOKENS_INLINE];
+  struct lex_literal inline_literals[LEX_TOKENS_INLINE];
+};
+
+lex_token scan(char** p, struct lex_literal* literal, char* json_path);
+void lex_tokens_init(struct lex_tokens* tokens);
+void lex_tokens_add(struct lex_tokens* tokens, lex_token tok, struct lex_literal literal);
+void lex_tokens_free(struct lex_tokens* tokens);
 
 #endif /* LEXER_H */
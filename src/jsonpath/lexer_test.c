@@ -1,6 +1,7 @@
 #include "lexer.h"
 
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 
 /*
@@ -199,12 +200,15 @@ bool evaluate_test(lex_token expected_token, char* expected_value, char* expecte
 bool test(char* description, char* input_str, lex_token expected_token, char* expected_value,
           char* expected_remaining) {
   lex_token actual_token;
+  struct lex_literal literal;
   char buffer[1000];
   buffer[0] = '\0';
 
   print_test_behavior(description, &input_str, buffer, sizeof(buffer));
 
-  actual_token = scan(&input_str, buffer, sizeof(buffer));
+  actual_token = scan(&input_str, &literal, input_str);
+
+  snprintf(buffer, sizeof(buffer), "%.*s", (int)literal.len, literal.val);
 
   return evaluate_test(expected_token, expected_value, expected_remaining, actual_token, buffer, input_str);
 }
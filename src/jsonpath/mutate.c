@@ -0,0 +1,218 @@
+#include "mutate.h"
+
+#include "interpreter.h"
+
+/* Writes to the matches of a query in place. The matches are located with the interpreter, recording the keys */
+/* leading to each of them, then every match is reached again by following its keys from the root. Only the */
+/* arrays on the way to a match are separated, everything else stays shared with other copies of the data. */
+/* Matches are visited in reverse order so descendants are written before their ancestors. The writes aren't */
+/* made during the evaluation: its cursors would walk arrays being separated, deleted from or changed by a */
+/* callback, and a descent visits ancestors first. See benchmarks/mutate.php for the cost of the second walk. */
+
+/* Look up the slot of a child, separating the parent first if it's a shared array and separate is set */
+static zval* mutate_child(zval* node, zval* key, bool separate) {
+  HashTable* ht;
+  zval* child;
+
+  ZVAL_DEREF(node);
+
+  switch (Z_TYPE_P(node)) {
+    case IS_ARRAY:
+      if (separate) {
+        SEPARATE_ARRAY(node);
+      }
+      ht = Z_ARRVAL_P(node);
+      break;
+    case IS_OBJECT:
+      ht = Z_OBJPROP_P(node);
+      break;
+    default:
+      return NULL;
+  }
+
+  if (Z_TYPE_P(key) == IS_LONG) {
+    child = zend_hash_index_find(ht, Z_LVAL_P(key));
+  } else {
+    child = zend_hash_find(ht, Z_STR_P(key));
+  }
+
+  if (child != NULL && Z_TYPE_P(child) == IS_INDIRECT) {
+    child = Z_INDIRECT_P(child);
+    if (Z_ISUNDEF_P(child)) {
+      return NULL;
+    }
+  }
+
+  return child;
+}
+
+/* Follow keys from the root to the parent of a match. Returns NULL if the match is gone, e.g. because an */
+/* ancestor of it was deleted. */
+static zval* mutate_parent(zval* data, HashTable* keys, bool separate) {
+  uint32_t depth = zend_hash_num_elements(keys);
+  zval* node = data;
+
+  for (uint32_t i = 0; i + 1 < depth; i++) {
+    if ((node = mutate_child(node, zend_hash_index_find(keys, i), separate)) == NULL) {
+      return NULL;
+    }
+  }
+
+  ZVAL_DEREF(node);
+
+  return node;
+}
+
+/* Assign to a property through the object handlers, so property types are enforced */
+static void mutate_property(zval* object, zval* key, zval* value) {
+#if PHP_MAJOR_VERSION >= 8
+  zend_update_property_ex(Z_OBJCE_P(object), Z_OBJ_P(object), Z_STR_P(key), value);
+#else
+  zend_update_property_ex(Z_OBJCE_P(object), object, Z_STR_P(key), value);
+#endif
+}
+
+static bool mutate_set(zval* data, HashTable* keys, zval* key, zval* value) {
+  zval* parent;
+  zval* slot;
+
+  if ((parent = mutate_parent(data, keys, true)) == NULL || (slot = mutate_child(parent, key, true)) == NULL) {
+    return false;
+  }
+
+  if (Z_TYPE_P(parent) == IS_OBJECT) {
+    mutate_property(parent, key, value);
+  } else {
+    ZEND_TRY_ASSIGN_COPY(slot, value);
+  }
+
+  return true;
+}
+
+static bool mutate_update(zval* data, HashTable* keys, zval* key, zend_fcall_info* fci, zend_fcall_info_cache* fcc) {
+  zval* parent;
+  zval* slot;
+  zval arg, retval;
+
+  /* call the callback before separating anything, it may change the data itself */
+
+  if ((parent = mutate_parent(data, keys, false)) == NULL || (slot = mutate_child(parent, key, false)) == NULL) {
+    return false;
+  }
+
+  ZVAL_COPY_DEREF(&arg, slot);
+  ZVAL_UNDEF(&retval);
+
+  fci->retval = &retval;
+  fci->params = &arg;
+  fci->param_count = 1;
+
+  zend_call_function(fci, fcc);
+  zval_ptr_dtor(&arg);
+
+  if (EG(exception) || Z_ISUNDEF(retval)) {
+    zval_ptr_dtor(&retval);
+    return false;
+  }
+
+  if ((parent = mutate_parent(data, keys, true)) == NULL || (slot = mutate_child(parent, key, true)) == NULL) {
+    zval_ptr_dtor(&retval);
+    return false;
+  }
+
+  if (Z_TYPE_P(parent) == IS_OBJECT) {
+    mutate_property(parent, key, &retval);
+    zval_ptr_dtor(&retval);
+  } else {
+    ZEND_TRY_ASSIGN_VALUE(slot, &retval);
+  }
+
+  return true;
+}
+
+static bool mutate_delete(zval* data, HashTable* keys, zval* key) {
+  zval* parent;
+
+  if ((parent = mutate_parent(data, keys, true)) == NULL || mutate_child(parent, key, false) == NULL) {
+    return false;
+  }
+
+  if (Z_TYPE_P(parent) == IS_OBJECT) {
+#if PHP_MAJOR_VERSION >= 8
+    zend_unset_property(Z_OBJCE_P(parent), Z_OBJ_P(parent), Z_STRVAL_P(key), Z_STRLEN_P(key));
+#else
+    zend_unset_property(Z_OBJCE_P(parent), parent, Z_STRVAL_P(key), Z_STRLEN_P(key));
+#endif
+    return true;
+  }
+
+  SEPARATE_ARRAY(parent);
+
+  if (Z_TYPE_P(key) == IS_LONG) {
+    zend_hash_index_del(Z_ARRVAL_P(parent), Z_LVAL_P(key));
+  } else {
+    zend_hash_del(Z_ARRVAL_P(parent), Z_STR_P(key));
+  }
+
+  return true;
+}
+
+/* Apply op to every match of plan in data. Returns the number of matches written to, or -1 if an exception was */
+/* thrown, in which case the writes made so far are kept. */
+zend_long mutate(zval* data, struct query_plan* plan, enum mutate_op op, zval* value, zend_fcall_info* fci,
+                 zend_fcall_info_cache* fcc) {
+  struct eval_ctx ctx;
+  struct eval_path path = {0};
+  zval matches;
+  zend_long count = 0;
+
+  array_init(&matches);
+
+  eval_init(&ctx, &matches, 0);
+  eval_report_paths(&ctx, &path, true);
+  eval_ast(data, data, plan->head, &ctx);
+  eval_free(&ctx);
+  eval_path_free(&path);
+
+  zval* keys;
+
+  ZEND_HASH_REVERSE_FOREACH_VAL(Z_ARRVAL(matches), keys) {
+    if (EG(exception)) {
+      break;
+    }
+
+    HashTable* ht = Z_ARRVAL_P(keys);
+    bool written;
+
+    if (zend_hash_num_elements(ht) == 0) {
+      continue;
+    }
+
+    zval* key = zend_hash_index_find(ht, zend_hash_num_elements(ht) - 1);
+
+    switch (op) {
+      case MUTATE_SET:
+        written = mutate_set(data, ht, key, value);
+        break;
+      case MUTATE_UPDATE:
+        written = mutate_update(data, ht, key, fci, fcc);
+        break;
+      case MUTATE_DELETE:
+        written = mutate_delete(data, ht, key);
+        break;
+      default:
+        assert(0);
+        written = false;
+        break;
+    }
+
+    if (written) {
+      count++;
+    }
+  }
+  ZEND_HASH_FOREACH_END();
+
+  zval_ptr_dtor(&matches);
+
+  return EG(exception) ? -1 : count;
+}
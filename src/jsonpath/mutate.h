@@ -0,0 +1,18 @@
+#ifndef MUTATE_H
+#define MUTATE_H 1
+
+#include <stdbool.h>
+
+#include "parser.h"
+#include "php.h"
+
+enum mutate_op {
+  MUTATE_SET,    /* replace every match with a value */
+  MUTATE_UPDATE, /* replace every match with what a callback returns for it */
+  MUTATE_DELETE  /* remove every match from its parent */
+};
+
+zend_long mutate(zval* data, struct query_plan* plan, enum mutate_op op, zval* value, zend_fcall_info* fci,
+                 zend_fcall_info_cache* fcc);
+
+#endif /* MUTATE_H */
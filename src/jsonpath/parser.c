@@ -1,11 +1,10 @@
 #include "parser.h"
 
-#include <limits.h>
 #include <stdio.h>
 
 #include <ext/spl/spl_exceptions.h>
 
-#include "safe_string.h"
+#include "filter.h"
 #include "zend_exceptions.h"
 
 #define CONSUME_TOKEN() (*lex_idx)++
@@ -13,12 +12,18 @@
 #define CUR_TOKEN_LITERAL() lex_tok_values[*lex_idx]
 #define CUR_TOKEN() lex_token[*lex_idx]
 #define HAS_TOKEN() *lex_idx < lex_tok_count
-#define PARSER_ARGS lex_token, lex_tok_values, lex_idx, lex_tok_count
+#define PARSER_ARGS plan, lex_token, lex_tok_values, lex_idx, lex_tok_count
 #define PARSER_PARAMS \
-  lex_token lex_token[PARSE_BUF_LEN], char lex_tok_values[][PARSE_BUF_LEN], int *lex_idx, int lex_tok_count
+  struct query_plan *plan, lex_token lex_token[], struct lex_literal lex_tok_values[], int *lex_idx, int lex_tok_count
 
-static struct ast_node* ast_alloc_binary(enum ast_type type, struct ast_node* left, struct ast_node* right);
-static struct ast_node* ast_alloc_node(struct ast_node* prev, enum ast_type type);
+static struct ast_node* ast_alloc_binary(struct query_plan* plan, enum ast_type type, struct ast_node* left,
+                                         struct ast_node* right);
+static struct ast_node* ast_alloc_node(struct query_plan* plan, struct ast_node* prev, enum ast_type type);
+static zend_string* plan_string(struct query_plan* plan, const char* str, size_t len);
+static zend_string* plan_node_string(struct ast_node* node);
+static void plan_overflow(struct query_plan* plan);
+static void make_selector_node(struct query_plan* plan, struct ast_node* tok, struct lex_literal literal);
+static void plan_relocate(struct query_plan* plan, ptrdiff_t delta);
 
 static struct ast_node* parse_expression(PARSER_PARAMS);
 static struct ast_node* parse_or(PARSER_PARAMS);
@@ -28,13 +33,12 @@ static struct ast_node* parse_comparison(PARSER_PARAMS);
 static struct ast_node* parse_primary(PARSER_PARAMS);
 static struct ast_node* parse_unary(PARSER_PARAMS);
 
-static bool parse_filter_list(lex_token lex_token[PARSE_BUF_LEN], char lex_tok_values[][PARSE_BUF_LEN], int* start,
-                              int lex_tok_count, struct ast_node* tok);
+static bool parse_filter_list(PARSER_PARAMS, struct ast_node* tok);
 static bool validate_root_next(struct ast_node* head);
 
-static bool numeric_to_long(char* str, int str_len, long* dest);
+static bool numeric_to_long(const char* str, size_t str_len, zend_long* dest);
 static bool is_operator(lex_token type);
-static bool make_numeric_node(struct ast_node* tok, char* str, int str_len);
+static bool make_numeric_node(struct ast_node* tok, const char* str, size_t str_len);
 
 const char* AST_STR[] = {"AST_AND",  "AST_BOOL", "AST_DOUBLE",     "AST_EQ",          "AST_EXPR",
                          "AST_GT",   "AST_GTE",  "AST_INDEX_LIST", "AST_INDEX_SLICE", "AST_LITERAL",
@@ -42,8 +46,9 @@ const char* AST_STR[] = {"AST_AND",  "AST_BOOL", "AST_DOUBLE",     "AST_EQ",
                          "AST_NULL", "AST_OR",   "AST_PAREN_LEFT", "AST_PAREN_RIGHT", "AST_RECURSE",
                          "AST_RGXP", "AST_ROOT", "AST_SELECTOR",   "AST_WILD_CARD"};
 
-static struct ast_node* ast_alloc_binary(enum ast_type type, struct ast_node* left, struct ast_node* right) {
-  struct ast_node* node = ast_alloc_node(NULL, type);
+static struct ast_node* ast_alloc_binary(struct query_plan* plan, enum ast_type type, struct ast_node* left,
+                                         struct ast_node* right) {
+  struct ast_node* node = ast_alloc_node(plan, NULL, type);
 
   node->data.d_binary.left = left;
   node->data.d_binary.right = right;
@@ -51,8 +56,27 @@ static struct ast_node* ast_alloc_binary(enum ast_type type, struct ast_node* le
   return node;
 }
 
-static struct ast_node* ast_alloc_node(struct ast_node* prev, enum ast_type type) {
-  struct ast_node* node = emalloc(sizeof(struct ast_node));
+/* Fail the compilation of a plan whose size was underestimated, instead of writing past it */
+static void plan_overflow(struct query_plan* plan) {
+  if (!plan->overflow && !EG(exception)) {
+    zend_throw_exception(spl_ce_RuntimeException, "Unable to compile the expression, it exceeds its plan", 0);
+  }
+
+  plan->overflow = true;
+}
+
+static struct ast_node* ast_alloc_node(struct query_plan* plan, struct ast_node* prev, enum ast_type type) {
+  struct ast_node* node;
+
+  /* every node is created from a lex token, so node_cap shouldn't be exceeded. if it is, the parser carries on */
+  /* with the spare node past the end, and the plan is discarded. */
+  if (UNEXPECTED(plan->node_count == plan->node_cap)) {
+    plan_overflow(plan);
+    node = &plan->nodes[plan->node_cap];
+  } else {
+    node = &plan->nodes[plan->node_count++];
+  }
+
   memset(node, 0, sizeof(struct ast_node));
 
   node->type = type;
@@ -63,28 +87,257 @@ static struct ast_node* ast_alloc_node(struct ast_node* prev, enum ast_type type
   return node;
 }
 
-bool build_parse_tree(lex_token lex_token[PARSE_BUF_LEN], char lex_tok_values[][PARSE_BUF_LEN], int* lex_idx,
-                      int lex_tok_count, struct ast_node* head) {
+/* Allocate a plan for a query of lex_tok_count tokens. Each token yields at most one node, and the pool */
+/* holds at most one index per token and the compiled filter expressions. These bounds are enforced while */
+/* compiling, see plan_overflow(). */
+struct query_plan* plan_alloc(int lex_tok_count) {
+  size_t header_size = ZEND_MM_ALIGNED_SIZE(sizeof(struct query_plan));
+  /* plus a spare node, see ast_alloc_node() */
+  size_t nodes_size = (lex_tok_count + 1) * sizeof(struct ast_node);
+  size_t pool_cap = lex_tok_count * (sizeof(zend_long) + ZEND_MM_ALIGNMENT) + FILTER_POOL_SIZE(lex_tok_count);
+
+  struct query_plan* plan = emalloc(header_size + nodes_size + pool_cap);
+
+  plan->refcount = 1;
+  plan->head = NULL;
+  plan->nodes = (struct ast_node*)((char*)plan + header_size);
+  plan->pool = (char*)plan->nodes + nodes_size;
+  plan->node_count = 0;
+  plan->node_cap = lex_tok_count;
+  plan->pool_len = 0;
+  plan->pool_cap = pool_cap;
+  plan->size = header_size + nodes_size + pool_cap;
+  plan->persistent = false;
+  plan->overflow = false;
+
+  return plan;
+}
+
+/* Copy a plan, e.g. into persistent memory so it can outlive the request */
+struct query_plan* plan_clone(const struct query_plan* plan, bool persistent) {
+  struct query_plan* copy = pemalloc(plan->size, persistent);
+
+  memcpy(copy, plan, plan->size);
+  copy->refcount = 1;
+  copy->persistent = persistent;
+
+  plan_relocate(copy, (char*)copy - (char*)plan);
+
+  for (int i = 0; i < copy->node_count; i++) {
+    zend_string* str = plan_node_string(&copy->nodes[i]);
+
+    if (str != NULL) {
+      zend_string_addref(str);
+    } else if (copy->nodes[i].type == AST_EXPR && copy->nodes[i].data.d_expression.program != NULL) {
+      filter_retain(copy->nodes[i].data.d_expression.program);
+    }
+  }
+
+  return copy;
+}
+
+/* Drop a reference to a plan, freeing it with the last one */
+void plan_release(struct query_plan* plan) {
+  if (--plan->refcount > 0) {
+    return;
+  }
+
+  for (int i = 0; i < plan->node_count; i++) {
+    zend_string* str = plan_node_string(&plan->nodes[i]);
+
+    if (str != NULL) {
+      zend_string_release(str);
+    } else if (plan->nodes[i].type == AST_EXPR && plan->nodes[i].data.d_expression.program != NULL) {
+      filter_release(plan->nodes[i].data.d_expression.program);
+    }
+  }
+
+  pefree(plan, plan->persistent);
+}
+
+/* Allocate memory in the pool of a plan being compiled. Returns NULL, failing the compilation, if it's full. */
+void* plan_pool_alloc(struct query_plan* plan, size_t size) {
+  size_t offset = ZEND_MM_ALIGNED_SIZE(plan->pool_len);
+
+  if (UNEXPECTED(offset > plan->pool_cap || size > plan->pool_cap - offset)) {
+    plan_overflow(plan);
+    return NULL;
+  }
+
+  plan->pool_len = offset + size;
+
+  return plan->pool + offset;
+}
+
+/* Create a string owned by the plan, with its hash computed once here instead of on every lookup. It's */
+/* persistent so that copying the plan into the cache only takes a reference, and it's refcounted, so that */
+/* values built from it, e.g. the keys of a path, can outlive the plan. The node holds the plan's reference. */
+static zend_string* plan_string(struct query_plan* plan, const char* str, size_t len) {
+  zend_string* s;
+
+  /* the spare node of an overflowing plan is reused, and its string would never be released */
+  if (plan->overflow) {
+    return NULL;
+  }
+
+  s = zend_string_init(str, len, 1);
+#ifdef GC_MAKE_PERSISTENT_LOCAL
+  GC_MAKE_PERSISTENT_LOCAL(s);
+#endif
+  zend_string_hash_val(s);
+
+  return s;
+}
+
+/* The string a node holds a reference to, if any */
+static zend_string* plan_node_string(struct ast_node* node) {
+  switch (node->type) {
+    case AST_LITERAL:
+      return node->data.d_literal.value;
+    case AST_SELECTOR:
+      return node->data.d_selector.key;
+    default:
+      return NULL;
+  }
+}
+
+/* Decide once whether the selector is looked up as an integer or a string key */
+static void make_selector_node(struct query_plan* plan, struct ast_node* tok, struct lex_literal literal) {
+  zend_string* key = plan_string(plan, literal.val, literal.len);
+  zend_ulong idx = 0;
+
+  if (key == NULL) {
+    return;
+  }
+
+  tok->data.d_selector.key = key;
+  tok->data.d_selector.is_index = ZEND_HANDLE_NUMERIC_STR(ZSTR_VAL(key), ZSTR_LEN(key), idx);
+  tok->data.d_selector.index = idx;
+}
+
+#define RELOCATE(ptr, delta) ((ptr) = (ptr) == NULL ? NULL : (void*)((char*)(ptr) + (delta)))
+
+/* Shift every pointer of a memcpy()'d plan by the distance between the copy and the original */
+static void plan_relocate(struct query_plan* plan, ptrdiff_t delta) {
+  RELOCATE(plan->head, delta);
+  RELOCATE(plan->nodes, delta);
+  RELOCATE(plan->pool, delta);
+
+  for (int i = 0; i < plan->node_count; i++) {
+    struct ast_node* node = &plan->nodes[i];
+
+    RELOCATE(node->next, delta);
+
+    switch (node->type) {
+      case AST_AND:
+      case AST_EQ:
+      case AST_GT:
+      case AST_GTE:
+      case AST_LT:
+      case AST_LTE:
+      case AST_NE:
+      case AST_OR:
+      case AST_RGXP:
+        RELOCATE(node->data.d_binary.left, delta);
+        RELOCATE(node->data.d_binary.right, delta);
+        break;
+      case AST_EXPR:
+        RELOCATE(node->data.d_expression.head, delta);
+        if (node->data.d_expression.program != NULL) {
+          RELOCATE(node->data.d_expression.program, delta);
+          filter_relocate(node->data.d_expression.program, delta);
+        }
+        break;
+      case AST_NEGATION:
+        RELOCATE(node->data.d_unary.right, delta);
+        break;
+      case AST_INDEX_LIST:
+      case AST_INDEX_SLICE:
+        RELOCATE(node->data.d_list.indexes, delta);
+        break;
+      default:
+        /* noop */
+        break;
+    }
+  }
+}
+
+#undef RELOCATE
+
+/* Whether two paths, which may belong to different plans, have equal segments */
+bool ast_chain_equal(const struct ast_node* a, const struct ast_node* b) {
+  for (; a != NULL && b != NULL; a = a->next, b = b->next) {
+    if (!ast_node_equal(a, b)) {
+      return false;
+    }
+  }
+
+  return a == NULL && b == NULL;
+}
+
+/* Whether two nodes, which may belong to different plans, select the same values. The nodes following them are */
+/* not compared, but the operands of filter expressions are. */
+bool ast_node_equal(const struct ast_node* a, const struct ast_node* b) {
+  if (a->type != b->type) {
+    return false;
+  }
+
+  switch (a->type) {
+    case AST_AND:
+    case AST_EQ:
+    case AST_GT:
+    case AST_GTE:
+    case AST_LT:
+    case AST_LTE:
+    case AST_NE:
+    case AST_OR:
+    case AST_RGXP:
+      return ast_chain_equal(a->data.d_binary.left, b->data.d_binary.left) &&
+             ast_chain_equal(a->data.d_binary.right, b->data.d_binary.right);
+    case AST_EXPR:
+      return ast_chain_equal(a->data.d_expression.head, b->data.d_expression.head);
+    case AST_NEGATION:
+      return ast_chain_equal(a->data.d_unary.right, b->data.d_unary.right);
+    case AST_INDEX_LIST:
+    case AST_INDEX_SLICE:
+      return a->data.d_list.count == b->data.d_list.count &&
+             memcmp(a->data.d_list.indexes, b->data.d_list.indexes, sizeof(zend_long) * a->data.d_list.count) == 0;
+    case AST_LITERAL:
+      return zend_string_equals(a->data.d_literal.value, b->data.d_literal.value);
+    case AST_SELECTOR:
+      return zend_string_equals(a->data.d_selector.key, b->data.d_selector.key);
+    case AST_BOOL:
+      return a->data.d_literal.value_bool == b->data.d_literal.value_bool;
+    case AST_DOUBLE:
+      return a->data.d_double.value == b->data.d_double.value;
+    case AST_LONG:
+      return a->data.d_long.value == b->data.d_long.value;
+    default:
+      return true;
+  }
+}
+
+bool build_parse_tree(PARSER_PARAMS, struct ast_node* head) {
   struct ast_node* cur = head;
 
   for (; *lex_idx < lex_tok_count; (*lex_idx)++) {
     switch (CUR_TOKEN()) {
       case LEX_WILD_CARD:
-        cur = ast_alloc_node(cur, AST_WILD_CARD);
+        cur = ast_alloc_node(plan, cur, AST_WILD_CARD);
         break;
       case LEX_ROOT:
-        cur = ast_alloc_node(cur, AST_ROOT);
+        cur = ast_alloc_node(plan, cur, AST_ROOT);
         break;
       case LEX_DEEP_SCAN:
-        cur = ast_alloc_node(cur, AST_RECURSE);
+        cur = ast_alloc_node(plan, cur, AST_RECURSE);
         break;
       case LEX_CUR_NODE:
         // noop
         break;
       case LEX_NODE:
         // fall-through
-        cur = ast_alloc_node(cur, AST_SELECTOR);
-        strcpy(cur->data.d_selector.value, CUR_TOKEN_LITERAL());
+        cur = ast_alloc_node(plan, cur, AST_SELECTOR);
+        make_selector_node(plan, cur, CUR_TOKEN_LITERAL());
         break;
       case LEX_FILTER_START:
 
@@ -103,13 +356,13 @@ bool build_parse_tree(lex_token lex_token[PARSE_BUF_LEN], char lex_tok_values[][
           case LEX_SLICE:
             /* fall-through */
           case LEX_CHILD_SEP:
-            cur = ast_alloc_node(cur, AST_INDEX_LIST);
-            if (!parse_filter_list(lex_token, lex_tok_values, lex_idx, lex_tok_count, cur)) {
+            cur = ast_alloc_node(plan, cur, AST_INDEX_LIST);
+            if (!parse_filter_list(PARSER_ARGS, cur)) {
               return false;
             }
             break;
           case LEX_WILD_CARD:
-            cur = ast_alloc_node(cur, AST_WILD_CARD);
+            cur = ast_alloc_node(plan, cur, AST_WILD_CARD);
             break;
           case LEX_EXPR_END:
             zend_throw_exception_ex(spl_ce_RuntimeException, 0, "Filter must not be empty");
@@ -154,9 +407,18 @@ bool build_parse_tree(lex_token lex_token[PARSE_BUF_LEN], char lex_tok_values[][
   return true;
 }
 
-static bool parse_filter_list(lex_token lex_token[PARSE_BUF_LEN], char lex_tok_values[][PARSE_BUF_LEN], int* lex_idx,
-                              int lex_tok_count, struct ast_node* tok) {
+static bool parse_filter_list(PARSER_PARAMS, struct ast_node* tok) {
   int slice_count = 0;
+  int max_count = 0;
+
+  /* each token of the list adds at most one index */
+  while (*lex_idx + max_count < lex_tok_count && lex_token[*lex_idx + max_count] != LEX_EXPR_END) {
+    max_count++;
+  }
+
+  if ((tok->data.d_list.indexes = plan_pool_alloc(plan, max_count * sizeof(zend_long))) == NULL) {
+    return false;
+  }
 
   /* assume filter type is an index list by default. this resolves type */
   /* ambiguity of a filter containing no separators. */
@@ -191,16 +453,16 @@ static bool parse_filter_list(lex_token lex_token[PARSE_BUF_LEN], char lex_tok_v
       // [a::] => [a:0:]
       if (slice_count > tok->data.d_list.count) {
         if (slice_count == 1) {
-          tok->data.d_list.indexes[tok->data.d_list.count] = INT_MAX;
+          tok->data.d_list.indexes[tok->data.d_list.count] = ZEND_LONG_MAX;
         } else if (slice_count == 2) {
-          tok->data.d_list.indexes[tok->data.d_list.count] = INT_MAX;
+          tok->data.d_list.indexes[tok->data.d_list.count] = ZEND_LONG_MAX;
         }
         tok->data.d_list.count++;
       }
     } else if (CUR_TOKEN() == LEX_LITERAL_NUMERIC) {
-      long idx = 0;
+      zend_long idx = 0;
 
-      if (!numeric_to_long(CUR_TOKEN_LITERAL(), strlen(CUR_TOKEN_LITERAL()), &idx)) {
+      if (!numeric_to_long(CUR_TOKEN_LITERAL().val, CUR_TOKEN_LITERAL().len, &idx)) {
         zend_throw_exception(spl_ce_RuntimeException, "Unable to parse filter index value.", 0);
         return false;
       }
@@ -223,8 +485,8 @@ static struct ast_node* parse_expression(PARSER_PARAMS) {
     return NULL;
   }
 
-  struct ast_node* expr = ast_alloc_node(NULL, AST_EXPR);
-  expr->data.d_expression.head = parse_or(lex_token, lex_tok_values, lex_idx, lex_tok_count);
+  struct ast_node* expr = ast_alloc_node(plan, NULL, AST_EXPR);
+  expr->data.d_expression.head = parse_or(PARSER_ARGS);
 
   return expr;
 }
@@ -237,7 +499,7 @@ static struct ast_node* parse_or(PARSER_PARAMS) {
 
     struct ast_node* right = parse_and(PARSER_ARGS);
 
-    expr = ast_alloc_binary(AST_OR, expr, right);
+    expr = ast_alloc_binary(plan, AST_OR, expr, right);
   }
 
   return expr;
@@ -251,7 +513,7 @@ static struct ast_node* parse_and(PARSER_PARAMS) {
 
     struct ast_node* right = parse_equality(PARSER_ARGS);
 
-    expr = ast_alloc_binary(AST_AND, expr, right);
+    expr = ast_alloc_binary(plan, AST_AND, expr, right);
   }
 
   return expr;
@@ -275,7 +537,7 @@ static struct ast_node* parse_equality(PARSER_PARAMS) {
 
     struct ast_node* right = parse_comparison(PARSER_ARGS);
 
-    expr = ast_alloc_binary(type, expr, right);
+    expr = ast_alloc_binary(plan, type, expr, right);
   }
 
   return expr;
@@ -305,7 +567,7 @@ static struct ast_node* parse_comparison(PARSER_PARAMS) {
 
     struct ast_node* right = parse_unary(PARSER_ARGS);
 
-    expr = ast_alloc_binary(type, expr, right);
+    expr = ast_alloc_binary(plan, type, expr, right);
   }
 
   return expr;
@@ -314,7 +576,7 @@ static struct ast_node* parse_comparison(PARSER_PARAMS) {
 static struct ast_node* parse_unary(PARSER_PARAMS) {
   if (CUR_TOKEN() == LEX_NEGATION) {
     CONSUME_TOKEN();
-    struct ast_node* expr = ast_alloc_node(NULL, AST_NEGATION);
+    struct ast_node* expr = ast_alloc_node(plan, NULL, AST_NEGATION);
     expr->data.d_unary.right = parse_unary(PARSER_ARGS);
     return expr;
   }
@@ -328,19 +590,15 @@ static struct ast_node* parse_primary(PARSER_PARAMS) {
   }
 
   if (CUR_TOKEN() == LEX_LITERAL) {
-    struct ast_node* ret = ast_alloc_node(NULL, AST_LITERAL);
-
-    if (jp_str_cpy(ret->data.d_literal.value, PARSE_BUF_LEN, CUR_TOKEN_LITERAL(), strlen(CUR_TOKEN_LITERAL())) > 0) {
-      zend_throw_exception_ex(spl_ce_RuntimeException, 0, "Buffer size exceeded");
-      return NULL;
-    }
+    struct ast_node* ret = ast_alloc_node(plan, NULL, AST_LITERAL);
+    ret->data.d_literal.value = plan_string(plan, CUR_TOKEN_LITERAL().val, CUR_TOKEN_LITERAL().len);
     CONSUME_TOKEN();
     return ret;
   }
 
   if (CUR_TOKEN() == LEX_LITERAL_NUMERIC) {
-    struct ast_node* ret = ast_alloc_node(NULL, AST_DOUBLE);
-    if (!make_numeric_node(ret, CUR_TOKEN_LITERAL(), strlen(CUR_TOKEN_LITERAL()))) {
+    struct ast_node* ret = ast_alloc_node(plan, NULL, AST_DOUBLE);
+    if (!make_numeric_node(ret, CUR_TOKEN_LITERAL().val, CUR_TOKEN_LITERAL().len)) {
       zend_throw_exception_ex(spl_ce_RuntimeException, 0, "Unable to parse numeric.");
       return NULL;
     }
@@ -349,11 +607,11 @@ static struct ast_node* parse_primary(PARSER_PARAMS) {
   }
 
   if (CUR_TOKEN() == LEX_LITERAL_BOOL) {
-    struct ast_node* ret = ast_alloc_node(NULL, AST_BOOL);
+    struct ast_node* ret = ast_alloc_node(plan, NULL, AST_BOOL);
 
-    if (strncasecmp("true", CUR_TOKEN_LITERAL(), 4) == 0) {
+    if (CUR_TOKEN_LITERAL().len >= 4 && strncasecmp("true", CUR_TOKEN_LITERAL().val, 4) == 0) {
       ret->data.d_literal.value_bool = true;
-    } else if (strncasecmp("false", CUR_TOKEN_LITERAL(), 5) == 0) {
+    } else if (CUR_TOKEN_LITERAL().len >= 5 && strncasecmp("false", CUR_TOKEN_LITERAL().val, 5) == 0) {
       ret->data.d_literal.value_bool = false;
     } else {
       zend_throw_exception_ex(spl_ce_RuntimeException, 0, "Expected `true` or `false` for boolean token.");
@@ -364,7 +622,7 @@ static struct ast_node* parse_primary(PARSER_PARAMS) {
   }
 
   if (CUR_TOKEN() == LEX_LITERAL_NULL) {
-    struct ast_node* ret = ast_alloc_node(NULL, AST_NULL);
+    struct ast_node* ret = ast_alloc_node(plan, NULL, AST_NULL);
     CONSUME_TOKEN();
     return ret;
   }
@@ -376,16 +634,15 @@ static struct ast_node* parse_primary(PARSER_PARAMS) {
     /* handle @.node */
     while (CUR_TOKEN() == LEX_NODE) {
       if (ret == NULL) {
-        ret = ast_alloc_node(NULL, AST_SELECTOR);
+        ret = ast_alloc_node(plan, NULL, AST_SELECTOR);
         tail = ret;
       } else {
-        tail = ast_alloc_node(tail, AST_SELECTOR);
+        tail = ast_alloc_node(plan, tail, AST_SELECTOR);
       }
-      strcpy(tail->data.d_selector.value, CUR_TOKEN_LITERAL());
+      make_selector_node(plan, tail, CUR_TOKEN_LITERAL());
       CONSUME_TOKEN();
 
       if (CUR_TOKEN() == LEX_WILD_CARD) {
-        free_ast_nodes(ret);
         zend_throw_exception(spl_ce_RuntimeException, "Multiplying node values is not supported.", 0);
         return NULL;
       }
@@ -396,7 +653,6 @@ static struct ast_node* parse_primary(PARSER_PARAMS) {
       tail->next = parse_expression(PARSER_ARGS);
 
       if (tail->next == NULL) {
-        free_ast_nodes(ret);
         return NULL;
       }
 
@@ -425,7 +681,6 @@ static struct ast_node* parse_primary(PARSER_PARAMS) {
       CONSUME_TOKEN();
       return expr;
     } else {
-      free_ast_nodes(expr);
       zend_throw_exception_ex(spl_ce_RuntimeException, 0, "Missing closing paren )");
       return NULL;
     }
@@ -452,7 +707,7 @@ static struct ast_node* parse_primary(PARSER_PARAMS) {
 
     /* Run build_parse_tree on a subset of the lex stream, until the */
     /* boundary of the sub-JSONPath */
-    if (!build_parse_tree(lex_token, lex_tok_values, &start, stop, ptr)) {
+    if (!build_parse_tree(plan, lex_token, lex_tok_values, &start, stop, ptr)) {
       return NULL;
     }
 
@@ -545,7 +800,7 @@ bool validate_parse_tree(struct ast_node* head) {
         }
         break;
       case AST_RECURSE:
-        if (cur->next == NULL || (cur->next->type == AST_SELECTOR && cur->next->data.d_selector.value[0] == '\0')) {
+        if (cur->next == NULL || (cur->next->type == AST_SELECTOR && ZSTR_LEN(cur->next->data.d_selector.key) == 0)) {
           zend_throw_exception(
               spl_ce_RuntimeException,
               "Recursive descent operator (..) must be followed by a child selector, filter or wildcard.", 0);
@@ -561,7 +816,7 @@ bool validate_parse_tree(struct ast_node* head) {
   return true;
 }
 
-static bool make_numeric_node(struct ast_node* tok, char* str, int str_len) {
+static bool make_numeric_node(struct ast_node* tok, const char* str, size_t str_len) {
   zend_long lval;
   double dval;
   int oflow_info;
@@ -592,7 +847,7 @@ static bool make_numeric_node(struct ast_node* tok, char* str, int str_len) {
   return false;
 }
 
-static bool numeric_to_long(char* str, int str_len, long* dest) {
+static bool numeric_to_long(const char* str, size_t str_len, zend_long* dest) {
   zend_long lval;
   double dval;
   int oflow_info;
@@ -649,40 +904,6 @@ bool sanity_check(lex_token lex_token[], int lex_tok_count) {
   return true;
 }
 
-void free_ast_nodes(struct ast_node* head) {
-  if (head == NULL) {
-    return;
-  }
-
-  switch (head->type) {
-    case AST_AND:
-    case AST_EQ:
-    case AST_GT:
-    case AST_GTE:
-    case AST_LT:
-    case AST_LTE:
-    case AST_NE:
-    case AST_OR:
-    case AST_RGXP:
-      free_ast_nodes(head->data.d_binary.left);
-      free_ast_nodes(head->data.d_binary.right);
-      break;
-    case AST_EXPR:
-      free_ast_nodes(head->data.d_expression.head);
-      break;
-    case AST_NEGATION:
-      free_ast_nodes(head->data.d_unary.right);
-      break;
-    default:
-      /* noop */
-      break;
-  }
-
-  free_ast_nodes(head->next);
-
-  efree((void*)head);
-}
-
 #ifdef JSONPATH_DEBUG
 void print_ast(struct ast_node* head, const char* m, int level) {
   if (level == 0) {
@@ -719,7 +940,7 @@ void print_ast(struct ast_node* head, const char* m, int level) {
         print_ast(head->data.d_expression.head, m, level + 1);
         break;
       case AST_LONG:
-        printf(" [val=%ld]\n", head->data.d_long.value);
+        printf(" [val=" ZEND_LONG_FMT "]\n", head->data.d_long.value);
         break;
       case AST_DOUBLE:
         printf(" [val=%f]\n", head->data.d_double.value);
@@ -729,7 +950,7 @@ void print_ast(struct ast_node* head, const char* m, int level) {
         break;
       case AST_SELECTOR:
         while (head->type == AST_SELECTOR) {
-          printf(" [val=%s]", head->data.d_selector.value);
+          printf(" [val=%s]", ZSTR_VAL(head->data.d_selector.key));
           if (head->next != NULL && head->next->type == AST_SELECTOR) {
             head = head->next;
           } else {
@@ -739,11 +960,11 @@ void print_ast(struct ast_node* head, const char* m, int level) {
         printf("\n");
         break;
       case AST_LITERAL:
-        printf(" [val=%s]\n", head->data.d_literal.value);
+        printf(" [val=%s]\n", ZSTR_VAL(head->data.d_literal.value));
         break;
       case AST_INDEX_SLICE:
-        printf(" [start=%d end=%d step=%d]\n", head->data.d_list.indexes[0], head->data.d_list.indexes[1],
-               head->data.d_list.indexes[2]);
+        printf(" [start=" ZEND_LONG_FMT " end=" ZEND_LONG_FMT " step=" ZEND_LONG_FMT "]\n",
+               head->data.d_list.indexes[0], head->data.d_list.indexes[1], head->data.d_list.indexes[2]);
         break;
       case AST_NEGATION:
         printf("\n");
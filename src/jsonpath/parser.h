@@ -6,8 +6,7 @@
 #include <string.h>
 
 #include "lexer.h"
-
-#define PARSE_BUF_LEN 50
+#include "php.h"
 
 typedef enum {
   TYPE_OPERAND,
@@ -44,6 +43,8 @@ enum ast_type {
 
 extern const char* AST_STR[];
 
+struct filter_program;
+
 union ast_node_data {
   struct {
     struct ast_node* left;
@@ -51,26 +52,26 @@ union ast_node_data {
   } d_binary;
   struct {
     struct ast_node* head;
+    struct filter_program* program; /* compiled by filter_compile_plan(), stored in the plan's pool */
   } d_expression;
   struct {
     int count;
-    int indexes[10]; /* todo check for max */
+    zend_long* indexes; /* stored in the plan's pool */
   } d_list;
   struct {
-    char value[PARSE_BUF_LEN];
+    zend_string* value; /* owned by the plan, see plan_string() */
     bool value_bool;
   } d_literal;
   struct {
-    char value[PARSE_BUF_LEN];
+    zend_string* key; /* owned by the plan, with its hash computed */
+    zend_ulong index; /* the key as an integer, if the key is numeric */
+    bool is_index;
   } d_selector;
-  struct {
-    struct ast_node* head;
-  } d_value;
   struct {
     double value;
   } d_double;
   struct {
-    long value;
+    zend_long value;
   } d_long;
   struct {
     struct ast_node* right;
@@ -83,13 +84,41 @@ struct ast_node {
   union ast_node_data data;
 };
 
-bool build_parse_tree(lex_token lex_tok[PARSE_BUF_LEN], char lex_tok_values[][PARSE_BUF_LEN], int* lex_idx,
+/* A compiled query: every AST node, followed by a pool holding the index lists and filter programs the nodes */
+/* point to, all in a single allocation. Nodes only point inside the plan, or to refcounted strings, so it can */
+/* be copied with memcpy() and a reference per string. A plan is refcounted: the query cache holds a reference, and */
+/* so does every call and object using it, so evicting it from the cache never frees it while it's in use. */
+struct query_plan {
+  uint32_t refcount;
+  struct ast_node* head;
+  struct ast_node* nodes;
+  char* pool;
+  int node_count;
+  int node_cap;
+  size_t pool_len;
+  size_t pool_cap;
+  size_t size;
+  bool persistent;
+  bool overflow; /* the nodes or the pool ran out of room while compiling, the plan can't be used */
+};
+
+struct query_plan* plan_alloc(int lex_tok_count);
+struct query_plan* plan_clone(const struct query_plan* plan, bool persistent);
+void plan_release(struct query_plan* plan);
+void* plan_pool_alloc(struct query_plan* plan, size_t size);
+bool build_parse_tree(struct query_plan* plan, lex_token lex_tok[], struct lex_literal lex_tok_values[], int* lex_idx,
                       int lex_tok_count, struct ast_node* head);
 bool sanity_check(lex_token lex_tok[], int lex_tok_count);
-void free_ast_nodes(struct ast_node* head);
 bool is_binary(enum ast_type type);
 bool is_unary(enum ast_type type);
 bool validate_parse_tree(struct ast_node* head);
+bool ast_node_equal(const struct ast_node* a, const struct ast_node* b);
+bool ast_chain_equal(const struct ast_node* a, const struct ast_node* b);
+
+static inline struct query_plan* plan_retain(struct query_plan* plan) {
+  plan->refcount++;
+  return plan;
+}
 
 #ifdef JSONPATH_DEBUG
 void print_ast(struct ast_node* head, const char* m, int level);
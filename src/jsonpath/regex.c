@@ -0,0 +1,413 @@
+#include "regex.h"
+
+#include <ctype.h>
+
+#include "php_jsonpath.h"
+
+/* Patterns are compiled and matched by PHP, through php_pcre_match_impl(), so they accept exactly what preg_match() */
+/* does and follow the pcre.* settings, e.g. pcre.jit and the backtracking limits. Only PHP's exported API is used, */
+/* never libpcre2 itself, which isn't exported to extensions on every platform. Compiled code is owned by PHP's */
+/* regex cache, whose entries may be evicted or freed at the end of the request, while plans may outlive the */
+/* request: a regex looks its entry up on its first match of a request, and pins it until the request ends. */
+/* Most subjects don't get that far, they lack the literal substring the pattern needs. */
+
+/* Find the body of a pattern between its delimiters, the way PHP does */
+static bool pattern_body(zend_string* pattern, const char** body, const char** body_end) {
+  const char* p = ZSTR_VAL(pattern);
+  const char* end = p + ZSTR_LEN(pattern);
+  const char* brackets = "([{< )]}> )]}>";
+  const char* bracket;
+
+  while (p < end && isspace((unsigned char)*p)) {
+    p++;
+  }
+
+  if (p == end || isalnum((unsigned char)*p) || *p == '\\' || *p == '\0') {
+    return false;
+  }
+
+  char start_delimiter = *p++;
+  char end_delimiter = start_delimiter;
+  int depth = 1;
+
+  if ((bracket = strchr(brackets, start_delimiter)) != NULL) {
+    end_delimiter = bracket[5];
+  }
+
+  *body = p;
+
+  for (; p < end; p++) {
+    if (*p == '\\' && p + 1 < end) {
+      p++;
+    } else if (*p == end_delimiter && --depth == 0) {
+      *body_end = p;
+      return true;
+    } else if (*p == start_delimiter && start_delimiter != end_delimiter) {
+      depth++;
+    }
+  }
+
+  return false;
+}
+
+/* Skip an escape sequence, p points past its backslash. An escaped letter or digit can be followed by more of the */
+/* escape, e.g. \x41, \x{41}, \101, \cA, \p{Lu}, \g{-1} or \k<name>, which mustn't be mistaken for literals. */
+static const char* skip_escape(const char* p, const char* end) {
+  char c = *p++;
+  char close = '\0';
+
+  switch (c) {
+    case 'c':
+      /* a control character, \cX */
+      return p < end ? p + 1 : p;
+    case 'x':
+      if (p < end && *p == '{') {
+        close = '}';
+        break;
+      }
+      for (int i = 0; i < 2 && p < end && isxdigit((unsigned char)*p); i++) {
+        p++;
+      }
+      return p;
+    case 'o':
+    case 'N':
+      if (p < end && *p == '{') {
+        close = '}';
+      }
+      break;
+    case 'p':
+    case 'P':
+      if (p < end && *p == '{') {
+        close = '}';
+        break;
+      }
+      return p < end ? p + 1 : p;
+    case 'g':
+    case 'k':
+      if (p < end && (*p == '{' || *p == '<' || *p == '\'')) {
+        close = *p == '{' ? '}' : *p == '<' ? '>' : '\'';
+        break;
+      }
+      if (c == 'g' && p < end && (*p == '+' || *p == '-')) {
+        p++;
+      }
+      while (p < end && isdigit((unsigned char)*p)) {
+        p++;
+      }
+      return p;
+    default:
+      /* back-references and octal code points take every digit that follows */
+      if (isdigit((unsigned char)c)) {
+        while (p < end && isdigit((unsigned char)*p)) {
+          p++;
+        }
+      }
+      return p;
+  }
+
+  if (close != '\0') {
+    p++;
+    while (p < end && *p != close) {
+      p++;
+    }
+    if (p < end) {
+      p++;
+    }
+  }
+
+  return p;
+}
+
+/* Skip a character class, p points past its opening bracket. Returns NULL if it isn't closed. */
+static const char* skip_class(const char* p, const char* end) {
+  if (p < end && *p == '^') {
+    p++;
+  }
+
+  if (p < end && *p == ']') {
+    /* a leading ] is a member of the class */
+    p++;
+  }
+
+  while (p < end) {
+    char c = *p++;
+
+    if (c == '\\' && p < end) {
+      p = skip_escape(p, end);
+    } else if (c == ']') {
+      return p;
+    }
+  }
+
+  return NULL;
+}
+
+/* Skip a group, p points past its opening paren. Returns NULL if it isn't closed. */
+static const char* skip_group(const char* p, const char* end) {
+  int depth = 1;
+
+  while (p < end) {
+    char c = *p++;
+
+    if (c == '\\' && p < end) {
+      p = skip_escape(p, end);
+    } else if (c == '[') {
+      if ((p = skip_class(p, end)) == NULL) {
+        return NULL;
+      }
+    } else if (c == '(') {
+      depth++;
+    } else if (c == ')' && --depth == 0) {
+      return p;
+    }
+  }
+
+  return NULL;
+}
+
+struct literal_scan {
+  char* run; /* the literal characters read since the last item that isn't one */
+  size_t run_len;
+  char* best;
+  size_t best_len;
+};
+
+static void end_run(struct literal_scan* scan) {
+  if (scan->run_len > scan->best_len) {
+    memcpy(scan->best, scan->run, scan->run_len);
+    scan->best_len = scan->run_len;
+  }
+
+  scan->run_len = 0;
+}
+
+/* Find the longest sequence of literal characters at the top level of a pattern body, which every match must */
+/* contain. Anything the scan doesn't understand (alternation, inline options, \Q...\E) means there's no literal. */
+/* Sets *exact if the body is nothing but that sequence. In UTF mode a quantifier applies to a whole character. */
+static zend_string* required_literal(const char* p, const char* end, bool utf, bool* exact) {
+  struct literal_scan scan = {emalloc(end - p + 1), 0, emalloc(end - p + 1), 0};
+  zend_string* literal = NULL;
+  bool only_literals = true;
+
+  while (p < end) {
+    char c = *p++;
+
+    switch (c) {
+      case '\\':
+        if (p == end || *p == 'Q') {
+          goto done;
+        }
+        if (isalnum((unsigned char)*p)) {
+          /* classes, assertions, back-references, escaped code points */
+          p = skip_escape(p, end);
+          end_run(&scan);
+          only_literals = false;
+          continue;
+        }
+        c = *p++;
+        break;
+      case '|':
+      case ')':
+        goto done;
+      case '(':
+        if ((p < end && *p == '?') || (p = skip_group(p, end)) == NULL) {
+          goto done;
+        }
+        end_run(&scan);
+        only_literals = false;
+        continue;
+      case '[':
+        if ((p = skip_class(p, end)) == NULL) {
+          goto done;
+        }
+        end_run(&scan);
+        only_literals = false;
+        continue;
+      case '{':
+        while (p < end && *p++ != '}') {
+        }
+        /* fallthrough */
+      case '?':
+      case '*':
+        /* the preceding item is optional */
+        if (scan.run_len > 0) {
+          do {
+            scan.run_len--;
+          } while (utf && scan.run_len > 0 && ((unsigned char)scan.run[scan.run_len] & 0xC0) == 0x80);
+        }
+        end_run(&scan);
+        only_literals = false;
+        continue;
+      case '+':
+      case '.':
+      case '^':
+      case '$':
+        end_run(&scan);
+        only_literals = false;
+        continue;
+      default:
+        break;
+    }
+
+    scan.run[scan.run_len++] = c;
+  }
+
+  end_run(&scan);
+
+  if (scan.best_len > 0) {
+    literal = zend_string_init(scan.best, scan.best_len, 1);
+    *exact = only_literals;
+  }
+
+done:
+  efree(scan.run);
+  efree(scan.best);
+
+  return literal;
+}
+
+/* Check the modifiers following a pattern's end delimiter. Returns false if one of them can change which subjects */
+/* contain the literal of the body, e.g. i or x. Sets *exact to false if one of them can reject such subjects, */
+/* and *utf if the body is read as UTF-8. */
+static bool literal_modifiers(const char* p, const char* end, bool* utf, bool* exact) {
+  for (; p < end; p++) {
+    switch (*p) {
+      case 'u':
+        *utf = true;
+        /* fallthrough */
+      case 'A':
+        /* anchored and UTF patterns can still reject subjects containing the literal */
+        *exact = false;
+        break;
+      case 'm':
+      case 's':
+      case 'D':
+      case 'S':
+      case 'U':
+      case 'X':
+      case 'J':
+      case 'n':
+      case ' ':
+      case '\n':
+      case '\r':
+        break;
+      default:
+        return false;
+    }
+  }
+
+  return true;
+}
+
+/* Resolve a pattern, returning NULL with a warning raised if it isn't valid */
+struct regex* regex_compile(zend_string* pattern) {
+  const char *body, *body_end;
+  bool utf = false, exact = true;
+
+  if (pcre_get_compiled_regex_cache(pattern) == NULL) {
+    return NULL;
+  }
+
+  struct regex* regex = pecalloc(1, sizeof(struct regex), 1);
+
+  regex->refcount = 1;
+  regex->pattern = zend_string_init(ZSTR_VAL(pattern), ZSTR_LEN(pattern), 1);
+
+  /* a leading (*VERB) sets options of its own, e.g. (*UTF) */
+  if (pattern_body(pattern, &body, &body_end) &&
+      literal_modifiers(body_end + 1, ZSTR_VAL(pattern) + ZSTR_LEN(pattern), &utf, &exact) &&
+      !(body_end - body >= 2 && body[0] == '(' && body[1] == '*')) {
+    regex->literal = required_literal(body, body_end, utf, &regex->exact);
+    regex->exact = regex->exact && exact;
+  }
+
+  return regex;
+}
+
+/* Find the compiled pattern in PHP's regex cache, once per request */
+static pcre_cache_entry* regex_pin(struct regex* regex) {
+  pcre_cache_entry* pce;
+
+  if (regex->pce != NULL) {
+    return regex->pce;
+  }
+
+  if ((pce = pcre_get_compiled_regex_cache(regex->pattern)) == NULL) {
+    return NULL;
+  }
+
+  /* a pinned entry isn't evicted by the patterns compiled after it */
+  php_pcre_pce_incref(pce);
+  regex->pce = pce;
+
+  regex->next_pinned = JSONPATH_G(pinned_regexes);
+  regex->prev_pinned = &JSONPATH_G(pinned_regexes);
+  if (regex->next_pinned != NULL) {
+    regex->next_pinned->prev_pinned = &regex->next_pinned;
+  }
+  JSONPATH_G(pinned_regexes) = regex;
+
+  return pce;
+}
+
+static void regex_unpin(struct regex* regex) {
+  php_pcre_pce_decref(regex->pce);
+  regex->pce = NULL;
+
+  *regex->prev_pinned = regex->next_pinned;
+  if (regex->next_pinned != NULL) {
+    regex->next_pinned->prev_pinned = regex->prev_pinned;
+  }
+}
+
+/* Release the entries pinned by the request, before PHP's regex cache is cleaned, see jsonpath_deps */
+void regex_unpin_all(void) {
+  while (JSONPATH_G(pinned_regexes) != NULL) {
+    regex_unpin(JSONPATH_G(pinned_regexes));
+  }
+}
+
+bool regex_match(struct regex* regex, zend_string* subject) {
+  pcre_cache_entry* pce;
+  zval retval;
+
+  if (regex->literal != NULL) {
+    const char* end = ZSTR_VAL(subject) + ZSTR_LEN(subject);
+
+    if (ZSTR_LEN(subject) < ZSTR_LEN(regex->literal) ||
+        zend_memnstr(ZSTR_VAL(subject), ZSTR_VAL(regex->literal), ZSTR_LEN(regex->literal), end) == NULL) {
+      return false;
+    }
+
+    if (regex->exact) {
+      return true;
+    }
+  }
+
+  if ((pce = regex_pin(regex)) == NULL) {
+    return false;
+  }
+
+  /* errors, e.g. an invalid UTF-8 subject or the backtracking limit, fail the match like they fail preg_match() */
+  ZVAL_NULL(&retval);
+  php_pcre_match_impl(pce, subject, &retval, NULL, 0, 0, 0, 0);
+
+  return Z_TYPE(retval) == IS_LONG && Z_LVAL(retval) > 0;
+}
+
+void regex_release(struct regex* regex) {
+  if (--regex->refcount > 0) {
+    return;
+  }
+
+  if (regex->pce != NULL) {
+    regex_unpin(regex);
+  }
+
+  if (regex->literal != NULL) {
+    zend_string_release(regex->literal);
+  }
+
+  zend_string_release(regex->pattern);
+  pefree(regex, 1);
+}
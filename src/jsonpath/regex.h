@@ -0,0 +1,29 @@
+#ifndef REGEX_H
+#define REGEX_H 1
+
+#include <ext/pcre/php_pcre.h>
+#include <stdbool.h>
+
+#include "php.h"
+
+/* A =~ pattern resolved when the query is compiled: an invalid pattern warns once, and the substring every match */
+/* contains is found once. The plans sharing a regex are copies of one compiled query, which never leave the thread */
+/* that compiled it, so the refcount and the list of pinned regexes aren't shared between threads. */
+struct regex {
+  uint32_t refcount;
+  zend_string* pattern;  /* the pattern as written, e.g. /^a/i */
+  zend_string* literal;  /* a substring of every matching subject, if the pattern has one */
+  bool exact;            /* the pattern matches every subject containing literal, and nothing else */
+  pcre_cache_entry* pce; /* PHP's compiled pattern, pinned until the end of the request, see regex_pin() */
+  struct regex* next_pinned;
+  struct regex** prev_pinned;
+};
+
+struct regex* regex_compile(zend_string* pattern);
+bool regex_match(struct regex* regex, zend_string* subject);
+void regex_release(struct regex* regex);
+void regex_unpin_all(void);
+
+static inline void regex_retain(struct regex* regex) { regex->refcount++; }
+
+#endif /* REGEX_H */
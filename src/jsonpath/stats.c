@@ -0,0 +1,116 @@
+#include "stats.h"
+
+#include "ext/standard/info.h"
+
+#if PHP_VERSION_ID >= 80300
+#include "zend_hrtime.h"
+#elif PHP_VERSION_ID >= 80000
+#include "ext/standard/hrtime.h"
+#elif !defined(PHP_WIN32)
+#include <time.h>
+#endif
+
+static const struct {
+  const char* name;
+  size_t offset;
+} stats_fields[] = {
+    {"queries_compiled", offsetof(struct jsonpath_stats, queries_compiled)},
+    {"queries_executed", offsetof(struct jsonpath_stats, queries_executed)},
+    {"nodes_visited", offsetof(struct jsonpath_stats, nodes_visited)},
+    {"hash_lookups", offsetof(struct jsonpath_stats, hash_lookups)},
+    {"results_copied", offsetof(struct jsonpath_stats, results_copied)},
+    {"bytes_copied", offsetof(struct jsonpath_stats, bytes_copied)},
+    {"regex_matches", offsetof(struct jsonpath_stats, regex_matches)},
+    {"lex_ns", offsetof(struct jsonpath_stats, lex_ns)},
+    {"parse_ns", offsetof(struct jsonpath_stats, parse_ns)},
+    {"eval_ns", offsetof(struct jsonpath_stats, eval_ns)},
+};
+
+#define STATS_FIELD(stats, i) (*(zend_ulong*)((char*)(stats) + stats_fields[i].offset))
+
+/* Counters of the requests the process has completed. Every thread adds the counters of a request to them once */
+/* it ends, which is the only time threads share engine state, so a lock is cheap enough. */
+static struct jsonpath_stats process_stats;
+#ifdef ZTS
+static MUTEX_T process_stats_lock;
+#endif
+
+/* Monotonic time in nanoseconds */
+zend_ulong stats_now(void) {
+#if PHP_VERSION_ID >= 80300
+  return (zend_ulong)zend_hrtime();
+#elif PHP_VERSION_ID >= 80000
+  return (zend_ulong)php_hrtime_current();
+#elif defined(PHP_WIN32)
+  /* php_hrtime_current() isn't exported before PHP 8.0 */
+  LARGE_INTEGER frequency, now;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&now);
+  return (zend_ulong)((double)now.QuadPart * 1000000000.0 / (double)frequency.QuadPart);
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (zend_ulong)now.tv_sec * 1000000000 + (zend_ulong)now.tv_nsec;
+#endif
+}
+
+void stats_add(struct jsonpath_stats* total, const struct jsonpath_stats* stats) {
+  for (size_t i = 0; i < sizeof(stats_fields) / sizeof(stats_fields[0]); i++) {
+    STATS_FIELD(total, i) += STATS_FIELD(stats, i);
+  }
+}
+
+void stats_startup(void) {
+#ifdef ZTS
+  process_stats_lock = tsrm_mutex_alloc();
+#endif
+}
+
+void stats_shutdown(void) {
+#ifdef ZTS
+  tsrm_mutex_free(process_stats_lock);
+#endif
+}
+
+/* Add the counters of a request that has ended to the process counters */
+void stats_commit(const struct jsonpath_stats* stats) {
+#ifdef ZTS
+  tsrm_mutex_lock(process_stats_lock);
+#endif
+  stats_add(&process_stats, stats);
+#ifdef ZTS
+  tsrm_mutex_unlock(process_stats_lock);
+#endif
+}
+
+/* Add the process counters to total */
+void stats_add_process(struct jsonpath_stats* total) {
+#ifdef ZTS
+  tsrm_mutex_lock(process_stats_lock);
+#endif
+  stats_add(total, &process_stats);
+#ifdef ZTS
+  tsrm_mutex_unlock(process_stats_lock);
+#endif
+}
+
+/* Counters as an array of name => value */
+void stats_to_array(const struct jsonpath_stats* stats, zval* return_value) {
+  array_init_size(return_value, sizeof(stats_fields) / sizeof(stats_fields[0]));
+
+  for (size_t i = 0; i < sizeof(stats_fields) / sizeof(stats_fields[0]); i++) {
+    add_assoc_long(return_value, stats_fields[i].name, (zend_long)STATS_FIELD(stats, i));
+  }
+}
+
+/* Counters as rows of the phpinfo() table being printed */
+void stats_print_info(const struct jsonpath_stats* stats) {
+  char buf[32];
+
+  for (size_t i = 0; i < sizeof(stats_fields) / sizeof(stats_fields[0]); i++) {
+    snprintf(buf, sizeof(buf), ZEND_ULONG_FMT, STATS_FIELD(stats, i));
+    php_info_print_table_row(2, stats_fields[i].name, buf);
+  }
+}
+
+#undef STATS_FIELD
@@ -0,0 +1,35 @@
+#ifndef STATS_H
+#define STATS_H 1
+
+#include "php.h"
+
+/* Engine counters, kept for the current request and for the requests the process has completed. The counters */
+/* of the current request are module globals, so under ZTS every thread counts its own requests without sharing */
+/* anything with the other threads until the request ends. */
+struct jsonpath_stats {
+  zend_ulong queries_compiled;
+  zend_ulong queries_executed;
+  zend_ulong nodes_visited; /* values selected by a segment, tested by a filter or descended into */
+  zend_ulong hash_lookups;  /* keys and indexes looked up in arrays and property tables */
+  zend_ulong results_copied;
+  zend_ulong bytes_copied; /* matches are shared by refcount, so this is their result slots and rendered paths */
+  zend_ulong regex_matches;
+  zend_ulong lex_ns;
+  zend_ulong parse_ns; /* building, validating and compiling the parse tree */
+  zend_ulong eval_ns;
+};
+
+/* Count n more of a counter of the current request, the module globals must be in scope (php_jsonpath.h). The */
+/* evaluation counts nodes and lookups locally and adds them once per segment or per evaluation, not per node. */
+#define JSONPATH_COUNT(counter, n) (JSONPATH_G(stats).counter += (n))
+
+zend_ulong stats_now(void);
+void stats_add(struct jsonpath_stats* total, const struct jsonpath_stats* stats);
+void stats_startup(void);
+void stats_shutdown(void);
+void stats_commit(const struct jsonpath_stats* stats);
+void stats_add_process(struct jsonpath_stats* total);
+void stats_to_array(const struct jsonpath_stats* stats, zval* return_value);
+void stats_print_info(const struct jsonpath_stats* stats);
+
+#endif /* STATS_H */
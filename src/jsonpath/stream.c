@@ -0,0 +1,932 @@
+#include "stream.h"
+
+#include <ext/json/php_json.h>
+
+#include "interpreter.h"
+#include "php_jsonpath.h"
+#include "zend_arena.h"
+
+/* Evaluates a query while scanning JSON text, without decoding the whole document. Containers on the path of */
+/* the query are walked in place, values that can't match are validated and skipped without allocating, and */
+/* only the values the interpreter needs (matches, filter candidates and containers that can't be walked) are */
+/* decoded with the decoder json_decode() uses. Matches are returned in the order JsonPath::find() returns */
+/* them for the decoded document, falling back to decoding everything when that can't be done in one pass. */
+
+#define STREAM_ARENA_SIZE 4096
+#define STREAM_KEY_SCAN_LIMIT 16
+
+enum stream_entry_type {
+  ENTRY_RESULT,  /* the value is a match */
+  ENTRY_APPLY,   /* apply tok to the children of the value */
+  ENTRY_DESCEND, /* recursive descent into the value, applying tok at every level */
+  ENTRY_FILTER   /* the value is a candidate of the filter expression tok */
+};
+
+/* An evaluation pending on a value, i.e. the interpreter call find() makes on it, and where its matches go */
+struct stream_entry {
+  enum stream_entry_type type;
+  struct ast_node* tok;
+  zval* out;
+};
+
+/* An evaluation active on a container that is walked in place */
+struct stream_state {
+  struct ast_node* tok;
+  zval* out;
+  zval* slots; /* buffered matches, appended to out in order when the container ends */
+  int slot_count;
+  bool descend; /* the descent into the children, which find() returns after the matches of tok */
+};
+
+struct stream_ctx {
+  const char* p;
+  const char* end;
+  int depth;
+  php_json_error_code error;
+  bool fallback; /* the document can't be evaluated in one pass, e.g. an object has duplicate keys */
+  zend_arena* arena;
+  zend_ulong* keys; /* hashes of the keys of the objects being walked */
+  uint32_t key_count;
+  uint32_t key_cap;
+};
+
+static bool stream_value(struct stream_ctx* ctx, struct stream_entry* entries, int count);
+static bool skip_value(struct stream_ctx* ctx);
+
+static bool stream_error(struct stream_ctx* ctx, php_json_error_code error) {
+  if (ctx->error == PHP_JSON_ERROR_NONE) {
+    ctx->error = error;
+  }
+
+  return false;
+}
+
+static void throw_json_error(php_json_error_code error) {
+  const char* message;
+
+  switch (error) {
+    case PHP_JSON_ERROR_DEPTH:
+      message = "Maximum stack depth exceeded";
+      break;
+    case PHP_JSON_ERROR_CTRL_CHAR:
+      message = "Control character error, possibly incorrectly encoded";
+      break;
+    case PHP_JSON_ERROR_UTF8:
+      message = "Malformed UTF-8 characters, possibly incorrectly encoded";
+      break;
+    case PHP_JSON_ERROR_UTF16:
+      message = "Single unpaired UTF-16 surrogate in unicode escape";
+      break;
+    default:
+      error = PHP_JSON_ERROR_SYNTAX;
+      message = "Syntax error";
+      break;
+  }
+
+  zend_throw_exception(php_json_exception_ce, message, error);
+}
+
+/* ---- scanner ---- */
+
+#define IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+
+static void skip_whitespace(struct stream_ctx* ctx) {
+  while (ctx->p < ctx->end && (*ctx->p == ' ' || *ctx->p == '\t' || *ctx->p == '\n' || *ctx->p == '\r')) {
+    ctx->p++;
+  }
+}
+
+static bool read_hex4(const unsigned char* p, const unsigned char* end, unsigned int* code) {
+  if (end - p < 4) {
+    return false;
+  }
+
+  *code = 0;
+
+  for (int i = 0; i < 4; i++) {
+    unsigned char c = p[i];
+    unsigned int digit;
+
+    if (IS_DIGIT(c)) {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      return false;
+    }
+
+    *code = (*code << 4) | digit;
+  }
+
+  return true;
+}
+
+/* Length of the UTF-8 sequence at p, or 0 if it's malformed. The rules are the same as in ext/json's scanner. */
+static size_t utf8_sequence_length(const unsigned char* p, const unsigned char* end) {
+  unsigned char lead = p[0], lo = 0x80, hi = 0xBF;
+  size_t len;
+
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    len = 2;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    len = 3;
+    lo = lead == 0xE0 ? 0xA0 : lo;
+    hi = lead == 0xED ? 0x9F : hi;
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    len = 4;
+    lo = lead == 0xF0 ? 0x90 : lo;
+    hi = lead == 0xF4 ? 0x8F : hi;
+  } else {
+    return 0;
+  }
+
+  if ((size_t)(end - p) < len || p[1] < lo || p[1] > hi) {
+    return 0;
+  }
+
+  for (size_t i = 2; i < len; i++) {
+    if (p[i] < 0x80 || p[i] > 0xBF) {
+      return 0;
+    }
+  }
+
+  return len;
+}
+
+/* Validate the string at ctx->p and move past it. escaped is set if it contains escape sequences. */
+static bool scan_string(struct stream_ctx* ctx, bool* escaped) {
+  const unsigned char* p = (const unsigned char*)ctx->p + 1;
+  const unsigned char* end = (const unsigned char*)ctx->end;
+  unsigned int code, low;
+
+  while (p < end) {
+    unsigned char c = *p;
+
+    if (c == '"') {
+      ctx->p = (const char*)p + 1;
+      return true;
+    }
+
+    if (c == '\\') {
+      *escaped = true;
+
+      if (++p == end) {
+        break;
+      }
+
+      switch (*p) {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+          p++;
+          continue;
+        case 'u':
+          if (!read_hex4(p + 1, end, &code) || (code >= 0xDC00 && code <= 0xDFFF)) {
+            return stream_error(ctx, PHP_JSON_ERROR_UTF16);
+          }
+          p += 5;
+          /* a high surrogate must be followed by a low one */
+          if (code >= 0xD800 && code <= 0xDBFF) {
+            if (end - p < 2 || p[0] != '\\' || p[1] != 'u' || !read_hex4(p + 2, end, &low) || low < 0xDC00 ||
+                low > 0xDFFF) {
+              return stream_error(ctx, PHP_JSON_ERROR_UTF16);
+            }
+            p += 6;
+          }
+          continue;
+        default:
+          return stream_error(ctx, PHP_JSON_ERROR_SYNTAX);
+      }
+    }
+
+    if (c < 0x20) {
+      return stream_error(ctx, PHP_JSON_ERROR_CTRL_CHAR);
+    }
+
+    if (c < 0x80) {
+      p++;
+      continue;
+    }
+
+    size_t len = utf8_sequence_length(p, end);
+
+    if (len == 0) {
+      return stream_error(ctx, PHP_JSON_ERROR_UTF8);
+    }
+
+    p += len;
+  }
+
+  /* ext/json reports unterminated strings as control character errors */
+  return stream_error(ctx, PHP_JSON_ERROR_CTRL_CHAR);
+}
+
+static bool scan_number(struct stream_ctx* ctx) {
+  const char* p = ctx->p;
+
+  if (p < ctx->end && *p == '-') {
+    p++;
+  }
+
+  if (p < ctx->end && *p == '0') {
+    p++;
+  } else if (p < ctx->end && *p >= '1' && *p <= '9') {
+    while (p < ctx->end && IS_DIGIT(*p)) {
+      p++;
+    }
+  } else {
+    return stream_error(ctx, PHP_JSON_ERROR_SYNTAX);
+  }
+
+  if (p < ctx->end && *p == '.') {
+    if (++p == ctx->end || !IS_DIGIT(*p)) {
+      return stream_error(ctx, PHP_JSON_ERROR_SYNTAX);
+    }
+    while (p < ctx->end && IS_DIGIT(*p)) {
+      p++;
+    }
+  }
+
+  if (p < ctx->end && (*p == 'e' || *p == 'E')) {
+    if (++p < ctx->end && (*p == '+' || *p == '-')) {
+      p++;
+    }
+    if (p == ctx->end || !IS_DIGIT(*p)) {
+      return stream_error(ctx, PHP_JSON_ERROR_SYNTAX);
+    }
+    while (p < ctx->end && IS_DIGIT(*p)) {
+      p++;
+    }
+  }
+
+  ctx->p = p;
+
+  return true;
+}
+
+static bool scan_literal(struct stream_ctx* ctx, const char* literal, size_t len) {
+  if ((size_t)(ctx->end - ctx->p) < len || memcmp(ctx->p, literal, len) != 0) {
+    return stream_error(ctx, PHP_JSON_ERROR_SYNTAX);
+  }
+
+  ctx->p += len;
+
+  return true;
+}
+
+/* Move past the opening bracket of a container */
+static bool enter_container(struct stream_ctx* ctx) {
+  if (++ctx->depth > PHP_JSON_PARSER_DEFAULT_DEPTH) {
+    return stream_error(ctx, PHP_JSON_ERROR_DEPTH);
+  }
+
+  ctx->p++;
+  skip_whitespace(ctx);
+
+  return true;
+}
+
+/* Move past the closing bracket of an empty container */
+static bool leave_if_empty(struct stream_ctx* ctx, char close) {
+  if (ctx->p < ctx->end && *ctx->p == close) {
+    ctx->p++;
+    ctx->depth--;
+    return true;
+  }
+
+  return false;
+}
+
+/* Move past the separator after a member of a container, or past its closing bracket */
+static bool next_member(struct stream_ctx* ctx, char close, bool* more) {
+  skip_whitespace(ctx);
+
+  if (ctx->p < ctx->end && *ctx->p == ',') {
+    ctx->p++;
+    skip_whitespace(ctx);
+    *more = true;
+    return true;
+  }
+
+  if (leave_if_empty(ctx, close)) {
+    *more = false;
+    return true;
+  }
+
+  return stream_error(ctx, PHP_JSON_ERROR_SYNTAX);
+}
+
+/* Move past the colon after a member name */
+static bool scan_name_separator(struct stream_ctx* ctx) {
+  skip_whitespace(ctx);
+
+  if (ctx->p == ctx->end || *ctx->p != ':') {
+    return stream_error(ctx, PHP_JSON_ERROR_SYNTAX);
+  }
+
+  ctx->p++;
+  skip_whitespace(ctx);
+
+  return true;
+}
+
+static bool scan_member_name(struct stream_ctx* ctx, bool* escaped) {
+  if (ctx->p == ctx->end || *ctx->p != '"') {
+    return stream_error(ctx, PHP_JSON_ERROR_SYNTAX);
+  }
+
+  return scan_string(ctx, escaped) && scan_name_separator(ctx);
+}
+
+/* Validate the value at ctx->p and move past it */
+static bool skip_value(struct stream_ctx* ctx) {
+  bool escaped, more = false;
+
+  if (ctx->p == ctx->end) {
+    return stream_error(ctx, PHP_JSON_ERROR_SYNTAX);
+  }
+
+  switch (*ctx->p) {
+    case '{':
+      if (!enter_container(ctx)) {
+        return false;
+      }
+      if (leave_if_empty(ctx, '}')) {
+        return true;
+      }
+      do {
+        if (!scan_member_name(ctx, &escaped) || !skip_value(ctx) || !next_member(ctx, '}', &more)) {
+          return false;
+        }
+      } while (more);
+      return true;
+    case '[':
+      if (!enter_container(ctx)) {
+        return false;
+      }
+      if (leave_if_empty(ctx, ']')) {
+        return true;
+      }
+      do {
+        if (!skip_value(ctx) || !next_member(ctx, ']', &more)) {
+          return false;
+        }
+      } while (more);
+      return true;
+    case '"':
+      return scan_string(ctx, &escaped);
+    case 't':
+      return scan_literal(ctx, "true", 4);
+    case 'f':
+      return scan_literal(ctx, "false", 5);
+    case 'n':
+      return scan_literal(ctx, "null", 4);
+    default:
+      return scan_number(ctx);
+  }
+}
+
+/* Record a key of the object being walked, returning false if the object already has a key with the same hash. */
+/* json_decode() keeps the last value of a duplicate key in the position of the first one, which can't be */
+/* reproduced in one pass. Wide objects switch from scanning the key hashes to a hash set. */
+static bool remember_key(struct stream_ctx* ctx, uint32_t base, HashTable** seen, const char* key, size_t key_len) {
+  zend_ulong hash = zend_inline_hash_func(key, key_len);
+
+  if (*seen != NULL) {
+    return zend_hash_index_add_empty_element(*seen, hash) != NULL;
+  }
+
+  for (uint32_t i = base; i < ctx->key_count; i++) {
+    if (ctx->keys[i] == hash) {
+      return false;
+    }
+  }
+
+  if (ctx->key_count - base == STREAM_KEY_SCAN_LIMIT) {
+    ALLOC_HASHTABLE(*seen);
+    zend_hash_init(*seen, STREAM_KEY_SCAN_LIMIT * 2, NULL, NULL, 0);
+
+    for (uint32_t i = base; i < ctx->key_count; i++) {
+      zend_hash_index_add_empty_element(*seen, ctx->keys[i]);
+    }
+
+    ctx->key_count = base;
+
+    return zend_hash_index_add_empty_element(*seen, hash) != NULL;
+  }
+
+  if (ctx->key_count == ctx->key_cap) {
+    ctx->key_cap = ctx->key_cap == 0 ? STREAM_KEY_SCAN_LIMIT * 4 : ctx->key_cap * 2;
+    ctx->keys = safe_erealloc(ctx->keys, ctx->key_cap, sizeof(zend_ulong), 0);
+  }
+
+  ctx->keys[ctx->key_count++] = hash;
+
+  return true;
+}
+
+/* ---- evaluation ---- */
+
+static zval* output(zval* out) {
+  if (Z_TYPE_P(out) != IS_ARRAY) {
+    array_init(out);
+  }
+
+  return out;
+}
+
+/* Append the matches buffered in src to out, keeping their order */
+static void output_concat(zval* out, zval* src) {
+  zval* value;
+
+  if (Z_TYPE_P(src) != IS_ARRAY) {
+    return;
+  }
+
+  if (Z_TYPE_P(out) != IS_ARRAY) {
+    ZVAL_COPY_VALUE(out, src);
+    ZVAL_UNDEF(src);
+    return;
+  }
+
+  ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(src), value) {
+    Z_TRY_ADDREF_P(value);
+    add_next_index_zval(out, value);
+  }
+  ZEND_HASH_FOREACH_END();
+
+  zval_ptr_dtor(src);
+  ZVAL_UNDEF(src);
+}
+
+static int add_apply(struct stream_entry* entries, int count, struct ast_node* tok, zval* out) {
+  while (tok != NULL && tok->type == AST_ROOT) {
+    tok = tok->next;
+  }
+
+  if (tok == NULL) {
+    return count;
+  }
+
+  if (tok->type == AST_RECURSE) {
+    if (tok->next != NULL) {
+      entries[count++] = (struct stream_entry){ENTRY_DESCEND, tok->next, out};
+    }
+    return count;
+  }
+
+  entries[count++] = (struct stream_entry){ENTRY_APPLY, tok, out};
+
+  return count;
+}
+
+/* Add the evaluation of a child that was selected by tok, i.e. what copy_result_or_continue() does with it */
+static int add_match(struct stream_entry* entries, int count, struct ast_node* tok, zval* out) {
+  if (tok->type == AST_EXPR) {
+    entries[count++] = (struct stream_entry){ENTRY_FILTER, tok, out};
+  } else if (tok->next == NULL) {
+    entries[count++] = (struct stream_entry){ENTRY_RESULT, tok, out};
+  } else {
+    count = add_apply(entries, count, tok->next, out);
+  }
+
+  return count;
+}
+
+/* Evaluate decoded values with the interpreter */
+static void evaluate_entries(zval* value, struct stream_entry* entries, int count) {
+  struct eval_ctx eval;
+
+  for (int i = 0; i < count; i++) {
+    struct stream_entry* entry = &entries[i];
+
+    eval_init(&eval, output(entry->out), 0);
+
+    switch (entry->type) {
+      case ENTRY_RESULT:
+        Z_TRY_ADDREF_P(value);
+        add_next_index_zval(eval.result, value);
+        break;
+      case ENTRY_APPLY:
+        eval_ast(value, value, entry->tok, &eval);
+        break;
+      case ENTRY_DESCEND:
+        exec_recursive_descent(value, value, entry->tok, &eval);
+        break;
+      case ENTRY_FILTER:
+        JSONPATH_COUNT(nodes_visited, 1);
+        if (evaluate_expression(value, value, entry->tok)) {
+          copy_result_or_continue(value, value, entry->tok, &eval);
+        }
+        break;
+    }
+
+    eval_free(&eval);
+  }
+}
+
+static bool needs_value(struct stream_entry* entries, int count) {
+  for (int i = 0; i < count; i++) {
+    if (entries[i].type == ENTRY_RESULT || entries[i].type == ENTRY_FILTER) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/* Whether the children selected by tok can be told apart by their key or position alone */
+static bool is_walkable(struct ast_node* tok, bool is_array) {
+  switch (tok->type) {
+    case AST_SELECTOR:
+    case AST_WILD_CARD:
+    case AST_EXPR:
+      return true;
+    case AST_INDEX_LIST:
+      /* negative indexes depend on the number of children */
+      for (int i = 0; i < tok->data.d_list.count; i++) {
+        if (tok->data.d_list.indexes[i] < 0) {
+          return false;
+        }
+      }
+      return true;
+    case AST_INDEX_SLICE: {
+      zend_long start = tok->data.d_list.indexes[0];
+      zend_long end = tok->data.d_list.count > 1 ? tok->data.d_list.indexes[1] : ZEND_LONG_MAX;
+      zend_long step = tok->data.d_list.count > 2 ? tok->data.d_list.indexes[2] : 1;
+      /* slices of objects use the object's keys, only forward slices from the start can be streamed */
+      return is_array && start >= 0 && end >= 0 && step > 0;
+    }
+    default:
+      return false;
+  }
+}
+
+static bool can_walk(struct stream_entry* entries, int count, bool is_array) {
+  if (needs_value(entries, count)) {
+    return false;
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (!is_walkable(entries[i].tok, is_array)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static bool slice_contains(struct ast_node* tok, zend_long index) {
+  zend_long start = tok->data.d_list.indexes[0];
+  zend_long end = tok->data.d_list.count > 1 ? tok->data.d_list.indexes[1] : ZEND_LONG_MAX;
+  zend_long step = tok->data.d_list.count > 2 ? tok->data.d_list.indexes[2] : 1;
+
+  if (start == ZEND_LONG_MAX) {
+    start = 0;
+  }
+
+  return index >= start && index < end && (index - start) % step == 0;
+}
+
+/* Collect the evaluations of a child of a walked container. Array children are identified by their position, */
+/* object children by their key, numeric keys being integer keys once decoded. */
+static int child_entries(struct stream_state* states, int state_count, struct stream_entry* children, zend_long position,
+                         const char* key, size_t key_len) {
+  zend_ulong numeric_key;
+  bool has_numeric_key = key != NULL && ZEND_HANDLE_NUMERIC_STR_EX(key, key_len, numeric_key);
+  zend_long index = key == NULL ? position : (has_numeric_key ? (zend_long)numeric_key : -1);
+  int count = 0;
+
+  for (int i = 0; i < state_count; i++) {
+    struct stream_state* state = &states[i];
+    struct ast_node* tok = state->tok;
+
+    if (state->descend) {
+      children[count++] = (struct stream_entry){ENTRY_DESCEND, tok, &state->slots[0]};
+      continue;
+    }
+
+    switch (tok->type) {
+      case AST_SELECTOR:
+        if (key == NULL ? (tok->data.d_selector.is_index && (zend_long)tok->data.d_selector.index == index)
+                        : (ZSTR_LEN(tok->data.d_selector.key) == key_len &&
+                           memcmp(ZSTR_VAL(tok->data.d_selector.key), key, key_len) == 0)) {
+          count = add_match(children, count, tok, state->out);
+        }
+        break;
+      case AST_WILD_CARD:
+      case AST_EXPR:
+        count = add_match(children, count, tok, state->out);
+        break;
+      case AST_INDEX_LIST:
+        for (int j = 0; j < tok->data.d_list.count; j++) {
+          if (index >= 0 && tok->data.d_list.indexes[j] == index) {
+            count = add_match(children, count, tok, state->slots != NULL ? &state->slots[j] : state->out);
+          }
+        }
+        break;
+      case AST_INDEX_SLICE:
+        if (slice_contains(tok, index)) {
+          count = add_match(children, count, tok, state->out);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  return count;
+}
+
+static bool walk_array(struct stream_ctx* ctx, struct stream_state* states, int state_count,
+                       struct stream_entry* children) {
+  zend_long position = 0;
+  bool more = false;
+
+  if (leave_if_empty(ctx, ']')) {
+    return true;
+  }
+
+  do {
+    int count = child_entries(states, state_count, children, position++, NULL, 0);
+
+    if (!stream_value(ctx, children, count) || !next_member(ctx, ']', &more)) {
+      return false;
+    }
+  } while (more);
+
+  return true;
+}
+
+static bool walk_object(struct stream_ctx* ctx, struct stream_state* states, int state_count,
+                        struct stream_entry* children) {
+  uint32_t key_base = ctx->key_count;
+  HashTable* seen = NULL;
+  bool success = true, more = false;
+
+  if (leave_if_empty(ctx, '}')) {
+    return true;
+  }
+
+  do {
+    const char* name = ctx->p;
+    bool escaped = false;
+    zval decoded;
+
+    if (ctx->p == ctx->end || *ctx->p != '"') {
+      success = stream_error(ctx, PHP_JSON_ERROR_SYNTAX);
+      break;
+    }
+
+    if (!scan_string(ctx, &escaped)) {
+      success = false;
+      break;
+    }
+
+    const char* key = name + 1;
+    size_t key_len = ctx->p - name - 2;
+
+    ZVAL_UNDEF(&decoded);
+
+    if (escaped) {
+      php_json_decode_ex(&decoded, (char*)name, ctx->p - name, 0, PHP_JSON_PARSER_DEFAULT_DEPTH);
+      key = Z_STRVAL(decoded);
+      key_len = Z_STRLEN(decoded);
+    }
+
+    if (!remember_key(ctx, key_base, &seen, key, key_len)) {
+      zval_ptr_dtor(&decoded);
+      ctx->fallback = true;
+      success = false;
+      break;
+    }
+
+    int count = child_entries(states, state_count, children, 0, key, key_len);
+
+    success = scan_name_separator(ctx) && stream_value(ctx, children, count) && next_member(ctx, '}', &more);
+
+    zval_ptr_dtor(&decoded);
+  } while (success && more);
+
+  if (seen != NULL) {
+    zend_hash_destroy(seen);
+    FREE_HASHTABLE(seen);
+  }
+
+  ctx->key_count = key_base;
+
+  return success;
+}
+
+/* Walk a container in place. Evaluations are expanded into states the way the interpreter would run them on */
+/* the decoded container, every state writing to its own output so the matches end up in the order of find(). */
+static bool walk_container(struct stream_ctx* ctx, struct stream_entry* entries, int count) {
+  bool is_array = *ctx->p == '[';
+  void* checkpoint = zend_arena_checkpoint(ctx->arena);
+  int state_count = 0, slot_count = 0, child_cap = 0;
+
+  if (!enter_container(ctx)) {
+    return false;
+  }
+
+  for (int i = 0; i < count; i++) {
+    int width = entries[i].tok->type == AST_INDEX_LIST ? entries[i].tok->data.d_list.count : 1;
+
+    state_count++;
+    child_cap += width;
+    slot_count += width > 1 ? width : 0;
+
+    if (entries[i].type == ENTRY_DESCEND) {
+      state_count++;
+      child_cap++;
+      slot_count++;
+    }
+  }
+
+  struct stream_state* states = zend_arena_alloc(&ctx->arena, sizeof(struct stream_state) * state_count);
+  struct stream_entry* children = zend_arena_alloc(&ctx->arena, sizeof(struct stream_entry) * child_cap);
+  zval* slots = slot_count > 0 ? zend_arena_alloc(&ctx->arena, sizeof(zval) * slot_count) : NULL;
+  struct stream_state* state = states;
+  zval* slot = slots;
+
+  for (int i = 0; i < slot_count; i++) {
+    ZVAL_UNDEF(&slots[i]);
+  }
+
+  for (int i = 0; i < count; i++) {
+    struct ast_node* tok = entries[i].tok;
+    int width = tok->type == AST_INDEX_LIST ? tok->data.d_list.count : 1;
+
+    /* the matches of tok, buffered per index if the index list is out of order */
+    *state = (struct stream_state){tok, entries[i].out, NULL, 0, false};
+    if (width > 1) {
+      state->slots = slot;
+      state->slot_count = width;
+      slot += width;
+    }
+    state++;
+
+    /* the descent is buffered, since find() returns it after all the matches of tok at this level */
+    if (entries[i].type == ENTRY_DESCEND) {
+      *state = (struct stream_state){tok, entries[i].out, slot, 1, true};
+      slot++;
+      state++;
+    }
+  }
+
+  bool success = is_array ? walk_array(ctx, states, state_count, children)
+                          : walk_object(ctx, states, state_count, children);
+
+  for (int i = 0; i < state_count; i++) {
+    for (int j = 0; j < states[i].slot_count; j++) {
+      if (success) {
+        output_concat(states[i].out, &states[i].slots[j]);
+      } else {
+        zval_ptr_dtor(&states[i].slots[j]);
+      }
+    }
+  }
+
+  zend_arena_release(&ctx->arena, checkpoint);
+
+  return success;
+}
+
+static bool stream_value(struct stream_ctx* ctx, struct stream_entry* entries, int count) {
+  if (count == 0) {
+    return skip_value(ctx);
+  }
+
+  bool is_container = ctx->p < ctx->end && (*ctx->p == '{' || *ctx->p == '[');
+
+  if (is_container && can_walk(entries, count, *ctx->p == '[')) {
+    return walk_container(ctx, entries, count);
+  }
+
+  const char* start = ctx->p;
+
+  if (!skip_value(ctx)) {
+    return false;
+  }
+
+  /* scalars have no children, only an evaluation of the scalar itself can match */
+  if (!is_container && !needs_value(entries, count)) {
+    return true;
+  }
+
+  zval value;
+
+  if (php_json_decode_ex(&value, (char*)start, ctx->p - start, PHP_JSON_OBJECT_AS_ARRAY,
+                         PHP_JSON_PARSER_DEFAULT_DEPTH) == FAILURE) {
+    return stream_error(ctx, PHP_JSON_ERROR_SYNTAX);
+  }
+
+  evaluate_entries(&value, entries, count);
+  zval_ptr_dtor(&value);
+
+  return true;
+}
+
+/* Filters that refer to the root of the document need the whole document */
+static bool plan_is_streamable(struct query_plan* plan) {
+  for (int i = 0; i < plan->node_count; i++) {
+    if (plan->nodes[i].type == AST_ROOT && &plan->nodes[i] != plan->head) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static bool stream_document(const char* json, size_t json_len, struct query_plan* plan, zval* result, bool* fallback) {
+  struct stream_ctx ctx = {0};
+  struct stream_entry root[1];
+  int count = add_apply(root, 0, plan->head, result);
+
+  ctx.p = json;
+  ctx.end = json + json_len;
+  ctx.arena = zend_arena_create(STREAM_ARENA_SIZE);
+
+  skip_whitespace(&ctx);
+
+  bool success = stream_value(&ctx, root, count);
+
+  if (success) {
+    skip_whitespace(&ctx);
+    if (ctx.p != ctx.end) {
+      success = stream_error(&ctx, PHP_JSON_ERROR_SYNTAX);
+    }
+  }
+
+  zend_arena_destroy(ctx.arena);
+
+  if (ctx.keys != NULL) {
+    efree(ctx.keys);
+  }
+
+  if (!success) {
+    zval_ptr_dtor(result);
+    ZVAL_UNDEF(result);
+
+    if (ctx.fallback) {
+      *fallback = true;
+    } else {
+      throw_json_error(ctx.error);
+    }
+  }
+
+  return success;
+}
+
+static bool decode_document(const char* json, size_t json_len, struct query_plan* plan, zval* result) {
+  zval document;
+  struct eval_ctx eval;
+
+  if (php_json_decode_ex(&document, (char*)json, json_len, PHP_JSON_OBJECT_AS_ARRAY, PHP_JSON_PARSER_DEFAULT_DEPTH) ==
+      FAILURE) {
+    throw_json_error(JSON_G(error_code));
+    return false;
+  }
+
+  array_init(result);
+  eval_init(&eval, result, 0);
+  eval_ast(&document, &document, plan->head, &eval);
+  eval_free(&eval);
+  zval_ptr_dtor(&document);
+
+  return true;
+}
+
+/* Evaluate a plan against JSON text, with the result of find() on json_decode($json, true). Returns false if an */
+/* exception was thrown. */
+bool stream_find(const char* json, size_t json_len, struct query_plan* plan, zval* return_value) {
+  bool fallback = !plan_is_streamable(plan);
+  zval result;
+
+  ZVAL_UNDEF(&result);
+
+  if (!fallback && !stream_document(json, json_len, plan, &result, &fallback) && !fallback) {
+    return false;
+  }
+
+  if (fallback && !decode_document(json, json_len, plan, &result)) {
+    return false;
+  }
+
+  if (Z_TYPE(result) != IS_ARRAY || zend_hash_num_elements(Z_ARRVAL(result)) == 0) {
+    zval_ptr_dtor(&result);
+    RETVAL_FALSE;
+    return true;
+  }
+
+  RETVAL_COPY_VALUE(&result);
+
+  return true;
+}
@@ -0,0 +1,11 @@
+#ifndef STREAM_H
+#define STREAM_H 1
+
+#include <stdbool.h>
+
+#include "parser.h"
+#include "php.h"
+
+bool stream_find(const char* json, size_t json_len, struct query_plan* plan, zval* return_value);
+
+#endif /* STREAM_H */
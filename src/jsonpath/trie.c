@@ -0,0 +1,151 @@
+#include "trie.h"
+
+#include "interpreter.h"
+#include "zend_arena.h"
+
+/* Evaluates several queries in one traversal. The plans are merged into a trie of segments, so queries sharing a */
+/* prefix (e.g. $.store.book[*].title and $.store.book[*].price) select the values of that prefix once. Every */
+/* query still receives its matches in the order JsonPath::find() returns them, since the segments of a single */
+/* query are applied in the same nested order as by the interpreter. */
+
+#define TRIE_ARENA_SIZE 4096
+
+struct trie_query {
+  uint32_t index;
+  struct trie_query* next;
+};
+
+struct trie_node {
+  struct ast_node* tok; /* the segment, in the plan of the first query that has it */
+  bool descend;         /* the segment is preceded by a recursive descent */
+  struct trie_node* children;
+  struct trie_node* sibling;
+  struct trie_query* queries; /* the queries ending with this segment */
+};
+
+struct query_trie {
+  zend_arena* arena;
+  struct trie_node root;
+};
+
+/* State of an evaluation, handed to the interpreter through the visitor of the evaluation context */
+struct trie_walk {
+  struct trie_node* node; /* the node whose segment is being applied */
+  zval* results;
+};
+
+static struct trie_node* trie_child(struct query_trie* trie, struct trie_node* parent, struct ast_node* tok,
+                                    bool descend) {
+  struct trie_node** link = &parent->children;
+
+  for (; *link != NULL; link = &(*link)->sibling) {
+    if ((*link)->descend == descend && ast_node_equal((*link)->tok, tok)) {
+      return *link;
+    }
+  }
+
+  struct trie_node* node = zend_arena_calloc(&trie->arena, 1, sizeof(struct trie_node));
+
+  node->tok = tok;
+  node->descend = descend;
+  *link = node;
+
+  return node;
+}
+
+/* Merge the plans into a trie. The plans must outlive it. */
+struct query_trie* trie_build(struct query_plan** plans, uint32_t count) {
+  struct query_trie* trie = ecalloc(1, sizeof(struct query_trie));
+
+  trie->arena = zend_arena_create(TRIE_ARENA_SIZE);
+
+  for (uint32_t i = 0; i < count; i++) {
+    struct trie_node* node = &trie->root;
+    struct ast_node* tok = plans[i]->head;
+
+    if (tok != NULL && tok->type == AST_ROOT) {
+      tok = tok->next;
+    }
+
+    if (tok == NULL) {
+      /* a lone $ doesn't match anything */
+      continue;
+    }
+
+    while (tok != NULL) {
+      bool descend = tok->type == AST_RECURSE;
+
+      if (descend) {
+        tok = tok->next;
+      }
+
+      node = trie_child(trie, node, tok, descend);
+      tok = tok->next;
+    }
+
+    struct trie_query** link = &node->queries;
+
+    while (*link != NULL) {
+      link = &(*link)->next;
+    }
+
+    *link = zend_arena_calloc(&trie->arena, 1, sizeof(struct trie_query));
+    (*link)->index = i;
+  }
+
+  return trie;
+}
+
+void trie_free(struct query_trie* trie) {
+  zend_arena_destroy(trie->arena);
+  efree(trie);
+}
+
+static void trie_step(zval* arr_head, zval* arr_cur, struct trie_node* node, struct eval_ctx* ctx) {
+  struct trie_walk* walk = ctx->visit_data;
+  struct trie_node* parent = walk->node;
+
+  walk->node = node;
+
+  if (node->descend) {
+    exec_recursive_descent(arr_head, arr_cur, node->tok, ctx);
+  } else {
+    eval_ast(arr_head, arr_cur, node->tok, ctx);
+  }
+
+  walk->node = parent;
+}
+
+/* A value was selected by the segment of the current node: it's a match of the queries ending here, and the */
+/* segments following this one are applied to it */
+static void trie_visit(zval* arr_head, zval* value, struct eval_ctx* ctx) {
+  struct trie_walk* walk = ctx->visit_data;
+  struct trie_node* node = walk->node;
+
+  for (struct trie_query* query = node->queries; query != NULL; query = query->next) {
+    zval tmp;
+    ZVAL_COPY_DEREF(&tmp, value);
+    add_next_index_zval(&walk->results[query->index], &tmp);
+  }
+
+  for (struct trie_node* child = node->children; child != NULL; child = child->sibling) {
+    trie_step(arr_head, value, child, ctx);
+  }
+}
+
+/* Evaluate every query against search_target, collecting the matches of the i-th query into results[i], which */
+/* must be initialized arrays */
+void trie_find(struct query_trie* trie, zval* search_target, zval* results) {
+  struct eval_ctx ctx;
+  struct trie_walk walk = {&trie->root, results};
+
+  eval_init(&ctx, NULL, 0);
+  ctx.visit = trie_visit;
+  ctx.visit_data = &walk;
+
+  for (struct trie_node* child = trie->root.children; child != NULL; child = child->sibling) {
+    trie_step(search_target, search_target, child, &ctx);
+  }
+
+  eval_free(&ctx);
+}
@@ -0,0 +1,15 @@
+#ifndef TRIE_H
+#define TRIE_H 1
+
+#include <stdbool.h>
+
+#include "parser.h"
+#include "php.h"
+
+struct query_trie;
+
+struct query_trie* trie_build(struct query_plan** plans, uint32_t count);
+void trie_find(struct query_trie* trie, zval* search_target, zval* results);
+void trie_free(struct query_trie* trie);
+
+#endif /* TRIE_H */
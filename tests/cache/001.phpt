@@ -0,0 +1,55 @@
+--TEST--
+Test cached queries return the same results on repeated evaluation
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--INI--
+jsonpath.cache_size=16
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+var_dump($jsonPath->find(["a", "b", "c"], '$[-1]'));
+
+echo "Assertion 2\n";
+var_dump($jsonPath->find(["a", "b", "c", "d", "e"], '$[-1]'));
+
+echo "Assertion 3\n";
+var_dump($jsonPath->find(["a", "b"], '$[-1]'));
+
+echo "Assertion 4\n";
+$data = ["items" => [["id" => 1, "name" => "one"], ["id" => 2, "name" => "two"]]];
+for ($i = 0; $i < 3; $i++) {
+    var_dump($jsonPath->find($data, '$.items[?(@.id == 2)].name'));
+}
+?>
+--EXPECT--
+Assertion 1
+array(1) {
+  [0]=>
+  string(1) "c"
+}
+Assertion 2
+array(1) {
+  [0]=>
+  string(1) "e"
+}
+Assertion 3
+array(1) {
+  [0]=>
+  string(1) "b"
+}
+Assertion 4
+array(1) {
+  [0]=>
+  string(3) "two"
+}
+array(1) {
+  [0]=>
+  string(3) "two"
+}
+array(1) {
+  [0]=>
+  string(3) "two"
+}
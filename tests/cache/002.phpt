@@ -0,0 +1,32 @@
+--TEST--
+Test invalid expressions are cached and throw the same exception on every call
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--INI--
+jsonpath.cache_size=16
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+
+for ($i = 0; $i < 2; $i++) {
+    try {
+        $jsonPath->find([], '$.book[');
+    } catch (RuntimeException $e) {
+        echo get_class($e) . ": " . $e->getMessage() . "\n";
+    }
+}
+
+for ($i = 0; $i < 2; $i++) {
+    try {
+        $jsonPath->find([], '$.a[?(@.b == 1]');
+    } catch (RuntimeException $e) {
+        echo get_class($e) . ": " . $e->getMessage() . "\n";
+    }
+}
+?>
+--EXPECT--
+RuntimeException: Missing filter end ]
+RuntimeException: Missing filter end ]
+RuntimeException: Missing closing paren )
+RuntimeException: Missing closing paren )
@@ -0,0 +1,31 @@
+--TEST--
+Test query cache statistics and eviction in phpinfo()
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--INI--
+jsonpath.cache_size=2
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+$data = ["a" => 1, "b" => 2, "c" => 3];
+
+$jsonPath->find($data, '$.a');
+$jsonPath->find($data, '$.a');
+$jsonPath->find($data, '$.b');
+$jsonPath->find($data, '$.c');
+$jsonPath->find($data, '$.a');
+
+ob_start();
+phpinfo(INFO_MODULES);
+$info = ob_get_clean();
+
+preg_match_all('/^query cache.*$/m', $info, $matches);
+echo implode("\n", $matches[0]);
+?>
+--EXPECT--
+query cache => enabled
+query cache entries => 2
+query cache hits => 1
+query cache misses => 4
+query cache evictions => 2
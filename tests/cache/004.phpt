@@ -0,0 +1,33 @@
+--TEST--
+Test queries are evaluated when the query cache is disabled
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--INI--
+jsonpath.cache_size=0
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+
+var_dump($jsonPath->find(["a" => ["b" => 42]], '$.a.b'));
+
+try {
+    $jsonPath->find([], '$.book[');
+} catch (RuntimeException $e) {
+    echo get_class($e) . ": " . $e->getMessage() . "\n";
+}
+
+ob_start();
+phpinfo(INFO_MODULES);
+$info = ob_get_clean();
+
+preg_match('/^query cache => .*$/m', $info, $matches);
+echo $matches[0];
+?>
+--EXPECT--
+array(1) {
+  [0]=>
+  int(42)
+}
+RuntimeException: Missing filter end ]
+query cache => disabled
@@ -0,0 +1,52 @@
+--TEST--
+Test a cached query evicted while it is being evaluated keeps being evaluated
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--INI--
+jsonpath.cache_size=2
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+$data = [
+    "pattern" => "invalid",
+    "items" => [["n" => "a"], ["n" => "b"], ["n" => "c"], ["n" => "b"]],
+];
+
+/* the pattern is only known at run time, its warning reaches the handler, which evicts the query being evaluated */
+$warnings = 0;
+set_error_handler(function () use ($jsonPath, &$warnings) {
+    $warnings++;
+    $jsonPath->find(["x" => 1], '$.x');
+    $jsonPath->find(["y" => 2], '$.y');
+    $jsonPath->find(["z" => 3], '$.z');
+    return true;
+});
+
+$query = '$.items[?(@.n =~ $.pattern || @.n == "b")].n';
+
+var_dump($jsonPath->find($data, $query));
+var_dump($jsonPath->exists($data, '$.items[?(@.n =~ $.pattern)]'));
+
+$result = [];
+foreach ($jsonPath->iterate($data, $query) as $match) {
+    $result[] = $match;
+}
+var_dump($result);
+var_dump($warnings);
+?>
+--EXPECT--
+array(2) {
+  [0]=>
+  string(1) "b"
+  [1]=>
+  string(1) "b"
+}
+bool(false)
+array(2) {
+  [0]=>
+  string(1) "b"
+  [1]=>
+  string(1) "b"
+}
+int(12)
@@ -0,0 +1,48 @@
+--TEST--
+Test bracket notation with a backslash inside a quoted name
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "a\\b" => "value",
+    "c\\" => "other",
+    "items" => [["k" => "x\\y"], ["k" => "x"]],
+];
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+var_dump($jsonPath->find($data, "$['a\\b']"));
+
+echo "Assertion 2\n";
+var_dump($jsonPath->find($data, '$["a\b"]'));
+
+echo "Assertion 3\n";
+var_dump($jsonPath->find($data, "$['c\\']"));
+
+echo "Assertion 4\n";
+var_dump($jsonPath->find($data, "$.items[?(@.k == 'x\\y')].k"));
+?>
+--EXPECT--
+Assertion 1
+array(1) {
+  [0]=>
+  string(5) "value"
+}
+Assertion 2
+array(1) {
+  [0]=>
+  string(5) "value"
+}
+Assertion 3
+array(1) {
+  [0]=>
+  string(5) "other"
+}
+Assertion 4
+array(1) {
+  [0]=>
+  string(3) "x\y"
+}
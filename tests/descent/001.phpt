@@ -0,0 +1,93 @@
+--TEST--
+Test recursive descent on deep, wide and cyclic documents
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+
+function deep(int $levels): array {
+    $node = ["name" => "leaf"];
+    for ($i = $levels - 1; $i >= 0; $i--) {
+        $node = ["name" => $i, "child" => $node, "scalars" => [1, 2, 3]];
+    }
+    return $node;
+}
+
+function deepObject(int $levels): stdClass {
+    $node = (object)["name" => "leaf"];
+    for ($i = $levels - 1; $i >= 0; $i--) {
+        $node = (object)["name" => $i, "child" => $node, "scalars" => [1, 2, 3]];
+    }
+    return $node;
+}
+
+echo "Assertion 1\n";
+$data = deep(10000);
+$names = $jsonPath->find($data, '$..name');
+var_dump(count($names), $names[0], $names[9999], $names[10000]);
+var_dump(count($jsonPath->find($data, '$..child')));
+var_dump(count($jsonPath->find($data, '$..scalars[1]')));
+/* every object may have other parents, so each one is looked up among the containers being descended into */
+$object = deepObject(10000);
+$names = $jsonPath->find($object, '$..name');
+var_dump(count($names), $names[9999], $names[10000]);
+var_dump(count($jsonPath->find($object, '$..child..name', 20000)));
+
+echo "Assertion 2\n";
+$data = deep(100);
+echo json_encode($jsonPath->find($data, '$..name', 3)), "\n";
+echo json_encode($jsonPath->find($data, '$..child.name', 2)), "\n";
+var_dump($jsonPath->findPaths($data, '$..name')[40] === "\$" . str_repeat("['child']", 40) . "['name']");
+var_dump($jsonPath->exists($data, '$..child[?(@.name == 99)]'));
+
+echo "Assertion 3\n";
+$data = ["items" => array_fill(0, 1000, ["id" => 1, "tags" => ["x"]])];
+var_dump(count($jsonPath->find($data, '$..id')));
+var_dump(count($jsonPath->find($data, '$..*')));
+
+echo "Assertion 4\n";
+$data = deep(50);
+$data["child"]["child"]["loop"] = &$data;
+var_dump(count($jsonPath->find($data, '$..name')));
+$object = json_decode(json_encode(deep(50)));
+$object->child->child->loop = $object;
+var_dump(count($jsonPath->find($object, '$..name')));
+/* a descent started by another one stops at the containers of both, as the iterator's does */
+var_dump(count($jsonPath->find($object, '$..child..name')));
+var_dump(iterator_count($jsonPath->iterate($object, '$..child..name')));
+
+echo "Assertion 5\n";
+$data = ["a" => ["name" => 1, "b" => ["name" => 2]], "c" => ["name" => 3]];
+echo json_encode($jsonPath->find($data, '$..name')), "\n";
+echo json_encode($jsonPath->find($data, '$..b..name')), "\n";
+?>
+--EXPECT--
+Assertion 1
+int(10001)
+int(0)
+int(9999)
+string(4) "leaf"
+int(10000)
+int(10000)
+int(10001)
+int(9999)
+string(4) "leaf"
+int(20000)
+Assertion 2
+[0,1,2]
+[1,2]
+bool(true)
+bool(true)
+Assertion 3
+int(1000)
+int(4001)
+Assertion 4
+int(51)
+int(51)
+int(1275)
+int(1275)
+Assertion 5
+[1,2,3]
+[2]
@@ -0,0 +1,35 @@
+--TEST--
+Test a $..path operand of a filter applied by a recursive descent sees the whole document
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$json = '{
+    "items": [{"id": "a", "price": 10}, {"id": "b", "price": 5}],
+    "nested": {"id": "n", "price": 10, "deeper": {"limits": {"max": 10}}}
+}';
+
+$jsonPath = new JsonPath();
+
+/* $..max starts a descent of its own from the root while the outer descent is inside the document */
+foreach ([json_decode($json, true), json_decode($json)] as $data) {
+    $result = $jsonPath->find($data, '$..[?(@.price == $..max)]');
+    echo json_encode(array_map(function ($item) {
+        return ((array) $item)["id"];
+    }, $result)), "\n";
+
+    echo json_encode(iterator_to_array($jsonPath->iterate($data, '$..[?(@.price == $..max)].id'), false)), "\n";
+}
+
+/* the containers being descended into can be walked by anything else meanwhile */
+$data = json_decode($json, true);
+$data["nested"]["deeper"]["self"] = &$data;
+echo json_encode($jsonPath->find($data, '$..[?(@.price == $..max)].id')), "\n";
+?>
+--EXPECT--
+["n","a"]
+["n","a"]
+["n","a"]
+["n","a"]
+["n","a"]
@@ -0,0 +1,62 @@
+--TEST--
+Test exists() stops at the first match without copying anything
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "store" => [
+        "book" => [
+            ["author" => "Nigel Rees", "price" => 8.95, "isbn" => null],
+            ["author" => "Evelyn Waugh", "price" => 12.99],
+        ],
+        "bicycle" => ["color" => "red", "price" => 19.95],
+    ],
+];
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+var_dump($jsonPath->exists($data, '$.store.bicycle.color'));
+var_dump($jsonPath->exists($data, '$.store.bicycle.size'));
+
+echo "Assertion 2\n";
+var_dump($jsonPath->exists($data, '$..price'));
+var_dump($jsonPath->exists($data, '$..weight'));
+
+echo "Assertion 3\n";
+var_dump($jsonPath->exists($data, '$.store.book[?(@.price > 10)]'));
+var_dump($jsonPath->exists($data, '$.store.book[?(@.price > 100)]'));
+
+echo "Assertion 4\n";
+var_dump($jsonPath->exists($data, '$.store.book[0].isbn'));
+
+echo "Assertion 5\n";
+$object = json_decode(json_encode($data));
+var_dump($jsonPath->exists($object, '$.store.book[1].author'));
+
+echo "Assertion 6\n";
+$jsonPath->exists($data, '$..author');
+$before = memory_get_usage();
+for ($i = 0; $i < 1000; $i++) {
+    $jsonPath->exists($data, '$..author');
+}
+var_dump(memory_get_usage() - $before);
+?>
+--EXPECT--
+Assertion 1
+bool(true)
+bool(false)
+Assertion 2
+bool(true)
+bool(false)
+Assertion 3
+bool(true)
+bool(false)
+Assertion 4
+bool(true)
+Assertion 5
+bool(true)
+Assertion 6
+int(0)
@@ -0,0 +1,88 @@
+--TEST--
+Test the plans described by JsonPath::explain()
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--INI--
+jsonpath.cache_size=256
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+
+$plan = $jsonPath->explain('$.items[?(@.name =~ "/m 99/" && @.price < $.limits.max)].name');
+
+echo $plan["expression"], "\n";
+var_dump($plan["cached"]);
+
+foreach ($plan["segments"] as $segment) {
+    echo $segment["type"], " ", $segment["segment"], "\n";
+}
+
+/* the cheaper comparison runs first, and the $-rooted operand once per evaluation */
+$filter = $plan["segments"][1];
+echo "prologue: {$filter["prologue"]}, registers: {$filter["registers"]}\n";
+
+foreach ($filter["program"] as $i => $op) {
+    echo $i, ": ", json_encode($op, JSON_UNESCAPED_SLASHES), "\n";
+}
+
+$expressions = [
+    '$..price',
+    '$.store.book[0,2]',
+    '$.list[-2:]',
+    '$.list[::3]',
+    "\$['odd key'].0",
+    '$..*',
+    '$.items[?(!(@.a == 1.5 || @.b) && @.c != null)]',
+];
+
+foreach ($expressions as $expression) {
+    echo $expression, "\n";
+    foreach ($jsonPath->explain($expression)["segments"] as $segment) {
+        unset($segment["program"]);
+        echo "  ", json_encode($segment, JSON_UNESCAPED_SLASHES), "\n";
+    }
+}
+
+try {
+    $jsonPath->explain('$.items[');
+} catch (RuntimeException $e) {
+    echo get_class($e), "\n";
+}
+?>
+--EXPECT--
+$.items[?(@.name =~ "/m 99/" && @.price < $.limits.max)].name
+bool(true)
+selector .items
+filter [?(@.name =~ '/m 99/' && @.price < $.limits.max)]
+selector .name
+prologue: 1, registers: 2
+0: {"op":"root","dst":1,"path":"$.limits.max","lookup":"path"}
+1: {"op":"cur","dst":0,"path":"@.price","lookup":"key"}
+2: {"op":"lt","dst":0,"lhs":0,"rhs":1}
+3: {"op":"jmp_false","dst":0,"target":6}
+4: {"op":"cur","dst":0,"path":"@.name","lookup":"key"}
+5: {"op":"match","dst":0,"lhs":0,"pattern":"/m 99/","literal":"m 99","exact":true}
+$..price
+  {"segment":"..","type":"descent","lookup":"key"}
+  {"segment":".price","type":"selector","key":"price","lookup":"key"}
+$.store.book[0,2]
+  {"segment":".store","type":"selector","key":"store","lookup":"key"}
+  {"segment":".book","type":"selector","key":"book","lookup":"key"}
+  {"segment":"[0,2]","type":"index","indexes":[0,2]}
+$.list[-2:]
+  {"segment":".list","type":"selector","key":"list","lookup":"key"}
+  {"segment":"[-2:]","type":"slice","start":-2,"end":null,"step":null}
+$.list[::3]
+  {"segment":".list","type":"selector","key":"list","lookup":"key"}
+  {"segment":"[::3]","type":"slice","start":null,"end":null,"step":3}
+$['odd key'].0
+  {"segment":"['odd key']","type":"selector","key":"odd key","lookup":"key"}
+  {"segment":".0","type":"selector","key":"0","lookup":"index"}
+$..*
+  {"segment":"..","type":"descent","lookup":"segment"}
+  {"segment":"[*]","type":"wildcard"}
+$.items[?(!(@.a == 1.5 || @.b) && @.c != null)]
+  {"segment":".items","type":"selector","key":"items","lookup":"key"}
+  {"segment":"[?(!(@.a == 1.5 || @.b) && @.c != null)]","type":"filter","expression":"!(@.a == 1.5 || @.b) && @.c != null","registers":2,"prologue":0}
+RuntimeException
@@ -0,0 +1,70 @@
+--TEST--
+Test the per-segment counters reported by JsonPath::profile()
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+
+function show(array $profile): void
+{
+    echo $profile["expression"], ": ", $profile["matches"], " matches\n";
+
+    $time = 0;
+    foreach ($profile["segments"] as $segment) {
+        printf("  %-26s visits=%d candidates=%d matches=%d", $segment["segment"], $segment["visits"],
+            $segment["candidates"], $segment["matches"]);
+        if ($segment["type"] === "filter") {
+            printf(" evaluations=%d pass_rate=%s", $segment["evaluations"], var_export($segment["pass_rate"], true));
+        }
+        echo "\n";
+        $time += $segment["time_ns"];
+    }
+
+    /* the time of a segment doesn't include the segments after it */
+    var_dump($time <= $profile["time_ns"]);
+}
+
+$data = ["items" => [], "limits" => ["max" => 50]];
+for ($i = 0; $i < 10; $i++) {
+    $data["items"][] = ["id" => $i, "price" => $i * 10];
+}
+
+show($jsonPath->profile($data, '$.items[?(@.price < $.limits.max)].id'));
+show($jsonPath->profile($data, '$.items[?(@.price > 1000)].id'));
+show($jsonPath->profile($data, '$.items[?(@.id == 3 || @.id == 5)]'));
+show($jsonPath->profile($data, '$.items[2:6].id'));
+
+$data = ["a" => ["price" => 1], "b" => [["price" => 2], ["x" => 3]]];
+
+show($jsonPath->profile($data, '$..price'));
+show($jsonPath->profile($data, '$.*'));
+?>
+--EXPECT--
+$.items[?(@.price < $.limits.max)].id: 5 matches
+  .items                     visits=1 candidates=1 matches=1
+  [?(@.price < $.limits.max)] visits=1 candidates=10 matches=5 evaluations=10 pass_rate=0.5
+  .id                        visits=5 candidates=5 matches=5
+bool(true)
+$.items[?(@.price > 1000)].id: 0 matches
+  .items                     visits=1 candidates=1 matches=1
+  [?(@.price > 1000)]        visits=1 candidates=10 matches=0 evaluations=10 pass_rate=0.0
+  .id                        visits=0 candidates=0 matches=0
+bool(true)
+$.items[?(@.id == 3 || @.id == 5)]: 2 matches
+  .items                     visits=1 candidates=1 matches=1
+  [?(@.id == 3 || @.id == 5)] visits=1 candidates=10 matches=2 evaluations=10 pass_rate=0.2
+bool(true)
+$.items[2:6].id: 4 matches
+  .items                     visits=1 candidates=1 matches=1
+  [2:6]                      visits=1 candidates=4 matches=4
+  .id                        visits=4 candidates=4 matches=4
+bool(true)
+$..price: 2 matches
+  ..                         visits=1 candidates=5 matches=0
+  .price                     visits=5 candidates=5 matches=2
+bool(true)
+$.*: 2 matches
+  [*]                        visits=1 candidates=2 matches=2
+bool(true)
@@ -0,0 +1,51 @@
+--TEST--
+Test compiled filter expressions
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "items" => [
+        ["id" => 1, "status" => "active", "name" => "alpha", "tags" => [["v" => "x"]]],
+        ["id" => 2, "status" => "inactive", "name" => "beta"],
+        ["id" => 3, "status" => "active", "name" => 42],
+        ["id" => 4, "name" => "gamma", "tags" => []],
+    ],
+    "limits" => ["max" => 3],
+];
+
+$jsonPath = new JsonPath();
+
+$queries = [
+    '$.items[?(@.status == "active")]',
+    '$.items[?(@.status != "active")]',
+    '$.items[?(!@.status && @.name)]',
+    '$.items[?(@.name && !(@.id > 1))]',
+    '$.items[?(@.id < $.limits.max)]',
+    '$.items[?(@.name =~ "/a/")]',
+    '$.items[?(@.tags[?(@.v == "x")])]',
+    '$.items[?(@.id == 1 || (@.id == 2 || (@.id == 3 || (@.id == 5 || (@.id == 6 || (@.id == 7 || (@.id == 8 || (@.id == 9 || @.id == 10))))))))]',
+];
+
+foreach ($queries as $query) {
+    $result = $jsonPath->find($data, $query);
+    echo $query, " => ", json_encode($result === false ? false : array_column($result, "id")), "\n";
+}
+
+/* the compiled filter is copied along with the plan */
+$query = $jsonPath->compile('$.items[?(@.status == "active" && @.id > 1)]');
+echo json_encode(array_column($query->find($data), "id")), "\n";
+echo json_encode(array_column($query->find($data), "id")), "\n";
+?>
+--EXPECT--
+$.items[?(@.status == "active")] => [1,3]
+$.items[?(@.status != "active")] => [2,4]
+$.items[?(!@.status && @.name)] => [4]
+$.items[?(@.name && !(@.id > 1))] => [1]
+$.items[?(@.id < $.limits.max)] => [1,2]
+$.items[?(@.name =~ "/a/")] => [1,2,4]
+$.items[?(@.tags[?(@.v == "x")])] => [1]
+$.items[?(@.id == 1 || (@.id == 2 || (@.id == 3 || (@.id == 5 || (@.id == 6 || (@.id == 7 || (@.id == 8 || (@.id == 9 || @.id == 10))))))))] => [1,2,3]
+[3]
+[3]
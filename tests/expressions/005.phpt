@@ -0,0 +1,57 @@
+--TEST--
+Test short-circuit evaluation and reordering of && and || operands
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "items" => [
+        ["id" => 1, "name" => "alpha", "price" => 5],
+        ["id" => 2, "name" => "beta", "price" => 15, "flag" => true],
+        ["id" => 3, "name" => "gamma", "price" => 25],
+        ["id" => 4, "price" => 35, "flag" => false],
+    ],
+    "limits" => ["max" => 20],
+    "bad" => "invalid",
+];
+
+$jsonPath = new JsonPath();
+
+$queries = [
+    /* the regex runs last, and only if the other operand doesn't decide the result */
+    '$.items[?(@.name =~ "/^a/" && @.id == 99)]',
+    '$.items[?(@.id == 99 && @.name =~ "/^a/")]',
+    '$.items[?(@.name =~ "/^a/" || @.id > 0)]',
+    /* the pattern is only known at run time and isn't valid, it must never run since the other operand decides */
+    /* the result: any warning fails the test */
+    '$.items[?(@.id == 99 && @.name =~ $.bad)]',
+    '$.items[?(@.id > 0 || @.name =~ $.bad)]',
+    '$.items[?(@.id == 1 || @.price > 30 || @.id == 99 && @.name =~ $.bad)]',
+    /* operands are reordered by cost, the result must not change */
+    '$.items[?(@.price < $.limits.max && @.name =~ "/a$/" && @.name && @.id != 3)]',
+    '$.items[?(@.price > $.limits.max || @.name == "alpha" || @.flag)]',
+    '$.items[?(@.name =~ "/^b/" || (@.price > 30 && !@.name))]',
+    '$.items[?(@.flag == true || @.flag == false && @.price > 30)]',
+    '$.items[?(!(@.name && @.price < 20) && @.id < 4)]',
+    '$.items[?(true && @.id == 1 || false)]',
+];
+
+foreach ($queries as $query) {
+    $result = $jsonPath->find($data, $query);
+    echo $query, " => ", json_encode($result === false ? false : array_column($result, "id")), "\n";
+}
+?>
+--EXPECT--
+$.items[?(@.name =~ "/^a/" && @.id == 99)] => false
+$.items[?(@.id == 99 && @.name =~ "/^a/")] => false
+$.items[?(@.name =~ "/^a/" || @.id > 0)] => [1,2,3,4]
+$.items[?(@.id == 99 && @.name =~ $.bad)] => false
+$.items[?(@.id > 0 || @.name =~ $.bad)] => [1,2,3,4]
+$.items[?(@.id == 1 || @.price > 30 || @.id == 99 && @.name =~ $.bad)] => [1,4]
+$.items[?(@.price < $.limits.max && @.name =~ "/a$/" && @.name && @.id != 3)] => [1,2]
+$.items[?(@.price > $.limits.max || @.name == "alpha" || @.flag)] => [1,2,3,4]
+$.items[?(@.name =~ "/^b/" || (@.price > 30 && !@.name))] => [2,4]
+$.items[?(@.flag == true || @.flag == false && @.price > 30)] => [2,4]
+$.items[?(!(@.name && @.price < 20) && @.id < 4)] => [3]
+$.items[?(true && @.id == 1 || false)] => [1]
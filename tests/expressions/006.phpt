@@ -0,0 +1,56 @@
+--TEST--
+Test filters with $-rooted operands
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "limits" => ["min" => 10, "max" => 30, "enabled" => true, "disabled" => false],
+    "items" => [
+        ["id" => 1, "price" => 5, "parts" => [["price" => 40]]],
+        ["id" => 2, "price" => 15, "parts" => [["price" => 20]]],
+        ["id" => 3, "price" => 25, "parts" => []],
+        ["id" => 4, "price" => 35],
+    ],
+];
+
+$jsonPath = new JsonPath();
+
+$queries = [
+    '$.items[?(@.price < $.limits.max)]',
+    '$.items[?(@.price > $.limits.min && @.price < $.limits.max)]',
+    '$.items[?(@.price < $.limits.min || @.price > $.limits.max)]',
+    '$.items[?($.limits.min < @.price && $.limits.min > 0)]',
+    '$.items[?(@.price < $.limits.missing)]',
+    '$.items[?($.limits.enabled && @.price > 30)]',
+    '$.items[?($.limits.disabled || @.id == 1)]',
+    '$.items[?(!$.limits.disabled && @.id == 2)]',
+    '$.items[?(@.parts[?(@.price > $.limits.max)])]',
+    '$..[?(@.price > $.limits.max)]',
+];
+
+foreach ($queries as $query) {
+    $result = $jsonPath->find($data, $query);
+    echo $query, " => ", json_encode($result === false ? false : array_column($result, "price")), "\n";
+}
+
+/* the root is the document the query is evaluated against */
+$query = $jsonPath->compile('$.items[?(@.price < $.limits.max)]');
+echo json_encode(array_column($query->find($data), "id")), "\n";
+$data["limits"]["max"] = 20;
+echo json_encode(array_column($query->find($data), "id")), "\n";
+?>
+--EXPECT--
+$.items[?(@.price < $.limits.max)] => [5,15,25]
+$.items[?(@.price > $.limits.min && @.price < $.limits.max)] => [15,25]
+$.items[?(@.price < $.limits.min || @.price > $.limits.max)] => [5,35]
+$.items[?($.limits.min < @.price && $.limits.min > 0)] => [15,25,35]
+$.items[?(@.price < $.limits.missing)] => false
+$.items[?($.limits.enabled && @.price > 30)] => [35]
+$.items[?($.limits.disabled || @.id == 1)] => [5]
+$.items[?(!$.limits.disabled && @.id == 2)] => [15]
+$.items[?(@.parts[?(@.price > $.limits.max)])] => [5]
+$..[?(@.price > $.limits.max)] => [35,40]
+[1,2,3]
+[1,2]
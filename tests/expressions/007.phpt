@@ -0,0 +1,48 @@
+--TEST--
+Test operands matching a pattern only known at run time are not reordered, so they warn as written
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "items" => [
+        ["id" => 1, "name" => "alpha", "price" => 5],
+        ["id" => 2, "name" => "beta", "price" => 15],
+        ["id" => 3, "name" => "gamma", "price" => 25],
+        ["id" => 4, "price" => 35],
+    ],
+    "bad" => "invalid",
+];
+
+$warnings = 0;
+set_error_handler(function () use (&$warnings) {
+    $warnings++;
+    return true;
+});
+
+$jsonPath = new JsonPath();
+
+$queries = [
+    /* the invalid pattern warns for each element it is matched against, cheaper operands written after it run after it */
+    '$.items[?(@.name =~ $.bad && @.id == 99)]',
+    '$.items[?(@.id == 99 && @.name =~ $.bad)]',
+    '$.items[?(@.name =~ $.bad || @.id > 0)]',
+    '$.items[?(@.id > 0 || @.name =~ $.bad)]',
+    '$.items[?(@.name =~ "/^[ab]/" && @.name =~ $.bad && @.id > 0)]',
+    '$.items[?((@.id == 1 || @.name =~ $.bad) && @.price < 20)]',
+];
+
+foreach ($queries as $query) {
+    $warnings = 0;
+    $result = $jsonPath->find($data, $query);
+    echo $query, " => ", json_encode($result === false ? false : array_column($result, "id")), ", ", $warnings, " warning(s)\n";
+}
+?>
+--EXPECT--
+$.items[?(@.name =~ $.bad && @.id == 99)] => false, 3 warning(s)
+$.items[?(@.id == 99 && @.name =~ $.bad)] => false, 0 warning(s)
+$.items[?(@.name =~ $.bad || @.id > 0)] => [1,2,3,4], 3 warning(s)
+$.items[?(@.id > 0 || @.name =~ $.bad)] => [1,2,3,4], 0 warning(s)
+$.items[?(@.name =~ "/^[ab]/" && @.name =~ $.bad && @.id > 0)] => false, 2 warning(s)
+$.items[?((@.id == 1 || @.name =~ $.bad) && @.price < 20)] => [1], 2 warning(s)
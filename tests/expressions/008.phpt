@@ -0,0 +1,63 @@
+--TEST--
+Test $-rooted operands that can warn are evaluated for each element, however many containers a filter applies to
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "groups" => [
+        ["items" => [["v" => 1], ["v" => 2]]],
+        ["items" => [["v" => 2], ["v" => 3]]],
+        ["items" => [["v" => 2]]],
+    ],
+    "limits" => ["v" => 2],
+    "conf" => [["p" => "x", "v" => 2]],
+    "bad" => "invalid",
+];
+
+/* the operand $.conf[...] applies a filter with an invalid pattern, each evaluation of the operand warns once. */
+/* it isn't left to the prologue, so it warns for each of the five items, as it would without one. */
+$warnings = 0;
+set_error_handler(function () use (&$warnings) {
+    $warnings++;
+    return true;
+});
+
+$jsonPath = new JsonPath();
+
+$queries = [
+    '$.groups[*].items[?(@.v == $.limits.v)].v',
+    '$.groups[*].items[?(@.v == $.conf[?(@.p =~ $.bad)].v)].v',
+    '$..items[?(@.v == $.conf[?(@.p =~ $.bad)].v || @.v == 3)].v',
+];
+
+foreach ($queries as $query) {
+    $warnings = 0;
+    echo $query, "\n";
+    echo "find: ", json_encode($jsonPath->find($data, $query)), ", ", $warnings, " warning(s)\n";
+    $warnings = 0;
+    echo "iterate: ", json_encode(iterator_to_array($jsonPath->iterate($data, $query), false)), ", ", $warnings, " warning(s)\n";
+}
+
+echo "rewind\n";
+$warnings = 0;
+$iterator = $jsonPath->iterate($data, $queries[1]);
+foreach ($iterator as $value) {
+}
+foreach ($iterator as $value) {
+}
+var_dump($warnings);
+?>
+--EXPECT--
+$.groups[*].items[?(@.v == $.limits.v)].v
+find: [2,2,2], 0 warning(s)
+iterate: [2,2,2], 0 warning(s)
+$.groups[*].items[?(@.v == $.conf[?(@.p =~ $.bad)].v)].v
+find: false, 5 warning(s)
+iterate: [], 5 warning(s)
+$..items[?(@.v == $.conf[?(@.p =~ $.bad)].v || @.v == 3)].v
+find: [3], 5 warning(s)
+iterate: [3], 5 warning(s)
+rewind
+int(10)
@@ -0,0 +1,35 @@
+--TEST--
+Test a $-rooted operand that can warn isn't evaluated when the operands before it decide the filter
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "items" => [["a" => false, "v" => 2], ["a" => false, "v" => 3]],
+    "conf" => [["p" => "x", "v" => 2]],
+    "bad" => "invalid",
+];
+
+/* the operand $.conf[...] applies a filter with an invalid pattern, each evaluation of the operand warns once */
+$warnings = 0;
+set_error_handler(function () use (&$warnings) {
+    $warnings++;
+    return true;
+});
+
+$jsonPath = new JsonPath();
+$query = '$.items[?(@.a == true && @.v == $.conf[?(@.p =~ $.bad)].v)].v';
+
+echo "find: ", json_encode($jsonPath->find($data, $query)), ", ", $warnings, " warning(s)\n";
+$warnings = 0;
+echo "iterate: ", json_encode(iterator_to_array($jsonPath->iterate($data, $query), false)), ", ", $warnings, " warning(s)\n";
+
+$data["items"][1]["a"] = true;
+$warnings = 0;
+echo "find: ", json_encode($jsonPath->find($data, $query)), ", ", $warnings, " warning(s)\n";
+?>
+--EXPECT--
+find: false, 0 warning(s)
+iterate: [], 0 warning(s)
+find: false, 1 warning(s)
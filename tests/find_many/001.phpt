@@ -0,0 +1,101 @@
+--TEST--
+Test findMany() returns what find() returns for each expression
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "store" => [
+        "book" => [
+            ["category" => "reference", "author" => "Nigel Rees", "title" => "Sayings of the Century", "price" => 8.95],
+            ["category" => "fiction", "author" => "Evelyn Waugh", "title" => "Sword of Honour", "price" => 12.99],
+            ["category" => "fiction", "author" => "Herman Melville", "title" => "Moby Dick", "isbn" => "0-553-21311-3", "price" => 8.99],
+            ["category" => "fiction", "author" => "J. R. R. Tolkien", "title" => "The Lord of the Rings", "isbn" => "0-395-19395-8", "price" => 22.99],
+        ],
+        "bicycle" => ["color" => "red", "price" => 19.95],
+    ],
+    "expensive" => 10,
+    "nested" => ["a" => ["a" => ["a" => 1]]],
+];
+
+$expressions = [
+    '$.store.book[*].title',
+    '$.store.book[*].price',
+    '$.store.bicycle.color',
+    '$.store.book[*]',
+    '$.store',
+    '$..author',
+    '$..price',
+    '$..book[0,1]',
+    '$..book[-1:]',
+    '$..book[::-1].title',
+    '$..book[?(@.isbn)].title',
+    '$..book[?(@.price < 10)].title',
+    '$..book[?(@.price > $.expensive)].title',
+    '$..book[?(@.price > $.expensive)].price',
+    '$..book[?(@.price>$.expensive)].price',
+    '$..*',
+    '$..a',
+    '$..a..a',
+    '$.nested..a',
+    '$.store.missing',
+    '$.store.book[*].title',
+];
+
+$jsonPath = new JsonPath();
+
+function check($jsonPath, $data, $expressions) {
+    $results = $jsonPath->findMany($data, $expressions);
+    var_dump(array_keys($results) === array_keys($expressions));
+    foreach ($expressions as $key => $expression) {
+        echo $expression, ": ", $results[$key] === $jsonPath->find($data, $expression) ? "ok" : "mismatch", "\n";
+    }
+}
+
+echo "Assertion 1\n";
+check($jsonPath, $data, $expressions);
+
+echo "Assertion 2\n";
+check($jsonPath, json_decode(json_encode($data)), ['$..author', '$.store.book[1:3].title', '$.store.book[1:3].price', '$..*']);
+
+echo "Assertion 3\n";
+$cyclic = ["name" => "root", "children" => [["name" => "child"]]];
+$cyclic["children"][0]["parent"] = &$cyclic;
+check($jsonPath, $cyclic, ['$..name', '$..children[*].name', '$..children[*]..name']);
+?>
+--EXPECT--
+Assertion 1
+bool(true)
+$.store.book[*].title: ok
+$.store.book[*].price: ok
+$.store.bicycle.color: ok
+$.store.book[*]: ok
+$.store: ok
+$..author: ok
+$..price: ok
+$..book[0,1]: ok
+$..book[-1:]: ok
+$..book[::-1].title: ok
+$..book[?(@.isbn)].title: ok
+$..book[?(@.price < 10)].title: ok
+$..book[?(@.price > $.expensive)].title: ok
+$..book[?(@.price > $.expensive)].price: ok
+$..book[?(@.price>$.expensive)].price: ok
+$..*: ok
+$..a: ok
+$..a..a: ok
+$.nested..a: ok
+$.store.missing: ok
+$.store.book[*].title: ok
+Assertion 2
+bool(true)
+$..author: ok
+$.store.book[1:3].title: ok
+$.store.book[1:3].price: ok
+$..*: ok
+Assertion 3
+bool(true)
+$..name: ok
+$..children[*].name: ok
+$..children[*]..name: ok
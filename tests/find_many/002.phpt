@@ -0,0 +1,48 @@
+--TEST--
+Test findMany() keys, errors and plans evicted from the cache while fetching
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--INI--
+jsonpath.cache_size=2
+--FILE--
+<?php
+
+$data = ["a" => ["b" => 1, "c" => 2], "d" => [3, 4]];
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+echo json_encode($jsonPath->findMany($data, ["first" => '$.a.b', 7 => '$.a.c', "third" => '$.d[*]', "none" => '$.x'])), "\n";
+
+echo "Assertion 2\n";
+echo json_encode($jsonPath->findMany($data, ['$.a.b', '$.a.c', '$.a.*', '$.d[0]', '$.d[1]', '$..*'])), "\n";
+
+echo "Assertion 3\n";
+var_dump($jsonPath->findMany($data, []));
+
+echo "Assertion 4\n";
+try {
+    $jsonPath->findMany($data, ['$.a', 42]);
+} catch (TypeError $e) {
+    echo get_class($e), "\n";
+}
+
+echo "Assertion 5\n";
+try {
+    $jsonPath->findMany($data, ['$.a', '$.a[?()]']);
+} catch (RuntimeException $e) {
+    echo get_class($e), ": ", $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+Assertion 1
+{"first":[1],"7":[2],"third":[3,4],"none":false}
+Assertion 2
+[[1],[2],[1,2],[3],[4],[{"b":1,"c":2},[3,4],1,2,3,4]]
+Assertion 3
+array(0) {
+}
+Assertion 4
+TypeError
+Assertion 5
+RuntimeException: Filter expressions may not be empty.
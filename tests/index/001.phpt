@@ -0,0 +1,90 @@
+--TEST--
+Test equality filters answered by JsonPathIndex
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "items" => [
+        ["id" => 1, "name" => "a", "tags" => ["x", "y"]],
+        ["id" => 2, "name" => "b"],
+        ["id" => "2", "name" => "c"],
+        ["id" => 2.0, "name" => "d"],
+        ["id" => true, "name" => "e"],
+        ["id" => null, "name" => "f"],
+        ["name" => "g"],
+        ["id" => [1], "name" => "h"],
+        ["id" => 1, "name" => "i", "tags" => ["z"]],
+        ["id" => -0.0, "name" => "j"],
+    ],
+    "other" => [["id" => 1, "name" => "k"]],
+];
+
+$jsonPath = new JsonPath();
+$index = new JsonPathIndex($data, '$.items[*]', '@.id');
+
+$queries = [
+    '$.items[?(@.id == 1)]',
+    '$.items[?(@.id == "2")]',
+    '$.items[?(2 == @.id)]',
+    '$.items[?(@.id == 2.0)]',
+    '$.items[?(@.id == 0.0)]',
+    '$.items[?(@.id == true)]',
+    '$.items[?(@.id == null)]',
+    '$.items[?(@.id == 3)]',
+    '$.items[?(@.id == 1)].tags[*]',
+    '$.items[?(@.id == 1)].name',
+    /* not answered by the index */
+    '$.items[?(@.id != 1)].name',
+    '$.items[?(@.id == 1 && @.name == "i")].name',
+    '$.other[?(@.id == 1)].name',
+    '$.items[0].name',
+];
+
+foreach ($queries as $query) {
+    $result = $index->find($query);
+    $names = $result === false || !isset($result[0]["name"]) ? $result : array_column($result, "name");
+    echo $query, " => ", json_encode($names), $result === $jsonPath->find($data, $query) ? "" : " (differs from find())", "\n";
+}
+
+echo json_encode($index->find('$.items[?(@.id == 1)]', 1)), "\n";
+
+echo json_encode(array_column($index->get(1), "name")), "\n";
+echo json_encode(array_column($index->get("2"), "name")), "\n";
+var_dump($index->get(3));
+var_dump($index->get([1]));
+
+/* the index keeps the document it was built with */
+$data["items"][1]["id"] = 3;
+echo json_encode(array_column($index->find('$.items[?(@.id == 2)]'), "name")), "\n";
+
+/* nested keys, and objects */
+$data = json_decode('{"users": {"u1": {"profile": {"email": "a@example.com"}}, "u2": {"profile": {"email": "b@example.com"}}}}');
+$index = new JsonPathIndex($data, '$.users.*', '@.profile.email');
+echo json_encode($index->find('$.users[?(@.profile.email == "b@example.com")]')), "\n";
+echo json_encode($index->find('$.users[?(@.profile.email == "c@example.com")]')), "\n";
+?>
+--EXPECT--
+$.items[?(@.id == 1)] => ["a","i"]
+$.items[?(@.id == "2")] => ["c"]
+$.items[?(2 == @.id)] => ["b"]
+$.items[?(@.id == 2.0)] => ["d"]
+$.items[?(@.id == 0.0)] => ["j"]
+$.items[?(@.id == true)] => ["e"]
+$.items[?(@.id == null)] => ["f"]
+$.items[?(@.id == 3)] => false
+$.items[?(@.id == 1)].tags[*] => ["x","y","z"]
+$.items[?(@.id == 1)].name => ["a","i"]
+$.items[?(@.id != 1)].name => ["b","c","d","e","f","g","h","j"]
+$.items[?(@.id == 1 && @.name == "i")].name => ["i"]
+$.other[?(@.id == 1)].name => ["k"]
+$.items[0].name => ["a"]
+[{"id":1,"name":"a","tags":["x","y"]}]
+["a","i"]
+["c"]
+bool(false)
+bool(false)
+["b"]
+[{"profile":{"email":"b@example.com"}}]
+false
@@ -0,0 +1,41 @@
+--TEST--
+Test JsonPathIndex argument errors
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = ["items" => [["id" => 1, "tags" => [1, 2]]]];
+
+foreach (['@', 'id', '$.id', '@.tags[*]', '@..id', '@.tags[0]'] as $key) {
+    try {
+        new JsonPathIndex($data, '$.items[*]', $key);
+        echo $key, " => ok\n";
+    } catch (ValueError | InvalidArgumentException $e) {
+        echo $key, " => ", $e->getMessage(), "\n";
+    }
+}
+
+try {
+    new JsonPathIndex($data, '$.items[', '@.id');
+} catch (RuntimeException $e) {
+    echo get_class($e), "\n";
+}
+
+$index = new JsonPathIndex($data, '$.items[*]', '@.id');
+
+try {
+    $index->find('$.items[?(@.id == 1)]', -1);
+} catch (ValueError | InvalidArgumentException $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECTF--
+@ => %Skey%S must be a path of member names starting with @, e.g. @.id
+id => %Skey%S must be a path of member names starting with @, e.g. @.id
+$.id => %Skey%S must be a path of member names starting with @, e.g. @.id
+@.tags[*] => %Skey%S must be a path of member names starting with @, e.g. @.id
+@..id => %Skey%S must be a path of member names starting with @, e.g. @.id
+@.tags[0] => %Skey%S must be a path of member names starting with @, e.g. @.id
+RuntimeException
+%Slimit%S must be greater than or equal to 0
@@ -0,0 +1,47 @@
+--TEST--
+Test JsonPathIndex over objects, and an index stored in the document it indexes
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+class Catalog
+{
+    public $items;
+    public $index;
+
+    public function __destruct()
+    {
+        echo "destroyed\n";
+    }
+}
+
+echo "Assertion 1\n";
+$catalog = new Catalog();
+$catalog->items = json_decode('[{"id": 1, "name": "a"}, {"id": 2, "name": "b"}]');
+$catalog->index = new JsonPathIndex($catalog, '$.items[*]', '@.id');
+var_dump(count($catalog->index->get(1)));
+unset($catalog);
+var_dump(gc_collect_cycles() > 0);
+
+echo "Assertion 2\n";
+/* objects are shared with the caller, the index only sees changes to their keys once it's constructed again */
+$catalog = json_decode('{"items": [{"id": 1, "name": "a"}, {"id": 2, "name": "b"}]}');
+$index = new JsonPathIndex($catalog, '$.items[*]', '@.id');
+$catalog->items[0]->id = 3;
+echo json_encode($index->find('$.items[?(@.id == 1)].name')), "\n";
+echo json_encode($index->find('$.items[?(@.id == 3)].name')), "\n";
+$index = new JsonPathIndex($catalog, '$.items[*]', '@.id');
+echo json_encode($index->find('$.items[?(@.id == 1)].name')), "\n";
+echo json_encode($index->find('$.items[?(@.id == 3)].name')), "\n";
+?>
+--EXPECT--
+Assertion 1
+int(1)
+destroyed
+bool(true)
+Assertion 2
+["a"]
+false
+false
+["a"]
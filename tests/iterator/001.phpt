@@ -0,0 +1,110 @@
+--TEST--
+Test iterate() produces the same matches in the same order as find()
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "store" => [
+        "book" => [
+            ["category" => "reference", "author" => "Nigel Rees", "title" => "Sayings of the Century", "price" => 8.95],
+            ["category" => "fiction", "author" => "Evelyn Waugh", "title" => "Sword of Honour", "price" => 12.99],
+            ["category" => "fiction", "author" => "Herman Melville", "title" => "Moby Dick", "isbn" => "0-553-21311-3", "price" => 8.99],
+            ["category" => "fiction", "author" => "J. R. R. Tolkien", "title" => "The Lord of the Rings", "isbn" => "0-395-19395-8", "price" => 22.99],
+        ],
+        "bicycle" => ["color" => "red", "price" => 19.95, "gears" => [1, 2, 3]],
+    ],
+    "expensive" => 10,
+    "nested" => ["a" => ["a" => ["a" => 1]]],
+];
+
+$expressions = [
+    '$',
+    '$.store',
+    '$.store.book[*].author',
+    '$..author',
+    '$.store.*',
+    '$.store..price',
+    '$..book[2]',
+    '$..book[-1]',
+    '$..book[0,1]',
+    '$..book[3,0,-2].title',
+    '$..book[:2]',
+    '$..book[1:]',
+    '$..book[::-1].price',
+    '$..book[-3:-1]',
+    '$..book[::2]',
+    '$..book[?(@.isbn)]',
+    '$..book[?(@.price < 10)].title',
+    '$..book[?(@.price > $.expensive)].title',
+    '$..*',
+    '$..a',
+    '$..a..a',
+    '$.nested..a',
+    '$..gears[*]',
+    '$.store.bicycle.missing',
+    '$..missing',
+];
+
+$jsonPath = new JsonPath();
+
+function check($jsonPath, $data, $expression) {
+    $expected = $jsonPath->find($data, $expression);
+    $actual = iterator_to_array($jsonPath->iterate($data, $expression));
+    echo $expression, ": ", $actual === ($expected === false ? [] : $expected) ? "ok" : "mismatch " . json_encode($actual), "\n";
+}
+
+echo "Assertion 1\n";
+foreach ($expressions as $expression) {
+    check($jsonPath, $data, $expression);
+}
+
+echo "Assertion 2\n";
+$object = json_decode(json_encode($data));
+foreach (['$..author', '$.store.book[1:3].title', '$..book[?(@.price > $.expensive)].title', '$..*'] as $expression) {
+    check($jsonPath, $object, $expression);
+}
+
+echo "Assertion 3\n";
+$cyclic = ["name" => "root", "children" => [["name" => "child"]]];
+$cyclic["children"][0]["parent"] = &$cyclic;
+foreach (['$..name', '$..children[*].name'] as $expression) {
+    check($jsonPath, $cyclic, $expression);
+}
+?>
+--EXPECT--
+Assertion 1
+$: ok
+$.store: ok
+$.store.book[*].author: ok
+$..author: ok
+$.store.*: ok
+$.store..price: ok
+$..book[2]: ok
+$..book[-1]: ok
+$..book[0,1]: ok
+$..book[3,0,-2].title: ok
+$..book[:2]: ok
+$..book[1:]: ok
+$..book[::-1].price: ok
+$..book[-3:-1]: ok
+$..book[::2]: ok
+$..book[?(@.isbn)]: ok
+$..book[?(@.price < 10)].title: ok
+$..book[?(@.price > $.expensive)].title: ok
+$..*: ok
+$..a: ok
+$..a..a: ok
+$.nested..a: ok
+$..gears[*]: ok
+$.store.bicycle.missing: ok
+$..missing: ok
+Assertion 2
+$..author: ok
+$.store.book[1:3].title: ok
+$..book[?(@.price > $.expensive)].title: ok
+$..*: ok
+Assertion 3
+$..name: ok
+$..children[*].name: ok
@@ -0,0 +1,86 @@
+--TEST--
+Test iterate() suspends the evaluation between matches
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+$data = ["items" => []];
+for ($i = 0; $i < 100000; $i++) {
+    $data["items"][] = ["id" => $i, "tags" => ["a", "b"]];
+}
+$before = memory_get_usage();
+$count = 0;
+$sum = 0;
+foreach ($jsonPath->iterate($data, '$.items[*].id') as $id) {
+    $count++;
+    $sum += $id;
+}
+var_dump($count, $sum);
+var_dump(memory_get_usage() - $before < 4096);
+
+echo "Assertion 2\n";
+$iterator = $jsonPath->iterate($data, '$..id');
+foreach ($iterator as $key => $id) {
+    if ($key === 2) {
+        break;
+    }
+}
+var_dump($key, $id, $iterator->current());
+$iterator->next();
+var_dump($iterator->key(), $iterator->current());
+
+echo "Assertion 3\n";
+$data = ["a" => [1, 2, 3], "b" => [4, 5]];
+$iterator = $jsonPath->iterate($data, '$.*[*]');
+var_dump($iterator->valid(), $iterator->key(), $iterator->current());
+foreach ($iterator as $value) {
+    $data["a"][] = 99;
+    unset($data["b"]);
+}
+var_dump($value);
+echo json_encode(iterator_to_array($iterator)), "\n";
+
+echo "Assertion 4\n";
+$iterator = $jsonPath->iterate(["a" => 1], '$.b');
+var_dump($iterator->valid(), $iterator->key(), $iterator->current());
+$iterator->next();
+var_dump($iterator->valid());
+
+echo "Assertion 5\n";
+$data = ["a" => ["b" => 1], "c" => ["b" => 2]];
+$iterator = $jsonPath->iterate($data, '$..b');
+echo json_encode(iterator_to_array($iterator)), "\n";
+echo json_encode(iterator_to_array($iterator)), "\n";
+unset($data);
+echo json_encode(iterator_to_array($iterator)), "\n";
+?>
+--EXPECT--
+Assertion 1
+int(100000)
+int(4999950000)
+bool(true)
+Assertion 2
+int(2)
+int(2)
+int(2)
+int(3)
+int(3)
+Assertion 3
+bool(true)
+int(0)
+int(1)
+int(5)
+[1,2,3,4,5]
+Assertion 4
+bool(false)
+NULL
+NULL
+bool(false)
+Assertion 5
+[1,2]
+[1,2]
+[1,2]
@@ -0,0 +1,61 @@
+--TEST--
+Test iterating a compiled query and the JsonPathIterator class
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = ["store" => ["book" => [["price" => 8.95], ["price" => 12.99], ["price" => 8.99]]]];
+
+$jsonPath = new JsonPath();
+$query = $jsonPath->compile('$.store.book[?(@.price < 10)].price');
+
+echo "Assertion 1\n";
+$iterator = $query->iterate($data);
+var_dump($iterator instanceof Iterator);
+unset($query);
+foreach ($iterator as $key => $price) {
+    echo $key, " => ", $price, "\n";
+}
+
+echo "Assertion 2\n";
+$object = json_decode('{"a": {"b": 1}, "c": [{"b": 2}]}');
+foreach ($jsonPath->iterate($object, '$..b') as $value) {
+    var_dump($value);
+}
+
+echo "Assertion 3\n";
+try {
+    new JsonPathIterator();
+} catch (Error $e) {
+    echo get_class($e), ": ", $e->getMessage(), "\n";
+}
+
+echo "Assertion 4\n";
+try {
+    clone $iterator;
+} catch (Error $e) {
+    echo get_class($e), ": ", $e->getMessage(), "\n";
+}
+
+echo "Assertion 5\n";
+try {
+    $jsonPath->iterate($data, '$.store.book[?()]');
+} catch (RuntimeException $e) {
+    echo get_class($e), ": ", $e->getMessage(), "\n";
+}
+?>
+--EXPECTF--
+Assertion 1
+bool(true)
+0 => 8.95
+1 => 8.99
+Assertion 2
+int(1)
+int(2)
+Assertion 3
+Error: Call to private JsonPathIterator::__construct() from %s
+Assertion 4
+Error: Trying to clone an uncloneable object of class JsonPathIterator
+Assertion 5
+RuntimeException: Filter expressions may not be empty.
@@ -0,0 +1,53 @@
+--TEST--
+Test an iterator stored in the document it iterates is collected
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+class Document
+{
+    public $items = [["id" => 1], ["id" => 2]];
+    public $iterator;
+
+    public function __destruct()
+    {
+        echo "destroyed\n";
+    }
+}
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+$document = new Document();
+$document->iterator = $jsonPath->iterate($document, '$..id');
+$document->iterator->rewind();
+var_dump($document->iterator->current());
+unset($document);
+var_dump(gc_collect_cycles() > 0);
+
+echo "Assertion 2\n";
+$document = new Document();
+$document->iterator = $jsonPath->iterate($document, '$.items[*]');
+unset($document);
+var_dump(gc_collect_cycles() > 0);
+
+echo "Assertion 3\n";
+$document = new Document();
+$document->iterator = $jsonPath->iterate($document, '$.items[*]');
+foreach ($document->iterator as $item) {
+}
+unset($document);
+var_dump(gc_collect_cycles() > 0);
+?>
+--EXPECT--
+Assertion 1
+int(1)
+destroyed
+bool(true)
+Assertion 2
+destroyed
+bool(true)
+Assertion 3
+destroyed
+bool(true)
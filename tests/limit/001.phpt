@@ -0,0 +1,82 @@
+--TEST--
+Test limiting the number of matches
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "store" => [
+        "book" => [
+            ["author" => "Nigel Rees", "price" => 8.95],
+            ["author" => "Evelyn Waugh", "price" => 12.99],
+            ["author" => "Herman Melville", "price" => 8.99],
+            ["author" => "J. R. R. Tolkien", "price" => 22.99],
+        ],
+        "bicycle" => ["price" => 19.95],
+    ],
+];
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+echo json_encode($jsonPath->find($data, '$.store.book[*].author', 2)), "\n";
+
+echo "Assertion 2\n";
+echo json_encode($jsonPath->find($data, '$..price', 3)), "\n";
+
+echo "Assertion 3\n";
+echo json_encode($jsonPath->find($data, '$.store.book[?(@.price < 20)].author', 1)), "\n";
+
+echo "Assertion 4\n";
+echo json_encode($jsonPath->find($data, '$.store.book[3,0,1].author', 2)), "\n";
+
+echo "Assertion 5\n";
+echo json_encode($jsonPath->find($data, '$.store.book[::-1].price', 2)), "\n";
+
+echo "Assertion 6\n";
+echo json_encode($jsonPath->find($data, '$..price', 0)), "\n";
+echo json_encode($jsonPath->find($data, '$..price', 100)), "\n";
+
+echo "Assertion 7\n";
+var_dump($jsonPath->find($data, '$..isbn', 5));
+
+echo "Assertion 8\n";
+$query = $jsonPath->compile('$..author');
+echo json_encode($query->find($data, 1)), "\n";
+echo json_encode($query->find($data)), "\n";
+
+echo "Assertion 9\n";
+try {
+    $jsonPath->find($data, '$..price', -1);
+} catch (ValueError | InvalidArgumentException $e) {
+    echo $e->getMessage(), "\n";
+}
+try {
+    $query->find($data, -1);
+} catch (ValueError | InvalidArgumentException $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECTF--
+Assertion 1
+["Nigel Rees","Evelyn Waugh"]
+Assertion 2
+[8.95,12.99,8.99]
+Assertion 3
+["Nigel Rees"]
+Assertion 4
+["J. R. R. Tolkien","Nigel Rees"]
+Assertion 5
+[22.99,8.99]
+Assertion 6
+[8.95,12.99,8.99,22.99,19.95]
+[8.95,12.99,8.99,22.99,19.95]
+Assertion 7
+bool(false)
+Assertion 8
+["Nigel Rees"]
+["Nigel Rees","Evelyn Waugh","Herman Melville","J. R. R. Tolkien"]
+Assertion 9
+%Slimit%S must be greater than or equal to 0
+%Slimit%S must be greater than or equal to 0
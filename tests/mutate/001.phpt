@@ -0,0 +1,82 @@
+--TEST--
+Test set() replaces every match in place
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "store" => [
+        "book" => [
+            ["title" => "Sayings of the Century", "price" => 8.95],
+            ["title" => "Sword of Honour", "price" => 12.99],
+        ],
+        "bicycle" => ["color" => "red", "price" => 19.95],
+    ],
+];
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+var_dump($jsonPath->set($data, '$..price', 0));
+echo json_encode($data), "\n";
+
+echo "Assertion 2\n";
+var_dump($jsonPath->set($data, '$.store.book[?(@.title == "Sword of Honour")].price', 10));
+var_dump($jsonPath->set($data, '$.store.bicycle', ["color" => "blue"]));
+echo json_encode($data), "\n";
+
+echo "Assertion 3\n";
+var_dump($jsonPath->set($data, '$.store.missing', 1));
+var_dump($jsonPath->set($data, '$.store.book[5].price', 1));
+echo json_encode($data), "\n";
+
+echo "Assertion 4\n";
+$copy = $data;
+var_dump($jsonPath->set($data, '$.store.book[0].title', "Moby Dick"));
+echo $data["store"]["book"][0]["title"], "\n";
+echo $copy["store"]["book"][0]["title"], "\n";
+
+echo "Assertion 5\n";
+$price = &$data["store"]["book"][1]["price"];
+var_dump($jsonPath->set($data, '$.store.book[1].price', 11));
+var_dump($price);
+
+echo "Assertion 6\n";
+$data = ["object" => (object) ["a" => 1, "b" => [1, 2]]];
+var_dump($jsonPath->set($data, '$.object.a', 2));
+var_dump($jsonPath->set($data, '$.object.b[1]', 3));
+echo json_encode($data), "\n";
+
+echo "Assertion 7\n";
+$query = $jsonPath->compile('$[*].enabled');
+$data = [["enabled" => false], ["enabled" => false], ["name" => "x"]];
+var_dump($query->set($data, true));
+echo json_encode($data), "\n";
+?>
+--EXPECT--
+Assertion 1
+int(3)
+{"store":{"book":[{"title":"Sayings of the Century","price":0},{"title":"Sword of Honour","price":0}],"bicycle":{"color":"red","price":0}}}
+Assertion 2
+int(1)
+int(1)
+{"store":{"book":[{"title":"Sayings of the Century","price":0},{"title":"Sword of Honour","price":10}],"bicycle":{"color":"blue"}}}
+Assertion 3
+int(0)
+int(0)
+{"store":{"book":[{"title":"Sayings of the Century","price":0},{"title":"Sword of Honour","price":10}],"bicycle":{"color":"blue"}}}
+Assertion 4
+int(1)
+Moby Dick
+Sayings of the Century
+Assertion 5
+int(1)
+int(11)
+Assertion 6
+int(1)
+int(1)
+{"object":{"a":2,"b":[1,3]}}
+Assertion 7
+int(2)
+[{"enabled":true},{"enabled":true},{"name":"x"}]
@@ -0,0 +1,75 @@
+--TEST--
+Test update() replaces every match with the result of a callback
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "store" => [
+        "book" => [
+            ["title" => "Sayings of the Century", "price" => 8.95],
+            ["title" => "Sword of Honour", "price" => 12.99],
+        ],
+        "bicycle" => ["color" => "red", "price" => 19.95],
+    ],
+];
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+var_dump($jsonPath->update($data, '$..price', fn($price) => $price * 2));
+echo json_encode($data), "\n";
+
+echo "Assertion 2\n";
+var_dump($jsonPath->update($data, '$.store.book[?(@.price > 20)].title', 'strtoupper'));
+echo json_encode($data["store"]["book"]), "\n";
+
+echo "Assertion 3\n";
+$nested = ["a" => ["b" => ["b" => 1]]];
+var_dump($jsonPath->update($nested, '$..b', fn($value) => is_array($value) ? ["wrapped" => $value] : $value + 1));
+echo json_encode($nested), "\n";
+
+echo "Assertion 4\n";
+$list = ["list" => [1, 2, 3]];
+try {
+    $jsonPath->update($list, '$.list[*]', function ($value) {
+        if ($value === 2) {
+            throw new Exception("stop");
+        }
+        return $value * 10;
+    });
+} catch (Exception $e) {
+    echo $e->getMessage(), "\n";
+}
+echo json_encode($list), "\n";
+
+echo "Assertion 5\n";
+$copy = $data;
+$query = $jsonPath->compile('$.store.bicycle.color');
+var_dump($query->update($data, fn($color) => "blue"));
+echo $data["store"]["bicycle"]["color"], "\n";
+echo $copy["store"]["bicycle"]["color"], "\n";
+
+echo "Assertion 6\n";
+var_dump($jsonPath->update($data, '$..missing', fn($value) => 1));
+?>
+--EXPECT--
+Assertion 1
+int(3)
+{"store":{"book":[{"title":"Sayings of the Century","price":17.9},{"title":"Sword of Honour","price":25.98}],"bicycle":{"color":"red","price":39.9}}}
+Assertion 2
+int(1)
+[{"title":"Sayings of the Century","price":17.9},{"title":"SWORD OF HONOUR","price":25.98}]
+Assertion 3
+int(2)
+{"a":{"b":{"wrapped":{"b":2}}}}
+Assertion 4
+stop
+{"list":[1,2,30]}
+Assertion 5
+int(1)
+blue
+red
+Assertion 6
+int(0)
@@ -0,0 +1,78 @@
+--TEST--
+Test delete() removes every match and only separates the arrays leading to them
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+$data = ["book" => [["price" => 8.95], ["price" => 12.99]], "bicycle" => ["price" => 19.95, "color" => "red"]];
+var_dump($jsonPath->delete($data, '$..price'));
+echo json_encode($data), "\n";
+
+echo "Assertion 2\n";
+$data = ["list" => ["a", "b", "c"]];
+var_dump($jsonPath->delete($data, '$.list[0]'));
+var_dump($data);
+
+echo "Assertion 3\n";
+$data = ["a" => ["b" => 1], "c" => 2];
+var_dump($jsonPath->delete($data, '$..*'));
+var_dump($data);
+
+echo "Assertion 4\n";
+$data = ["object" => (object) ["x" => 1, "y" => 2]];
+var_dump($jsonPath->delete($data, '$.object.x'));
+echo json_encode($data), "\n";
+
+echo "Assertion 5\n";
+$data = ["payload" => range(1, 100000), "meta" => ["version" => 1, "tags" => ["a"]]];
+$copy = $data;
+$before = memory_get_usage();
+var_dump($jsonPath->delete($data, '$.meta.version'));
+var_dump(memory_get_usage() - $before < 4096);
+echo json_encode($data["meta"]), "\n";
+echo json_encode($copy["meta"]), "\n";
+
+echo "Assertion 6\n";
+$query = $jsonPath->compile('$.meta');
+var_dump($query->delete($data));
+var_dump(array_keys($data));
+var_dump($query->delete($data));
+?>
+--EXPECT--
+Assertion 1
+int(3)
+{"book":[[],[]],"bicycle":{"color":"red"}}
+Assertion 2
+int(1)
+array(1) {
+  ["list"]=>
+  array(2) {
+    [1]=>
+    string(1) "b"
+    [2]=>
+    string(1) "c"
+  }
+}
+Assertion 3
+int(3)
+array(0) {
+}
+Assertion 4
+int(1)
+{"object":{"y":2}}
+Assertion 5
+int(1)
+bool(true)
+{"tags":["a"]}
+{"version":1,"tags":["a"]}
+Assertion 6
+int(1)
+array(1) {
+  [0]=>
+  string(7) "payload"
+}
+int(0)
@@ -0,0 +1,59 @@
+--TEST--
+Test set() and delete() keep writing every match when a destructor evicts the cached query
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--INI--
+jsonpath.cache_size=2
+--FILE--
+<?php
+
+/* overwriting or deleting a value runs its destructor, which evicts the query being written */
+class Evictor
+{
+    public static $destructed = 0;
+
+    public function __destruct()
+    {
+        self::$destructed++;
+        $jsonPath = new JsonPath();
+        $jsonPath->find(["x" => 1], '$.x');
+        $jsonPath->find(["y" => 2], '$.y');
+        $jsonPath->find(["z" => 3], '$.z');
+    }
+}
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+$data = ["items" => [["value" => new Evictor()], ["value" => new Evictor()], ["value" => new Evictor()]]];
+var_dump($jsonPath->set($data, '$.items[*].value', "new"));
+var_dump(Evictor::$destructed);
+echo json_encode($data), "\n";
+
+echo "Assertion 2\n";
+Evictor::$destructed = 0;
+$data = ["items" => [["value" => new Evictor(), "keep" => 1], ["value" => new Evictor(), "keep" => 2]]];
+var_dump($jsonPath->delete($data, '$.items[*].value'));
+var_dump(Evictor::$destructed);
+echo json_encode($data), "\n";
+
+echo "Assertion 3\n";
+Evictor::$destructed = 0;
+$data = ["items" => [["value" => new Evictor()], ["value" => new Evictor()]]];
+var_dump($jsonPath->set($data, '$.items[*].value', "new"));
+var_dump($jsonPath->set($data, '$.items[*].value', "newer"));
+echo json_encode($data), "\n";
+?>
+--EXPECT--
+Assertion 1
+int(3)
+int(3)
+{"items":[{"value":"new"},{"value":"new"},{"value":"new"}]}
+Assertion 2
+int(2)
+int(2)
+{"items":[{"keep":1},{"keep":2}]}
+Assertion 3
+int(2)
+int(2)
+{"items":[{"value":"newer"},{"value":"newer"}]}
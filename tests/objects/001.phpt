@@ -0,0 +1,63 @@
+--TEST--
+Test querying objects decoded by json_decode() without the associative flag
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = json_decode('{
+    "store": {
+        "book": [
+            {"category": "reference", "author": "Nigel Rees", "price": 8.95},
+            {"category": "fiction", "author": "Evelyn Waugh", "price": 12.99},
+            {"category": "fiction", "author": "Herman Melville", "isbn": "0-553-21311-3", "price": 8.99}
+        ],
+        "bicycle": {"color": "red", "price": 19.95},
+        "1": "numeric key"
+    }
+}');
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+echo json_encode($jsonPath->find($data, '$.store.book[*].author')), "\n";
+
+echo "Assertion 2\n";
+echo json_encode($jsonPath->find($data, '$..price')), "\n";
+
+echo "Assertion 3\n";
+echo json_encode($jsonPath->find($data, '$.store.book[?(@.price < 10)].author')), "\n";
+
+echo "Assertion 4\n";
+echo json_encode($jsonPath->find($data, '$.store.book[-1:]')), "\n";
+
+echo "Assertion 5\n";
+echo json_encode($jsonPath->find($data, '$.store.bicycle.*')), "\n";
+
+echo "Assertion 6\n";
+echo json_encode($jsonPath->find($data, '$.store.1')), "\n";
+
+echo "Assertion 7\n";
+echo json_encode($jsonPath->find($data, '$..book[?(@.isbn)].isbn')), "\n";
+
+echo "Assertion 8\n";
+$result = $jsonPath->find($data, '$.store.bicycle');
+var_dump($result[0] === $data->store->bicycle);
+?>
+--EXPECT--
+Assertion 1
+["Nigel Rees","Evelyn Waugh","Herman Melville"]
+Assertion 2
+[8.95,12.99,8.99,19.95]
+Assertion 3
+["Nigel Rees","Herman Melville"]
+Assertion 4
+[{"category":"fiction","author":"Herman Melville","isbn":"0-553-21311-3","price":8.99}]
+Assertion 5
+["red",19.95]
+Assertion 6
+["numeric key"]
+Assertion 7
+["0-553-21311-3"]
+Assertion 8
+bool(true)
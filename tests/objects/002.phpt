@@ -0,0 +1,64 @@
+--TEST--
+Test querying declared, typed, dynamic and non-public object properties
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+#[AllowDynamicProperties]
+class Item
+{
+    public $name;
+    public int $count = 0;
+    public ?Item $child = null;
+    public int $uninitialized;
+    protected $secret = "protected";
+    private $hidden = "private";
+
+    public function __construct(string $name, int $count)
+    {
+        $this->name = $name;
+        $this->count = $count;
+    }
+}
+
+$root = new Item("root", 1);
+$root->child = new Item("child", 2);
+$root->child->child = new Item("grandchild", 3);
+$root->dynamic = "dynamic";
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+echo json_encode($jsonPath->find($root, '$.child.child.name')), "\n";
+
+echo "Assertion 2\n";
+echo json_encode($jsonPath->find($root, '$..count')), "\n";
+
+echo "Assertion 3\n";
+var_dump($jsonPath->find($root, '$.secret'), $jsonPath->find($root, '$.hidden'), $jsonPath->find($root, '$.uninitialized'));
+
+echo "Assertion 4\n";
+echo json_encode($jsonPath->find($root, '$.*')), "\n";
+
+echo "Assertion 5\n";
+echo json_encode($jsonPath->find($root, '$..[?(@.count > 1)].name')), "\n";
+
+echo "Assertion 6\n";
+echo json_encode($jsonPath->find(["items" => [$root->child]], '$.items[0].name')), "\n";
+?>
+--EXPECT--
+Assertion 1
+["grandchild"]
+Assertion 2
+[1,2,3]
+Assertion 3
+bool(false)
+bool(false)
+bool(false)
+Assertion 4
+["root",1,{"name":"child","count":2,"child":{"name":"grandchild","count":3,"child":null}},"dynamic"]
+Assertion 5
+["child","grandchild"]
+Assertion 6
+["child"]
@@ -0,0 +1,28 @@
+--TEST--
+Test recursive descent terminates on cyclic object graphs and arrays with references
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$a = new stdClass();
+$a->name = "a";
+$b = new stdClass();
+$b->name = "b";
+$a->next = $b;
+$b->next = $a;
+
+$jsonPath = new JsonPath();
+
+echo json_encode($jsonPath->find($a, '$..name')), "\n";
+
+$array = ["name" => "array"];
+$array["self"] = &$array;
+
+echo json_encode($jsonPath->find($array, '$..name')), "\n";
+echo json_encode($jsonPath->find($array, '$.self.self.name')), "\n";
+?>
+--EXPECT--
+["a","b"]
+["array"]
+["array"]
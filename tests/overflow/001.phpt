@@ -1,5 +1,5 @@
 --TEST--
-Ensure selector name string length does not exceed buffer
+Test selector names and string literals longer than 50 characters
 --SKIPIF--
 <?php if (!extension_loaded("jsonpath")) print "skip"; ?>
 --FILE--
@@ -7,10 +7,25 @@ Ensure selector name string length does not exceed buffer
 
 $jsonPath = new JsonPath();
 
-var_dump($jsonPath->find([], '$.test[?(@.aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa == "true")]'));
+$key = str_repeat("a", 140);
+$value = str_repeat("b", 100);
+
+$data = ["test" => [[$key => "true"], [$key => $value], ["other" => "true"]]];
+
+var_dump($jsonPath->find([], '$.test[?(@.' . $key . ' == "true")]'));
+var_dump($jsonPath->find($data, '$.test[?(@.' . $key . ' == "true")]'));
+var_dump($jsonPath->find($data, '$.test[?(@["' . $key . '"] == "' . $value . '")].' . $key));
+?>
 --EXPECTF--
-Fatal error: Uncaught RuntimeException: String exceeded buffer size at position 61 in %s
-Stack trace:
-%s
-%s
-%s
\ No newline at end of file
+bool(false)
+array(1) {
+  [0]=>
+  array(1) {
+    ["%s"]=>
+    string(4) "true"
+  }
+}
+array(1) {
+  [0]=>
+  string(100) "%s"
+}
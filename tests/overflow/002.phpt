@@ -1,5 +1,5 @@
 --TEST--
-Ensure queries that contain more than PARSE_BUF_LEN tokens safely fail
+Test queries that contain more than 50 tokens
 --SKIPIF--
 <?php if (!extension_loaded("jsonpath")) print "skip"; ?>
 --FILE--
@@ -7,11 +7,24 @@ Ensure queries that contain more than PARSE_BUF_LEN tokens safely fail
 
 $jsonPath = new JsonPath();
 
-try {
-    // This query contains 51 tokens (root selector $ plus 50 dot selectors), which exceeds PARSE_BUF_LEN
-    var_dump($jsonPath->find([], '$.1.2.3.4.5.6.7.8.9.10.11.12.13.14.15.16.17.18.19.20.21.22.23.24.25.26.27.28.29.30.31.32.33.34.35.36.37.38.39.40.41.42.43.44.45.46.47.48.49.50'));
-} catch(RuntimeException $e) {
-    echo get_class($e) . ": " . $e->getMessage();
+// The query contains 51 tokens (root selector $ plus 50 dot selectors)
+$data = "found";
+for ($i = 50; $i >= 1; $i--) {
+    $data = [$i => $data];
 }
+
+var_dump($jsonPath->find($data, '$.1.2.3.4.5.6.7.8.9.10.11.12.13.14.15.16.17.18.19.20.21.22.23.24.25.26.27.28.29.30.31.32.33.34.35.36.37.38.39.40.41.42.43.44.45.46.47.48.49.50'));
+
+// A union of 200 indexes
+$data = range(0, 299);
+$result = $jsonPath->find($data, '$[' . implode(',', range(100, 299)) . ']');
+var_dump(count($result), $result[0], $result[199]);
+?>
 --EXPECT--
-RuntimeException: The query is too long. Token count exceeds PARSE_BUF_LEN.
\ No newline at end of file
+array(1) {
+  [0]=>
+  string(5) "found"
+}
+int(200)
+int(100)
+int(299)
@@ -0,0 +1,17 @@
+--TEST--
+Test index lists with more than ten indexes
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+
+$data = range(0, 20);
+
+echo json_encode($jsonPath->find($data, '$[0,1,2,3,4,5,6,7,8,9,10,11,12,-1]')), "\n";
+echo json_encode($jsonPath->compile('$[12,11,10,9,8,7,6,5,4,3,2,1,0]')->find($data)), "\n";
+?>
+--EXPECT--
+[0,1,2,3,4,5,6,7,8,9,10,11,12,20]
+[12,11,10,9,8,7,6,5,4,3,2,1,0]
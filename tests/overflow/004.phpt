@@ -0,0 +1,24 @@
+--TEST--
+Test slice and index values beyond the 32-bit integer range
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+<?php if (PHP_INT_SIZE != 8) die("skip this test is for 64-bit platforms only"); ?>
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+
+$data = ["a", "b", "c", "d"];
+
+echo json_encode($jsonPath->find($data, '$[0:9223372036854775807:9223372036854775807]')), "\n";
+echo json_encode($jsonPath->find($data, '$[-9223372036854775807:2]')), "\n";
+echo json_encode($jsonPath->find($data, '$[::-9223372036854775807]')), "\n";
+echo json_encode($jsonPath->find($data, '$[1:4294967296]')), "\n";
+var_dump($jsonPath->find($data, '$[4294967296,-4294967296]'));
+?>
+--EXPECT--
+["a"]
+["a","b"]
+["d"]
+["b","c","d"]
+bool(false)
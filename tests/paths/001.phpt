@@ -0,0 +1,102 @@
+--TEST--
+Test findPaths() returns the normalized paths of the matches
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "store" => [
+        "book" => [
+            ["category" => "reference", "author" => "Nigel Rees", "price" => 8.95],
+            ["category" => "fiction", "author" => "Evelyn Waugh", "price" => 12.99],
+            ["category" => "fiction", "author" => "Herman Melville", "isbn" => "0-553-21311-3", "price" => 8.99],
+            ["category" => "fiction", "author" => "J. R. R. Tolkien", "isbn" => "0-395-19395-8", "price" => 22.99],
+        ],
+        "bicycle" => ["color" => "red", "price" => 19.95],
+    ],
+    "expensive" => 10,
+];
+
+$jsonPath = new JsonPath();
+
+function dump($paths) {
+    echo $paths === false ? "false" : implode("\n", $paths), "\n";
+}
+
+echo "Assertion 1\n";
+dump($jsonPath->findPaths($data, '$.store.book[*].author'));
+
+echo "Assertion 2\n";
+dump($jsonPath->findPaths($data, '$..price'));
+
+echo "Assertion 3\n";
+dump($jsonPath->findPaths($data, '$.store.book[2,0].author'));
+dump($jsonPath->findPaths($data, '$.store.book[-1]'));
+dump($jsonPath->findPaths($data, '$.store.book[::-2].isbn'));
+
+echo "Assertion 4\n";
+dump($jsonPath->findPaths($data, '$.store.book[?(@.price > $.expensive)].author'));
+
+echo "Assertion 5\n";
+dump($jsonPath->findPaths($data, '$..author', 2));
+
+echo "Assertion 6\n";
+$object = json_decode('{"0": {"a": 1}, "b": [{"a": 2}]}');
+dump($jsonPath->findPaths($object, '$..a'));
+dump($jsonPath->findPaths($object, '$[0]'));
+
+echo "Assertion 7\n";
+dump($jsonPath->findPaths(["it's" => ["a\\b" => 1, "line\n" => 2, "\x01" => 3]], '$.*.*'));
+
+echo "Assertion 8\n";
+dump($jsonPath->findPaths($data, '$..weight'));
+
+echo "Assertion 9\n";
+$query = $jsonPath->compile('$..bicycle.color');
+dump($query->findPaths($data));
+dump($query->findPaths($data, 1));
+
+echo "Assertion 10\n";
+$paths = $jsonPath->findPaths($data, '$..book[?(@.isbn)].price');
+$values = $jsonPath->find($data, '$..book[?(@.isbn)].price');
+var_dump(count($paths) === count($values));
+?>
+--EXPECT--
+Assertion 1
+$['store']['book'][0]['author']
+$['store']['book'][1]['author']
+$['store']['book'][2]['author']
+$['store']['book'][3]['author']
+Assertion 2
+$['store']['book'][0]['price']
+$['store']['book'][1]['price']
+$['store']['book'][2]['price']
+$['store']['book'][3]['price']
+$['store']['bicycle']['price']
+Assertion 3
+$['store']['book'][2]['author']
+$['store']['book'][0]['author']
+$['store']['book'][3]
+$['store']['book'][3]['isbn']
+Assertion 4
+$['store']['book'][1]['author']
+$['store']['book'][3]['author']
+Assertion 5
+$['store']['book'][0]['author']
+$['store']['book'][1]['author']
+Assertion 6
+$['0']['a']
+$['b'][0]['a']
+$['0']
+Assertion 7
+$['it\'s']['a\\b']
+$['it\'s']['line\n']
+$['it\'s']['\u0001']
+Assertion 8
+false
+Assertion 9
+$['store']['bicycle']['color']
+$['store']['bicycle']['color']
+Assertion 10
+bool(true)
@@ -0,0 +1,43 @@
+--TEST--
+Test a compiled query can be evaluated against many search targets
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+$query = $jsonPath->compile('$.items[-1].name');
+
+var_dump($query instanceof JsonPathQuery);
+
+$records = [
+    ["items" => [["name" => "a"], ["name" => "b"], ["name" => "c"]]],
+    ["items" => [["name" => "d"]]],
+    ["items" => []],
+    ["items" => [["name" => "e"], ["name" => "f"]]],
+];
+
+foreach ($records as $i => $record) {
+    echo "Record $i\n";
+    var_dump($query->find($record));
+}
+?>
+--EXPECT--
+bool(true)
+Record 0
+array(1) {
+  [0]=>
+  string(1) "c"
+}
+Record 1
+array(1) {
+  [0]=>
+  string(1) "d"
+}
+Record 2
+bool(false)
+Record 3
+array(1) {
+  [0]=>
+  string(1) "f"
+}
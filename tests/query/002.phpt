@@ -0,0 +1,52 @@
+--TEST--
+Test first() and exists() on a compiled query
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "store" => [
+        "book" => [
+            ["author" => "Nigel Rees", "price" => 8.95],
+            ["author" => "Evelyn Waugh", "price" => 12.99],
+            ["author" => "Herman Melville", "price" => 8.99, "isbn" => "0-553-21311-3"],
+        ],
+        "bicycle" => ["price" => 19.95],
+    ],
+];
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+var_dump($jsonPath->compile('$..price')->first($data));
+
+echo "Assertion 2\n";
+var_dump($jsonPath->compile('$.store.book[?(@.price > 10)].author')->first($data));
+
+echo "Assertion 3\n";
+var_dump($jsonPath->compile('$.store.book[?(@.isbn)]')->exists($data));
+
+echo "Assertion 4\n";
+$query = $jsonPath->compile('$.store.book[?(@.price > 100)]');
+var_dump($query->first($data));
+var_dump($query->exists($data));
+
+echo "Assertion 5\n";
+var_dump($jsonPath->compile('$.store.bicycle')->first($data));
+?>
+--EXPECT--
+Assertion 1
+float(8.95)
+Assertion 2
+string(12) "Evelyn Waugh"
+Assertion 3
+bool(true)
+Assertion 4
+NULL
+bool(false)
+Assertion 5
+array(1) {
+  ["price"]=>
+  float(19.95)
+}
@@ -0,0 +1,40 @@
+--TEST--
+Test compiling invalid expressions and misusing JsonPathQuery
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+
+try {
+    $jsonPath->compile('$.book[');
+} catch (RuntimeException $e) {
+    echo get_class($e), ": ", $e->getMessage(), "\n";
+}
+
+try {
+    new JsonPathQuery();
+} catch (Error $e) {
+    echo get_class($e), ": ", $e->getMessage(), "\n";
+}
+
+$query = (new ReflectionClass(JsonPathQuery::class))->newInstanceWithoutConstructor();
+
+try {
+    $query->find([]);
+} catch (Error $e) {
+    echo get_class($e), ": ", $e->getMessage(), "\n";
+}
+
+try {
+    clone $jsonPath->compile('$.a');
+} catch (Error $e) {
+    echo get_class($e), ": ", $e->getMessage(), "\n";
+}
+?>
+--EXPECTF--
+RuntimeException: Missing filter end ]
+Error: Call to private JsonPathQuery::__construct() from %s
+Error: JsonPathQuery must be created with JsonPath::compile()
+Error: Trying to clone an uncloneable object of class JsonPathQuery
@@ -0,0 +1,78 @@
+--TEST--
+Test regex patterns resolved when the query is compiled
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [];
+foreach (["alpha", "Alphabet", "beta.gamma", "x{2}", "ac", "über", "xx", "-\n-", "\x01b", 42] as $n) {
+    $data[] = ["n" => $n];
+}
+
+$jsonPath = new JsonPath();
+
+$patterns = [
+    '/pha/',
+    '/PHA/i',
+    '/^al/',
+    '/a[.]g/',
+    '/a.g/',
+    '/ab?c/',
+    '/x{2}/',
+    '/ph|ga/',
+    '/(al|be)ta/',
+    '/ber/u',
+    '#pha#',
+    '{^a}',
+    '/a$/',
+    '/l+p/',
+    '/^x{2}$/',
+    /* escapes longer than a character aren't literals */
+    '/\x41l/',
+    '/\x{41}l/',
+    '/\101l/',
+    '/\12/',
+    '/\cAb/',
+    '/(x)\g1/',
+    '/(x)\g{-1}/',
+    '/(?<n>x)\k<n>/',
+];
+
+foreach ($patterns as $pattern) {
+    $result = $jsonPath->find($data, '$[?(@.n =~ "' . $pattern . '")]');
+    echo $pattern, " => ", json_encode($result === false ? false : array_column($result, "n"), JSON_UNESCAPED_UNICODE), "\n";
+}
+
+/* the warning of an invalid pattern is raised once, when the query is compiled */
+var_dump($jsonPath->find($data, '$[?(@.n =~ "invalid")]'));
+var_dump($jsonPath->find($data, '$[?(@.n =~ "invalid")]'));
+?>
+--EXPECTF--
+/pha/ => ["alpha","Alphabet"]
+/PHA/i => ["alpha","Alphabet"]
+/^al/ => ["alpha"]
+/a[.]g/ => ["beta.gamma"]
+/a.g/ => ["beta.gamma"]
+/ab?c/ => ["ac"]
+/x{2}/ => ["xx"]
+/ph|ga/ => ["alpha","Alphabet","beta.gamma"]
+/(al|be)ta/ => ["beta.gamma"]
+/ber/u => ["über"]
+#pha# => ["alpha","Alphabet"]
+{^a} => ["alpha","ac"]
+/a$/ => ["alpha","beta.gamma"]
+/l+p/ => ["alpha","Alphabet"]
+/^x{2}$/ => ["xx"]
+/\x41l/ => ["Alphabet"]
+/\x{41}l/ => ["Alphabet"]
+/\101l/ => ["Alphabet"]
+/\12/ => ["-\n-"]
+/\cAb/ => ["\u0001b"]
+/(x)\g1/ => ["xx"]
+/(x)\g{-1}/ => ["xx"]
+/(?<n>x)\k<n>/ => ["xx"]
+
+Warning: %s in %s on line %d
+bool(false)
+bool(false)
@@ -0,0 +1,42 @@
+--TEST--
+Test =~ matches the way preg_match() does, following the pcre.* settings
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--INI--
+pcre.jit=0
+--FILE--
+<?php
+
+$subjects = ["alpha", "Alphabet", "beta.gamma", "über", "\xff\xfe", "a\nb", "ab", ""];
+$data = [];
+foreach ($subjects as $n) {
+    $data[] = ["n" => $n];
+}
+$data[] = ["pattern" => "/^a/m"];
+
+$jsonPath = new JsonPath();
+
+$patterns = ['/pha/', '/pha/A', '/ber/u', '/.+/u', '/^b/m', '/a$/D', '/(*UTF)\xff/', '/b$/', '/^$/'];
+
+foreach ($patterns as $pattern) {
+    $expected = array_values(array_filter($subjects, function ($n) use ($pattern) {
+        return preg_match($pattern, $n) === 1;
+    }));
+    $result = $jsonPath->find($data, '$[?(@.n =~ "' . $pattern . '")].n');
+    echo $pattern, " => ", var_export(($result === false ? [] : $result) === $expected, true), "\n";
+}
+
+$result = $jsonPath->find($data, '$[?(@.n =~ $[8].pattern)].n');
+var_dump($result === array_values(preg_grep("/^a/m", $subjects)));
+?>
+--EXPECT--
+/pha/ => true
+/pha/A => true
+/ber/u => true
+/.+/u => true
+/^b/m => true
+/a$/D => true
+/(*UTF)\xff/ => true
+/b$/ => true
+/^$/ => true
+bool(true)
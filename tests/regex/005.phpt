@@ -0,0 +1,34 @@
+--TEST--
+Test regex literals ending in a quantified multibyte character
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [];
+foreach (["x", "xé", "xe", "xéé", "ab", "aéb", "y"] as $n) {
+    $data[] = ["n" => $n];
+}
+
+$jsonPath = new JsonPath();
+
+/* with u the quantifier applies to the whole character, without it to the last byte only */
+$patterns = ['/xé?/u', '/xé?/', '/xé*/u', '/xé{2}/u', '/aé*b/u', '/aé?b/', '/xé+/u'];
+
+foreach ($patterns as $pattern) {
+    $result = $jsonPath->find($data, '$[?(@.n =~ "' . $pattern . '")]');
+    $result = $result === false ? [] : array_column($result, "n");
+    $expected = array_values(array_filter(array_column($data, "n"), function ($n) use ($pattern) {
+        return preg_match($pattern, $n) === 1;
+    }));
+    echo $pattern, " => ", json_encode($result, JSON_UNESCAPED_UNICODE), $result === $expected ? "" : " (preg_match differs)", "\n";
+}
+?>
+--EXPECT--
+/xé?/u => ["x","xé","xe","xéé"]
+/xé?/ => ["xé","xéé"]
+/xé*/u => ["x","xé","xe","xéé"]
+/xé{2}/u => ["xéé"]
+/aé*b/u => ["ab","aéb"]
+/aé?b/ => ["aéb"]
+/xé+/u => ["xé","xéé"]
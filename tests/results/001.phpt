@@ -0,0 +1,43 @@
+--TEST--
+Test matched values are shared with the search target and separated on write
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = ["payload" => ["a" => 1, "b" => ["c" => 2]]];
+
+$jsonPath = new JsonPath();
+$result = $jsonPath->find($data, '$.payload');
+
+$result[0]["a"] = 100;
+$result[0]["b"]["c"] = 200;
+
+var_dump($data);
+var_dump($result);
+?>
+--EXPECT--
+array(1) {
+  ["payload"]=>
+  array(2) {
+    ["a"]=>
+    int(1)
+    ["b"]=>
+    array(1) {
+      ["c"]=>
+      int(2)
+    }
+  }
+}
+array(1) {
+  [0]=>
+  array(2) {
+    ["a"]=>
+    int(100)
+    ["b"]=>
+    array(1) {
+      ["c"]=>
+      int(200)
+    }
+  }
+}
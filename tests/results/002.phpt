@@ -0,0 +1,24 @@
+--TEST--
+Test returning a large matched subtree does not copy it
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = ["payload" => []];
+for ($i = 0; $i < 100000; $i++) {
+    $data["payload"][] = ["id" => $i];
+}
+
+$jsonPath = new JsonPath();
+
+$before = memory_get_usage();
+$result = $jsonPath->find($data, '$.payload');
+$after = memory_get_usage();
+
+var_dump(count($result[0]));
+var_dump($after - $before < 4096);
+?>
+--EXPECT--
+int(100000)
+bool(true)
@@ -0,0 +1,21 @@
+--TEST--
+Test references in the search target are not returned as references
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$value = ["x" => 1];
+$data = ["a" => &$value];
+
+$jsonPath = new JsonPath();
+$result = $jsonPath->find($data, '$.a');
+
+$result[0]["x"] = 2;
+
+var_dump($value["x"]);
+var_dump($result[0]["x"]);
+?>
+--EXPECT--
+int(1)
+int(2)
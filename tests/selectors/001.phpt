@@ -0,0 +1,31 @@
+--TEST--
+Test numeric and string selector keys are resolved the same way as PHP array keys
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$data = [
+    "1" => "int key",
+    "01" => "string key",
+    "-5" => "negative int key",
+    "1.5" => "float-like string key",
+    "" => "empty key",
+    "key" => "plain key",
+];
+
+$jsonPath = new JsonPath();
+
+foreach (['$.1', '$["1"]', '$["01"]', '$["-5"]', '$["1.5"]', '$[""]', '$.key', '$["KEY"]'] as $path) {
+    echo $path, " => ", json_encode($jsonPath->find($data, $path)), "\n";
+}
+?>
+--EXPECT--
+$.1 => ["int key"]
+$["1"] => ["int key"]
+$["01"] => ["string key"]
+$["-5"] => ["negative int key"]
+$["1.5"] => ["float-like string key"]
+$[""] => ["empty key"]
+$.key => ["plain key"]
+$["KEY"] => false
@@ -0,0 +1,20 @@
+--TEST--
+Test nested selectors in filters against many records
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$records = [];
+for ($i = 0; $i < 1000; $i++) {
+    $records[] = ["id" => $i, "a" => ["b" => ["c" => $i % 250 == 0 ? 1 : 0, "name" => "record $i"]]];
+}
+
+$jsonPath = new JsonPath();
+
+echo json_encode($jsonPath->find($records, '$..[?(@.a.b.c == 1)].id')), "\n";
+echo json_encode($jsonPath->find($records, '$[?(@.a.b.name == "record 999")].id')), "\n";
+?>
+--EXPECT--
+[0,250,500,750]
+[999]
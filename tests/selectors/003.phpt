@@ -0,0 +1,57 @@
+--TEST--
+Test index unions, slices and wildcards on packed arrays, packed arrays with holes and hash arrays
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$holes = [10, 20, 30, 40, 50];
+unset($holes[1], $holes[3]);
+
+$data = [
+    "packed" => [10, 20, 30, 40, 50],
+    "holes" => $holes,
+    "hash" => [4 => "e", 0 => "a", 2 => "c"],
+    "short" => [1, 2],
+];
+
+$jsonPath = new JsonPath();
+
+$paths = [
+    '$.packed[1:4]',
+    '$.packed[::2]',
+    '$.packed[-2:]',
+    '$.packed[0,2,-1]',
+    '$.packed[7]',
+    '$.packed.3',
+    '$.holes[*]',
+    '$.holes[0,2,4]',
+    '$.holes[1]',
+    '$.hash[0,2,4]',
+    '$.hash[*]',
+    /* negative indexes are resolved against each array, the plan is left as it was */
+    '$.*[-1]',
+    '$.*[-1]',
+];
+
+foreach ($paths as $path) {
+    echo $path, " => ", json_encode($jsonPath->find($data, $path)), "\n";
+}
+
+echo implode(" ", $jsonPath->findPaths($data, '$.holes[*]')), "\n";
+?>
+--EXPECT--
+$.packed[1:4] => [20,30,40]
+$.packed[::2] => [10,30,50]
+$.packed[-2:] => [40,50]
+$.packed[0,2,-1] => [10,30,50]
+$.packed[7] => false
+$.packed.3 => [40]
+$.holes[*] => [10,30,50]
+$.holes[0,2,4] => [10,30,50]
+$.holes[1] => false
+$.hash[0,2,4] => ["a","c","e"]
+$.hash[*] => ["e","a","c"]
+$.*[-1] => [50,30,"c",2]
+$.*[-1] => [50,30,"c",2]
+$['holes'][0] $['holes'][2] $['holes'][4]
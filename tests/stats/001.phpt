@@ -0,0 +1,84 @@
+--TEST--
+Test engine counters reported by JsonPath::stats()
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--INI--
+jsonpath.cache_size=256
+--FILE--
+<?php
+
+$data = [
+    "items" => [
+        ["id" => 1, "name" => "alpha"],
+        ["id" => 2, "name" => "beta"],
+        ["id" => 3, "name" => "gamma"],
+    ],
+];
+
+function delta(array $before, array $after): array
+{
+    $delta = [];
+    foreach ($after as $name => $value) {
+        $delta[$name] = $value - $before[$name];
+    }
+    return $delta;
+}
+
+$stats = JsonPath::stats();
+echo json_encode(array_keys($stats)), "\n";
+echo json_encode(array_keys($stats["request"])), "\n";
+var_dump($stats["request"] == $stats["process"]);
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+$before = JsonPath::stats()["request"];
+$jsonPath->find($data, '$.items[?(@.id > 1)].name');
+$d = delta($before, JsonPath::stats()["request"]);
+foreach (["queries_compiled", "queries_executed", "nodes_visited", "hash_lookups", "results_copied", "regex_matches"] as $name) {
+    echo $name, " ", $d[$name], "\n";
+}
+var_dump($d["bytes_copied"] > 0);
+var_dump($d["lex_ns"] >= 0 && $d["parse_ns"] >= 0 && $d["eval_ns"] >= 0);
+
+echo "Assertion 2\n";
+/* the plan comes from the cache the second time */
+$before = JsonPath::stats()["request"];
+$jsonPath->find($data, '$.items[?(@.id > 1)].name');
+$jsonPath->exists($data, '$.items[?(@.id > 1)].name');
+$d = delta($before, JsonPath::stats()["request"]);
+echo "queries_compiled ", $d["queries_compiled"], "\n";
+echo "queries_executed ", $d["queries_executed"], "\n";
+echo "lex_ns ", $d["lex_ns"], "\n";
+
+echo "Assertion 3\n";
+$before = JsonPath::stats()["request"];
+$jsonPath->find($data, '$.items[?(@.name =~ "/^b/")].id');
+$d = delta($before, JsonPath::stats()["request"]);
+echo "regex_matches ", $d["regex_matches"], "\n";
+
+echo "Assertion 4\n";
+$stats = JsonPath::stats();
+var_dump($stats["process"]["queries_executed"] >= $stats["request"]["queries_executed"]);
+?>
+--EXPECT--
+["request","process"]
+["queries_compiled","queries_executed","nodes_visited","hash_lookups","results_copied","bytes_copied","regex_matches","lex_ns","parse_ns","eval_ns"]
+bool(true)
+Assertion 1
+queries_compiled 1
+queries_executed 1
+nodes_visited 6
+hash_lookups 6
+results_copied 2
+regex_matches 0
+bool(true)
+bool(true)
+Assertion 2
+queries_compiled 0
+queries_executed 2
+lex_ns 0
+Assertion 3
+regex_matches 3
+Assertion 4
+bool(true)
@@ -0,0 +1,95 @@
+--TEST--
+Test findInJson() returns the same matches as find() on the decoded document
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$json = <<<JSON
+{ "store": {
+    "book": [
+      { "category": "reference", "author": "Nigel Rees", "title": "Sayings of the Century", "price": 8.95 },
+      { "category": "fiction", "author": "Evelyn Waugh", "title": "Sword of Honour", "price": 12.99 },
+      { "category": "fiction", "author": "Herman Melville", "title": "Moby Dick", "isbn": "0-553-21311-3", "price": 8.99 },
+      { "category": "fiction", "author": "J. R. R. Tolkien", "title": "The Lord of the Rings", "isbn": "0-395-19395-8", "price": 22.99 }
+    ],
+    "bicycle": { "color": "red", "price": 19.95, "tags": [ "fast", { "price": 1 } ] },
+    "0": "zero",
+    "a\\u0062c": "escaped key",
+    "unicode": "\\u00e9t\\u00e9 \\ud83d\\ude00",
+    "numbers": [ 0, -1, 1.5e3, 12345678901234567890, true, false, null, [], {} ]
+  },
+  "expensive": 10
+}
+JSON;
+
+$expressions = [
+    '$.store.book[*].author',
+    '$..author',
+    '$.store.*',
+    '$.store..price',
+    '$..price',
+    '$..book[2]',
+    '$..book[2,0,2]',
+    '$..book[-1]',
+    '$..book[0:2]',
+    '$..book[1:]',
+    '$..book[::2]',
+    '$..book[::-1].title',
+    '$..book[-2:]',
+    '$.store.book[?(@.isbn)].title',
+    '$.store.book[?(@.price < 10)].title',
+    '$.store.book[?(@.price > $.expensive)].title',
+    '$..[?(@.price > 19)]',
+    '$..*',
+    '$.store.0',
+    '$.store[0]',
+    '$.store.abc',
+    '$.store.unicode',
+    '$.store.numbers[*]',
+    '$.store.numbers[3:]',
+    '$.store.bicycle.tags[1].price',
+    '$..tags..price',
+    '$.missing',
+    '$.store.book[9]',
+];
+
+$jsonPath = new JsonPath();
+$data = json_decode($json, true);
+
+foreach ($expressions as $expression) {
+    $expected = $jsonPath->find($data, $expression);
+    $actual = $jsonPath->findInJson($json, $expression);
+
+    if ($expected !== $actual) {
+        echo "Mismatch for $expression\n";
+        var_dump($expected, $actual);
+    }
+}
+
+echo "Assertion 1\n";
+echo json_encode($jsonPath->findInJson($json, '$..price')), "\n";
+
+echo "Assertion 2\n";
+echo json_encode($jsonPath->findInJson($json, '$..book[2,0].author')), "\n";
+
+echo "Assertion 3\n";
+var_dump($jsonPath->findInJson($json, '$.store.abc'));
+
+echo "Assertion 4\n";
+var_dump($jsonPath->findInJson('"scalar"', '$.a'));
+var_dump($jsonPath->findInJson('[]', '$[0]'));
+?>
+--EXPECT--
+Assertion 1
+[8.95,12.99,8.99,22.99,19.95,1]
+Assertion 2
+["Herman Melville","Nigel Rees"]
+Assertion 3
+array(1) {
+  [0]=>
+  string(11) "escaped key"
+}
+Assertion 4
+bool(false)
+bool(false)
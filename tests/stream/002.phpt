@@ -0,0 +1,83 @@
+--TEST--
+Test findInJson() with duplicate keys, deep documents and invalid JSON
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$jsonPath = new JsonPath();
+
+echo "Assertion 1\n";
+// the last value of a duplicate key is kept, in the position of the first one
+$json = '{"a": 1, "b": {"c": 2}, "a": 3}';
+echo json_encode($jsonPath->findInJson($json, '$.a')), "\n";
+echo json_encode($jsonPath->findInJson($json, '$.*')), "\n";
+var_dump($jsonPath->findInJson($json, '$..*') === $jsonPath->find(json_decode($json, true), '$..*'));
+
+echo "Assertion 2\n";
+$json = '{"k0": 0' . implode('', array_map(function ($i) { return ", \"k$i\": $i"; }, range(1, 99))) . ', "k5": "last"}';
+echo json_encode($jsonPath->findInJson($json, '$.k5')), "\n";
+
+echo "Assertion 3\n";
+$json = str_repeat('[', 512) . str_repeat(']', 512);
+var_dump($jsonPath->findInJson($json, '$..x'));
+
+$invalid = [
+    '',
+    '{"a": 1,}',
+    '{"a": 1} x',
+    '[01]',
+    '{"a": "' . "\x01" . '"}',
+    '{"a": "unterminated',
+    '["' . "\xff" . '"]',
+    '["\ud800"]',
+    str_repeat('[', 513) . str_repeat(']', 513),
+];
+
+foreach ($invalid as $i => $json) {
+    echo "Assertion ", $i + 4, "\n";
+    try {
+        $jsonPath->findInJson($json, '$.a');
+    } catch (JsonException $e) {
+        echo get_class($e), ": ", $e->getMessage(), "\n";
+        json_decode($json, true);
+        var_dump($e->getCode() === json_last_error());
+    }
+}
+?>
+--EXPECT--
+Assertion 1
+[3]
+[3,{"c":2}]
+bool(true)
+Assertion 2
+["last"]
+Assertion 3
+bool(false)
+Assertion 4
+JsonException: Syntax error
+bool(true)
+Assertion 5
+JsonException: Syntax error
+bool(true)
+Assertion 6
+JsonException: Syntax error
+bool(true)
+Assertion 7
+JsonException: Syntax error
+bool(true)
+Assertion 8
+JsonException: Control character error, possibly incorrectly encoded
+bool(true)
+Assertion 9
+JsonException: Control character error, possibly incorrectly encoded
+bool(true)
+Assertion 10
+JsonException: Malformed UTF-8 characters, possibly incorrectly encoded
+bool(true)
+Assertion 11
+JsonException: Single unpaired UTF-16 surrogate in unicode escape
+bool(true)
+Assertion 12
+JsonException: Maximum stack depth exceeded
+bool(true)
@@ -0,0 +1,23 @@
+--TEST--
+Test findInJson() on a compiled query
+--SKIPIF--
+<?php if (!extension_loaded("jsonpath")) print "skip"; ?>
+--FILE--
+<?php
+
+$records = [
+    '{"id": 1, "items": [{"sku": "a", "qty": 2}, {"sku": "b", "qty": 0}]}',
+    '{"id": 2, "items": []}',
+    '{"id": 3, "items": [{"sku": "c", "qty": 5}], "note": "x"}',
+];
+
+$query = (new JsonPath())->compile('$.items[?(@.qty > 0)].sku');
+
+foreach ($records as $record) {
+    echo json_encode($query->findInJson($record)), "\n";
+}
+?>
+--EXPECT--
+["a"]
+false
+["c"]